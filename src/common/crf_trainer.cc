@@ -0,0 +1,676 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// crf_trainer.cc --- Created at 2026-10-19
+//
+
+#include "common/crf_trainer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "milkcat/crf_template.h"
+#include "milkcat/darts.h"
+#include "utils/readable_file.h"
+#include "utils/writable_file.h"
+
+namespace milkcat {
+
+namespace {
+
+const int kLineMax = 1024 * 1024;
+
+// Number of corrections kept in L-BFGS
+const int kLBFGSMemory = 5;
+
+// Parameters of the backtracking line search
+const double kArmijo = 1e-4;
+const int kMaxLineSearch = 40;
+
+// Number of iterations the difference of objective should be less than eta
+// before the training stops
+const int kConvergeIteration = 3;
+
+// Removes the trailing spaces and line breaks of str
+void TrimRight(char *str) {
+  int length = strlen(str);
+  while (length > 0 && strchr(" \t\r\n", str[length - 1]) != nullptr) {
+    str[--length] = '\0';
+  }
+}
+
+// Expands templates at position of the sentence cells[0, size * xsize) and
+// calls visit(feature_str) for each feature. Returns false if a template is
+// invalid
+template <class Visit>
+bool ExpandTemplatesAt(const std::vector<std::string> &templates,
+                       const std::string *cells,
+                       int size,
+                       int xsize,
+                       int position,
+                       Visit visit) {
+  std::string feature_str;
+  auto get_feature = [cells, xsize](int position, int column) {
+    return cells[position * xsize + column].c_str();
+  };
+  for (const std::string &template_str : templates) {
+    if (!ApplyCRFTemplate(&feature_str,
+                          template_str.c_str(),
+                          position,
+                          size,
+                          xsize,
+                          get_feature)) {
+      return false;
+    }
+    visit(feature_str);
+  }
+  return true;
+}
+
+inline double LogSumExp(const double *values, int n) {
+  double max_value = *std::max_element(values, values + n);
+  double sum = 0.0;
+  for (int i = 0; i < n; ++i) sum += exp(values[i] - max_value);
+  return max_value + log(sum);
+}
+
+inline double Dot(const std::vector<double> &x, const std::vector<double> &y) {
+  double sum = 0.0;
+  for (size_t i = 0; i < x.size(); ++i) sum += x[i] * y[i];
+  return sum;
+}
+
+}  // namespace
+
+class CRFTrainer::GradientWorker {
+ public:
+  GradientWorker(const CRFTrainer *trainer, int weight_num):
+      trainer_(trainer),
+      tag_num_(trainer->tag_num_),
+      gradient_(weight_num) {
+  }
+
+  // Computes the gradient of sentences [first, sentence_num) with step
+  // stride at weights
+  void Compute(const double *weights, int first, int stride) {
+    std::fill(gradient_.begin(), gradient_.end(), 0.0);
+    objective_ = 0.0;
+    error_num_ = 0;
+    for (int i = first; i < trainer_->sentence_num(); i += stride) {
+      AddSentence(weights, i);
+    }
+  }
+
+  const std::vector<double> &gradient() const { return gradient_; }
+  double objective() const { return objective_; }
+  int error_num() const { return error_num_; }
+
+ private:
+  const CRFTrainer *trainer_;
+  int tag_num_;
+  std::vector<double> gradient_;
+  double objective_;
+  int error_num_;
+
+  // Scratches of a sentence. node_cost_ is [position][tag], arc_cost_ is
+  // [position][left tag][tag] for the arcs from position - 1 to position
+  std::vector<double> node_cost_;
+  std::vector<double> arc_cost_;
+  std::vector<double> alpha_;
+  std::vector<double> beta_;
+  std::vector<double> values_;
+  std::vector<int> left_tag_;
+  std::vector<int> result_;
+
+  // Adds the negative log-likelihood of sentence and its gradient
+  void AddSentence(const double *weights, int sentence);
+
+  // Finds the best tags of sentence by Viterbi and adds the number of wrong
+  // tags to error_num_
+  void CountError(int begin, int size);
+};
+
+void CRFTrainer::GradientWorker::AddSentence(const double *weights,
+                                             int sentence) {
+  const int T = tag_num_;
+  const int begin = trainer_->sentence_begin_[sentence];
+  const int size = trainer_->sentence_begin_[sentence + 1] - begin;
+  const int *tags = trainer_->tags_.data() + begin;
+  const int *unigram_begin = trainer_->unigram_begin_.data() + begin;
+  const int *bigram_begin = trainer_->bigram_begin_.data() + begin;
+  const int *unigram_ids = trainer_->unigram_ids_.data();
+  const int *bigram_ids = trainer_->bigram_ids_.data();
+
+  node_cost_.assign(size * T, 0.0);
+  arc_cost_.assign(size * T * T, 0.0);
+  alpha_.resize(size * T);
+  beta_.resize(size * T);
+  values_.resize(T);
+
+  for (int position = 0; position < size; ++position) {
+    double *node_cost = node_cost_.data() + position * T;
+    for (int i = unigram_begin[position]; i < unigram_begin[position + 1];
+         ++i) {
+      const double *w = weights + unigram_ids[i];
+      for (int tag = 0; tag < T; ++tag) node_cost[tag] += w[tag];
+    }
+
+    double *arc_cost = arc_cost_.data() + position * T * T;
+    for (int i = bigram_begin[position]; i < bigram_begin[position + 1];
+         ++i) {
+      const double *w = weights + bigram_ids[i];
+      for (int arc = 0; arc < T * T; ++arc) arc_cost[arc] += w[arc];
+    }
+  }
+
+  // Forward
+  std::copy(node_cost_.begin(), node_cost_.begin() + T, alpha_.begin());
+  for (int position = 1; position < size; ++position) {
+    const double *left_alpha = alpha_.data() + (position - 1) * T;
+    const double *arc_cost = arc_cost_.data() + position * T * T;
+    for (int tag = 0; tag < T; ++tag) {
+      for (int left = 0; left < T; ++left) {
+        values_[left] = left_alpha[left] + arc_cost[left * T + tag];
+      }
+      alpha_[position * T + tag] = node_cost_[position * T + tag] +
+                                   LogSumExp(values_.data(), T);
+    }
+  }
+
+  // Backward
+  std::fill(beta_.begin() + (size - 1) * T, beta_.end(), 0.0);
+  for (int position = size - 2; position >= 0; --position) {
+    const double *right_beta = beta_.data() + (position + 1) * T;
+    const double *right_node_cost = node_cost_.data() + (position + 1) * T;
+    const double *arc_cost = arc_cost_.data() + (position + 1) * T * T;
+    for (int tag = 0; tag < T; ++tag) {
+      for (int right = 0; right < T; ++right) {
+        values_[right] = arc_cost[tag * T + right] + right_node_cost[right] +
+                         right_beta[right];
+      }
+      beta_[position * T + tag] = LogSumExp(values_.data(), T);
+    }
+  }
+
+  double log_z = LogSumExp(alpha_.data() + (size - 1) * T, T);
+
+  // Expectation of the features minus the observation of them
+  double gold_cost = 0.0;
+  for (int position = 0; position < size; ++position) {
+    int tag = tags[position];
+    gold_cost += node_cost_[position * T + tag];
+    for (int i = unigram_begin[position]; i < unigram_begin[position + 1];
+         ++i) {
+      double *g = gradient_.data() + unigram_ids[i];
+      for (int y = 0; y < T; ++y) {
+        g[y] += exp(alpha_[position * T + y] + beta_[position * T + y] -
+                    log_z);
+      }
+      g[tag] -= 1.0;
+    }
+
+    if (position == 0) continue;
+    int left_tag = tags[position - 1];
+    const double *arc_cost = arc_cost_.data() + position * T * T;
+    gold_cost += arc_cost[left_tag * T + tag];
+    for (int i = bigram_begin[position]; i < bigram_begin[position + 1];
+         ++i) {
+      double *g = gradient_.data() + bigram_ids[i];
+      for (int left = 0; left < T; ++left) {
+        double left_alpha = alpha_[(position - 1) * T + left];
+        for (int y = 0; y < T; ++y) {
+          g[left * T + y] += exp(left_alpha + arc_cost[left * T + y] +
+                                 node_cost_[position * T + y] +
+                                 beta_[position * T + y] - log_z);
+        }
+      }
+      g[left_tag * T + tag] -= 1.0;
+    }
+  }
+
+  objective_ += log_z - gold_cost;
+  CountError(begin, size);
+}
+
+void CRFTrainer::GradientWorker::CountError(int begin, int size) {
+  const int T = tag_num_;
+
+  // Reuse alpha_ as the best cost of Viterbi
+  left_tag_.resize(size * T);
+  result_.resize(size);
+  std::copy(node_cost_.begin(), node_cost_.begin() + T, alpha_.begin());
+  for (int position = 1; position < size; ++position) {
+    const double *arc_cost = arc_cost_.data() + position * T * T;
+    for (int tag = 0; tag < T; ++tag) {
+      double best_cost = -HUGE_VAL;
+      int best_left = 0;
+      for (int left = 0; left < T; ++left) {
+        double cost = alpha_[(position - 1) * T + left] +
+                      arc_cost[left * T + tag];
+        if (cost > best_cost) {
+          best_cost = cost;
+          best_left = left;
+        }
+      }
+      alpha_[position * T + tag] = best_cost + node_cost_[position * T + tag];
+      left_tag_[position * T + tag] = best_left;
+    }
+  }
+
+  const double *last_cost = alpha_.data() + (size - 1) * T;
+  int best_tag = std::max_element(last_cost, last_cost + T) - last_cost;
+  for (int position = size - 1; position >= 0; --position) {
+    if (best_tag != trainer_->tags_[begin + position]) error_num_++;
+    best_tag = left_tag_[position * T + best_tag];
+  }
+}
+
+CRFTrainer::CRFTrainer(): tag_num_(0), xsize_(0) {
+  sentence_begin_.push_back(0);
+}
+
+CRFTrainer::~CRFTrainer() {}
+
+CRFTrainer *CRFTrainer::New(const char *template_path,
+                            const char *corpus_path,
+                            int min_frequency,
+                            Status *status) {
+  CRFTrainer *self = new CRFTrainer();
+
+  self->ReadTemplates(template_path, status);
+  if (status->ok()) self->ReadCorpus(corpus_path, min_frequency, status);
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+void CRFTrainer::ReadTemplates(const char *template_path, Status *status) {
+  ReadableFile *fd = ReadableFile::New(template_path, status);
+  char line[1024];
+
+  while (status->ok() && !fd->Eof()) {
+    fd->ReadLine(line, sizeof(line), status);
+    if (status->ok()) {
+      TrimRight(line);
+      if (*line == '\0' || *line == '#') continue;
+
+      if (*line == 'U') {
+        unigram_templates_.push_back(line);
+      } else if (*line == 'B') {
+        bigram_templates_.push_back(line);
+      } else {
+        std::string msg = std::string("invalid template: ") + line;
+        *status = Status::Corruption(msg.c_str());
+      }
+    }
+  }
+
+  if (status->ok() && unigram_templates_.empty() &&
+      bigram_templates_.empty()) {
+    *status = Status::Corruption(template_path);
+  }
+
+  delete fd;
+}
+
+void CRFTrainer::ReadCorpus(const char *corpus_path,
+                            int min_frequency,
+                            Status *status) {
+  ReadableFile *fd = ReadableFile::New(corpus_path, status);
+  char *line = new char[kLineMax];
+
+  // cells[token * xsize_ + column] is the column of token in the corpus
+  std::vector<std::string> cells;
+  std::unordered_map<std::string, int> tag_ids;
+  int line_num = 0;
+  while (status->ok() && !fd->Eof()) {
+    fd->ReadLine(line, kLineMax, status);
+    line_num++;
+    if (!status->ok()) break;
+
+    TrimRight(line);
+    if (*line == '\0') {
+      if (sentence_begin_.back() != static_cast<int>(tags_.size())) {
+        sentence_begin_.push_back(tags_.size());
+      }
+      continue;
+    }
+
+    std::vector<char *> columns;
+    for (char *column = strtok(line, " \t"); column != nullptr;
+         column = strtok(nullptr, " \t")) {
+      columns.push_back(column);
+    }
+
+    int xsize = columns.size() - 1;
+    if (xsize_ == 0) xsize_ = xsize;
+    if (xsize < 1 || xsize != xsize_) {
+      char msg[1024];
+      snprintf(msg, sizeof(msg), "invalid column number in %s line %d",
+               corpus_path, line_num);
+      *status = Status::Corruption(msg);
+      break;
+    }
+
+    cells.insert(cells.end(), columns.begin(), columns.end() - 1);
+    auto it = tag_ids.find(columns.back());
+    if (it == tag_ids.end()) {
+      it = tag_ids.emplace(columns.back(), tag_texts_.size()).first;
+      tag_texts_.push_back(columns.back());
+    }
+    tags_.push_back(it->second);
+  }
+  if (sentence_begin_.back() != static_cast<int>(tags_.size())) {
+    sentence_begin_.push_back(tags_.size());
+  }
+  tag_num_ = tag_texts_.size();
+
+  if (status->ok() && tags_.empty()) {
+    *status = Status::Corruption(corpus_path);
+  }
+
+  // Count the features, the bigram features at the first position of
+  // sentence are not used
+  std::unordered_map<std::string, int> frequency;
+  auto count = [&frequency](const std::string &feature_str) {
+    frequency[feature_str]++;
+  };
+  for (int i = 0; i < sentence_num() && status->ok(); ++i) {
+    const std::string *sentence_cells = cells.data() +
+                                        sentence_begin_[i] * xsize_;
+    int size = sentence_begin_[i + 1] - sentence_begin_[i];
+    for (int position = 0; position < size; ++position) {
+      bool valid = ExpandTemplatesAt(unigram_templates_, sentence_cells, size,
+                                     xsize_, position, count);
+      if (valid && position > 0) {
+        valid = ExpandTemplatesAt(bigram_templates_, sentence_cells, size,
+                                  xsize_, position, count);
+      }
+      if (!valid) {
+        *status = Status::Corruption("invalid template");
+        break;
+      }
+    }
+  }
+
+  // Assign the ids in the order of feature string
+  std::unordered_map<std::string, int> feature_index;
+  if (status->ok()) {
+    std::map<std::string, int> sorted_frequency(frequency.begin(),
+                                                frequency.end());
+    frequency.clear();
+    int weight_num = 0;
+    for (auto &x : sorted_frequency) {
+      if (x.second < min_frequency) continue;
+      feature_index.emplace(x.first, weight_num);
+      features_.push_back(x.first);
+      feature_ids_.push_back(weight_num);
+      weight_num += x.first[0] == 'U' ? tag_num_ : tag_num_ * tag_num_;
+    }
+    weights_.assign(weight_num, 0.0);
+  }
+
+  // Convert the tokens into feature ids
+  if (status->ok()) {
+    auto unigram = [this, &feature_index](const std::string &feature_str) {
+      auto it = feature_index.find(feature_str);
+      if (it != feature_index.end()) unigram_ids_.push_back(it->second);
+    };
+    auto bigram = [this, &feature_index](const std::string &feature_str) {
+      auto it = feature_index.find(feature_str);
+      if (it != feature_index.end()) bigram_ids_.push_back(it->second);
+    };
+
+    unigram_begin_.push_back(0);
+    bigram_begin_.push_back(0);
+    for (int i = 0; i < sentence_num(); ++i) {
+      const std::string *sentence_cells = cells.data() +
+                                          sentence_begin_[i] * xsize_;
+      int size = sentence_begin_[i + 1] - sentence_begin_[i];
+      for (int position = 0; position < size; ++position) {
+        ExpandTemplatesAt(unigram_templates_, sentence_cells, size, xsize_,
+                          position, unigram);
+        if (position > 0) {
+          ExpandTemplatesAt(bigram_templates_, sentence_cells, size, xsize_,
+                            position, bigram);
+        }
+        unigram_begin_.push_back(unigram_ids_.size());
+        bigram_begin_.push_back(bigram_ids_.size());
+      }
+    }
+  }
+
+  delete[] line;
+  delete fd;
+}
+
+double CRFTrainer::ComputeGradient(const std::vector<double> &weights,
+                                   int thread_num,
+                                   std::vector<GradientWorker *> *workers,
+                                   std::vector<double> *gradient,
+                                   int *error_num) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_num; ++i) {
+    threads.push_back(std::thread(&GradientWorker::Compute,
+                                  (*workers)[i],
+                                  weights.data(),
+                                  i,
+                                  thread_num));
+  }
+  for (auto &th : threads) th.join();
+
+  double objective = 0.0;
+  *error_num = 0;
+  std::fill(gradient->begin(), gradient->end(), 0.0);
+  for (GradientWorker *worker : *workers) {
+    const std::vector<double> &worker_gradient = worker->gradient();
+    for (size_t i = 0; i < gradient->size(); ++i) {
+      (*gradient)[i] += worker_gradient[i];
+    }
+    objective += worker->objective();
+    *error_num += worker->error_num();
+  }
+
+  return objective;
+}
+
+void CRFTrainer::Train(double cost,
+                       int max_iteration,
+                       double eta,
+                       int thread_num,
+                       void (* progress)(int iteration,
+                                         double error_rate,
+                                         double objective,
+                                         double difference),
+                       Status *status) {
+  int n = weights_.size();
+  thread_num = std::max(1, std::min(thread_num, sentence_num()));
+  std::vector<GradientWorker *> workers;
+  for (int i = 0; i < thread_num; ++i) {
+    workers.push_back(new GradientWorker(this, n));
+  }
+
+  // Objective with the L2 regularization |w|^2 / (2 * cost)
+  int error_num = 0;
+  auto evaluate = [&](const std::vector<double> &w,
+                      std::vector<double> *g) {
+    double objective = ComputeGradient(w, thread_num, &workers, g,
+                                       &error_num);
+    for (int i = 0; i < n; ++i) {
+      objective += w[i] * w[i] / (2.0 * cost);
+      (*g)[i] += w[i] / cost;
+    }
+    return objective;
+  };
+
+  std::vector<double> &w = weights_;
+  std::vector<double> g(n), new_w(n), new_g(n), direction(n);
+  std::vector<std::vector<double> > s_list, y_list;
+  std::vector<double> rho_list, alpha(kLBFGSMemory);
+  double objective = evaluate(w, &g);
+
+  int converge_num = 0;
+  for (int iteration = 1; iteration <= max_iteration; ++iteration) {
+    // L-BFGS two-loop recursion, direction = -H * g
+    for (int i = 0; i < n; ++i) direction[i] = -g[i];
+    int m = s_list.size();
+    for (int k = m - 1; k >= 0; --k) {
+      alpha[k] = rho_list[k] * Dot(s_list[k], direction);
+      for (int i = 0; i < n; ++i) direction[i] -= alpha[k] * y_list[k][i];
+    }
+    if (m > 0) {
+      double gamma = Dot(s_list[m - 1], y_list[m - 1]) /
+                     Dot(y_list[m - 1], y_list[m - 1]);
+      for (int i = 0; i < n; ++i) direction[i] *= gamma;
+    }
+    for (int k = 0; k < m; ++k) {
+      double beta = rho_list[k] * Dot(y_list[k], direction);
+      for (int i = 0; i < n; ++i) {
+        direction[i] += (alpha[k] - beta) * s_list[k][i];
+      }
+    }
+
+    // Backtracking line search with the Armijo condition, the first step is
+    // scaled since there is no curvature information yet
+    double slope = Dot(g, direction);
+    if (slope >= 0) {
+      // Not a descent direction, restart from the steepest descent
+      s_list.clear();
+      y_list.clear();
+      rho_list.clear();
+      for (int i = 0; i < n; ++i) direction[i] = -g[i];
+      slope = Dot(g, direction);
+      m = 0;
+    }
+    double step = m == 0 ? 1.0 / sqrt(Dot(g, g)) : 1.0;
+    double new_objective = 0.0;
+    bool accepted = false;
+    for (int k = 0; k < kMaxLineSearch && !accepted; ++k) {
+      for (int i = 0; i < n; ++i) new_w[i] = w[i] + step * direction[i];
+      new_objective = evaluate(new_w, &new_g);
+      if (new_objective <= objective + kArmijo * step * slope) {
+        accepted = true;
+      } else {
+        step *= 0.5;
+      }
+    }
+    if (!accepted) break;
+
+    // Update the corrections
+    std::vector<double> s(n), y(n);
+    for (int i = 0; i < n; ++i) {
+      s[i] = new_w[i] - w[i];
+      y[i] = new_g[i] - g[i];
+    }
+    double sy = Dot(s, y);
+    if (sy > 1e-10) {
+      if (static_cast<int>(s_list.size()) == kLBFGSMemory) {
+        s_list.erase(s_list.begin());
+        y_list.erase(y_list.begin());
+        rho_list.erase(rho_list.begin());
+      }
+      s_list.push_back(std::move(s));
+      y_list.push_back(std::move(y));
+      rho_list.push_back(1.0 / sy);
+    }
+
+    double difference = fabs(objective - new_objective) / new_objective;
+    w.swap(new_w);
+    g.swap(new_g);
+    objective = new_objective;
+
+    if (progress) {
+      progress(iteration,
+               static_cast<double>(error_num) / token_num(),
+               objective,
+               difference);
+    }
+
+    converge_num = difference < eta ? converge_num + 1 : 0;
+    if (converge_num == kConvergeIteration) break;
+  }
+
+  for (GradientWorker *worker : workers) delete worker;
+}
+
+void CRFTrainer::Save(const char *model_path, Status *status) {
+  // Index of the features
+  Darts::DoubleArray double_array;
+  std::vector<const char *> keys;
+  for (const std::string &feature : features_) keys.push_back(feature.c_str());
+  if (double_array.build(keys.size(),
+                         keys.data(),
+                         nullptr,
+                         feature_ids_.data()) != 0) {
+    *status = Status::RuntimeError("failed to build the feature index");
+  }
+
+  // Tag texts and templates separated by '\0'. The templates are padded by
+  // '\0' which is ignored by CRFModel, so that the double array is aligned
+  std::string tag_str, template_str;
+  for (const std::string &tag : tag_texts_) {
+    tag_str.append(tag.c_str(), tag.size() + 1);
+  }
+  for (const std::string &templ : unigram_templates_) {
+    template_str.append(templ.c_str(), templ.size() + 1);
+  }
+  for (const std::string &templ : bigram_templates_) {
+    template_str.append(templ.c_str(), templ.size() + 1);
+  }
+  while ((tag_str.size() + template_str.size()) % 4 != 0) {
+    template_str.push_back('\0');
+  }
+
+  WritableFile *fd = nullptr;
+  if (status->ok()) fd = WritableFile::New(model_path, status);
+
+  int32_t dsize = double_array.unit_size() * double_array.size();
+  if (status->ok()) fd->WriteValue<int32_t>(100, status);
+  if (status->ok()) fd->WriteValue<int32_t>(0, status);
+  if (status->ok()) fd->WriteValue<double>(1.0, status);
+  if (status->ok()) fd->WriteValue<int32_t>(weights_.size(), status);
+  if (status->ok()) fd->WriteValue<int32_t>(xsize_, status);
+  if (status->ok()) fd->WriteValue<int32_t>(dsize, status);
+  if (status->ok()) fd->WriteValue<int32_t>(tag_str.size(), status);
+  if (status->ok()) fd->Write(tag_str.data(), tag_str.size(), status);
+  if (status->ok()) fd->WriteValue<int32_t>(template_str.size(), status);
+  if (status->ok()) fd->Write(template_str.data(), template_str.size(), status);
+  if (status->ok()) fd->Write(double_array.array(), dsize, status);
+  if (status->ok()) {
+    std::vector<float> weights(weights_.begin(), weights_.end());
+    fd->Write(weights.data(), sizeof(float) * weights.size(), status);
+  }
+
+  delete fd;
+}
+
+}  // namespace milkcat
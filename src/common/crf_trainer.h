@@ -0,0 +1,138 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// crf_trainer.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_COMMON_CRF_TRAINER_H_
+#define SRC_COMMON_CRF_TRAINER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "utils/utils.h"
+#include "utils/status.h"
+
+namespace milkcat {
+
+// Trains the linear-chain CRF model from the training data and templates in
+// CRF++ format, and saves it in the CRF++ version-100 binary format which
+// could be loaded by CRFModel. The weights are trained by L-BFGS with L2
+// regularization, the gradient of each iteration is computed in parallel
+class CRFTrainer {
+ public:
+  // Default parameters of training, the same as CRF++
+  static const int kDefaultMinFrequency = 1;
+  static const int kDefaultMaxIteration = 10000;
+  static constexpr double kDefaultCost = 1.0;
+  static constexpr double kDefaultEta = 0.0001;
+
+  // Reads the templates from template_path and the training data from
+  // corpus_path. Training data is a token per line with columns separated
+  // by spaces or tabs, the last column is the tag and sentences are
+  // separated by empty lines. The features appear less than min_frequency
+  // times are dropped
+  static CRFTrainer *New(const char *template_path,
+                         const char *corpus_path,
+                         int min_frequency,
+                         Status *status);
+
+  ~CRFTrainer();
+
+  // Trains the weights. cost is the C of CRF++, the L2 regularization term is
+  // |w|^2 / (2 * cost). The training stops after max_iteration iterations or
+  // the relative difference of objective is less than eta for 3 iterations.
+  // If progress is not nullptr it is called after each iteration with the
+  // token error rate, the objective and its relative difference
+  void Train(double cost,
+             int max_iteration,
+             double eta,
+             int thread_num,
+             void (* progress)(int iteration,
+                               double error_rate,
+                               double objective,
+                               double difference),
+             Status *status);
+
+  // Saves the model in CRF++ version-100 binary format
+  void Save(const char *model_path, Status *status);
+
+  int tag_num() const { return tag_num_; }
+  int sentence_num() const { return sentence_begin_.size() - 1; }
+  int token_num() const { return tags_.size(); }
+  int feature_num() const { return features_.size(); }
+  int weight_num() const { return weights_.size(); }
+
+ private:
+  std::vector<std::string> unigram_templates_;
+  std::vector<std::string> bigram_templates_;
+  std::vector<std::string> tag_texts_;
+  int tag_num_;
+  int xsize_;
+
+  // Features of the model, features_[i] has its weights at
+  // [feature_ids_[i], feature_ids_[i] + tag_num_) for unigram feature or
+  // [feature_ids_[i], feature_ids_[i] + tag_num_ * tag_num_) for bigram
+  // feature. The features are sorted
+  std::vector<std::string> features_;
+  std::vector<int> feature_ids_;
+  std::vector<double> weights_;
+
+  // Training data. The tokens of sentence i are [sentence_begin_[i],
+  // sentence_begin_[i + 1]), the unigram feature ids of token t are
+  // unigram_ids_[unigram_begin_[t], unigram_begin_[t + 1]) and the bigram
+  // feature ids are the same
+  std::vector<int> sentence_begin_;
+  std::vector<int> tags_;
+  std::vector<int> unigram_begin_;
+  std::vector<int> unigram_ids_;
+  std::vector<int> bigram_begin_;
+  std::vector<int> bigram_ids_;
+
+  // Per-thread states of computing the gradient
+  class GradientWorker;
+
+  CRFTrainer();
+
+  // Reads templates from template_path
+  void ReadTemplates(const char *template_path, Status *status);
+
+  // Reads the sentences in corpus_path, generates the features and converts
+  // the sentences into the feature ids
+  void ReadCorpus(const char *corpus_path, int min_frequency, Status *status);
+
+  // Computes the negative log-likelihood of training data at weights and its
+  // gradient with thread_num threads. Returns the objective and stores the
+  // number of wrongly tagged tokens into error_num
+  double ComputeGradient(const std::vector<double> &weights,
+                         int thread_num,
+                         std::vector<GradientWorker *> *workers,
+                         std::vector<double> *gradient,
+                         int *error_num);
+
+  DISALLOW_COPY_AND_ASSIGN(CRFTrainer);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_COMMON_CRF_TRAINER_H_
@@ -0,0 +1,471 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// hmm_trainer.cc --- Created at 2026-10-19
+//
+
+#include "common/hmm_trainer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "milkcat/trie_tree.h"
+#include "utils/readable_file.h"
+
+namespace milkcat {
+
+namespace {
+
+// Number of lines read by a thread at once
+constexpr int kBatchLineNum = 256;
+constexpr int kLineSizeMax = 1024 * 1024;
+
+// The probabilities of the transitions never seen in the corpus, such as the
+// transitions to BOS
+constexpr double kMinProbability = 1e-9;
+
+// Tags more than it could not be packed into the keys of Counter
+constexpr int kTagNumMax = 1 << 16;
+
+inline float Cost(double probability) {
+  return static_cast<float>(-log(std::max(probability, kMinProbability)));
+}
+
+// The ratio (count - 1) / (total - 1) used in deleted interpolation, that is
+// the probability estimated without the current occurrence
+inline double DeletedRatio(int64_t count, int64_t total) {
+  return total > 1? (count - 1) / static_cast<double>(total - 1): 0.0;
+}
+
+// Calls progress per second with the bytes read from fd until task_finished
+void ProgressThread(ReadableFile *fd,
+                    std::mutex *fd_mutex,
+                    const std::atomic_bool &task_finished,
+                    void (* progress)(int64_t bytes_processed,
+                                      int64_t file_size,
+                                      int64_t bytes_per_second)) {
+  int64_t last_bytes_processed = 0,
+          bytes_processed = 0;
+
+  while (task_finished.load() == false) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    last_bytes_processed = bytes_processed;
+    fd_mutex->lock();
+    bytes_processed = fd->Tell();
+    fd_mutex->unlock();
+    progress(bytes_processed,
+             fd->Size(),
+             bytes_processed - last_bytes_processed);
+  }
+}
+
+}  // namespace
+
+class HMMTrainer::Counter {
+ public:
+  Counter(): sentence_num_(0), token_num_(0) {
+    TagId("BOS");
+  }
+
+  // Reads the lines of fd in batches and counts them until the end of file
+  void Count(ReadableFile *fd, std::mutex *fd_mutex, Status *status) {
+    std::vector<char> line(kLineSizeMax);
+    std::vector<std::string> batch;
+    bool eof = false;
+    while (status->ok() && !eof) {
+      batch.clear();
+      fd_mutex->lock();
+      while (status->ok() && batch.size() < kBatchLineNum) {
+        eof = fd->Eof();
+        if (eof) break;
+        if (fd->ReadLine(line.data(), kLineSizeMax, status))
+          batch.push_back(line.data());
+      }
+      fd_mutex->unlock();
+
+      for (std::string &sentence : batch) {
+        if (status->ok()) CountSentence(&sentence[0], status);
+      }
+    }
+  }
+
+  const std::vector<std::string> &tags() const { return tags_; }
+  const std::vector<int64_t> &unigram_count() const { return unigram_count_; }
+  const std::unordered_map<int64_t, int64_t> &ngram_count() const {
+    return ngram_count_;
+  }
+  const std::unordered_map<std::string,
+                           std::vector<std::pair<int, int64_t>>> &
+  emit_count() const {
+    return emit_count_;
+  }
+  int64_t sentence_num() const { return sentence_num_; }
+  int64_t token_num() const { return token_num_; }
+
+  // Keys of ngram_count_, the local ids of tags are packed into 16 bits each
+  // and the bigrams have leftleft = kTagNumMax - 1
+  static int64_t TrigramKey(int leftleft, int left, int tag) {
+    return (static_cast<int64_t>(leftleft) << 32) |
+           (static_cast<int64_t>(left) << 16) |
+           tag;
+  }
+  static int64_t BigramKey(int left, int tag) {
+    return TrigramKey(kTagNumMax - 1, left, tag);
+  }
+
+ private:
+  // Local tag ids of this thread, tags_[0] is BOS
+  std::vector<std::string> tags_;
+  std::unordered_map<std::string, int> tag_ids_;
+
+  std::vector<int64_t> unigram_count_;
+  std::unordered_map<int64_t, int64_t> ngram_count_;
+  std::unordered_map<std::string,
+                     std::vector<std::pair<int, int64_t>>> emit_count_;
+  int64_t sentence_num_;
+  int64_t token_num_;
+
+  // Get the local id of tag, a new id is assigned if tag is not seen before
+  int TagId(const char *tag) {
+    auto it = tag_ids_.find(tag);
+    if (it != tag_ids_.end()) return it->second;
+
+    int tag_id = tags_.size();
+    tags_.push_back(tag);
+    tag_ids_.emplace(tag, tag_id);
+    unigram_count_.push_back(0);
+    return tag_id;
+  }
+
+  // Counts a sentence of "word/TAG" separated by spaces, the sentence is
+  // modified by strtok_r
+  void CountSentence(char *sentence, Status *status) {
+    char message[1024];
+    char *saveptr = nullptr;
+    int leftleft = 0,
+        left = 0;
+    int64_t token_num = 0;
+    for (char *token = strtok_r(sentence, " \t\r\n", &saveptr);
+         token != nullptr;
+         token = strtok_r(nullptr, " \t\r\n", &saveptr)) {
+      char *slash = strrchr(token, '/');
+      if (slash == nullptr || slash == token || slash[1] == '\0' ||
+          strcmp(slash + 1, "BOS") == 0) {
+        snprintf(message, sizeof(message), "Invalid word/TAG: %s", token);
+        *status = Status::Corruption(message);
+        return;
+      }
+      *slash = '\0';
+
+      int tag = TagId(slash + 1);
+      if (tag >= kTagNumMax - 1) {
+        *status = Status::Corruption("Too many tags in corpus");
+        return;
+      }
+      unigram_count_[tag]++;
+      ngram_count_[BigramKey(left, tag)]++;
+      ngram_count_[TrigramKey(leftleft, left, tag)]++;
+
+      std::vector<std::pair<int, int64_t>> &emits = emit_count_[token];
+      auto it = std::find_if(
+          emits.begin(),
+          emits.end(),
+          [tag](const std::pair<int, int64_t> &e) { return e.first == tag; });
+      if (it != emits.end()) {
+        it->second++;
+      } else {
+        emits.emplace_back(tag, 1);
+      }
+
+      leftleft = left;
+      left = tag;
+      token_num++;
+    }
+
+    if (token_num > 0) sentence_num_++;
+    token_num_ += token_num;
+  }
+};
+
+HMMTrainer::HMMTrainer(): sentence_num_(0), token_num_(0) {
+  lambdas_[0] = lambdas_[1] = lambdas_[2] = 0.0;
+}
+
+HMMTrainer::~HMMTrainer() {
+}
+
+HMMTrainer *HMMTrainer::New(const char *corpus_path,
+                            int thread_num,
+                            void (* progress)(int64_t bytes_processed,
+                                              int64_t file_size,
+                                              int64_t bytes_per_second),
+                            Status *status) {
+  HMMTrainer *self = new HMMTrainer();
+  ReadableFile *fd = ReadableFile::New(corpus_path, status);
+
+  std::vector<Counter> counters(thread_num);
+  if (status->ok()) {
+    std::vector<Status> status_vec(thread_num);
+    std::vector<std::thread> threads;
+    std::thread progress_thread;
+    std::mutex fd_mutex;
+    std::atomic_bool task_finished(false);
+
+    for (int i = 0; i < thread_num; ++i) {
+      threads.push_back(std::thread(&Counter::Count,
+                                    &counters[i],
+                                    fd,
+                                    &fd_mutex,
+                                    &status_vec[i]));
+    }
+    if (progress) {
+      progress_thread = std::thread(ProgressThread,
+                                    fd,
+                                    &fd_mutex,
+                                    std::ref(task_finished),
+                                    progress);
+    }
+
+    for (auto &th : threads) th.join();
+    task_finished.store(true);
+    if (progress) progress_thread.join();
+
+    for (auto &st : status_vec) {
+      if (!st.ok()) *status = st;
+    }
+  }
+  delete fd;
+
+  // The global tag ids are BOS followed by the other tags in order
+  if (status->ok()) {
+    std::vector<std::string> tags;
+    for (const Counter &counter : counters) {
+      tags.insert(tags.end(),
+                  counter.tags().begin() + 1,
+                  counter.tags().end());
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+
+    self->tags_.push_back("BOS");
+    self->tags_.insert(self->tags_.end(), tags.begin(), tags.end());
+    if (self->tag_num() >= kTagNumMax)
+      *status = Status::Corruption("Too many tags in corpus");
+  }
+
+  if (status->ok()) {
+    int tag_num = self->tag_num();
+    self->unigram_count_.assign(tag_num, 0);
+    self->bigram_count_.assign(tag_num * tag_num, 0);
+    self->trigram_count_.assign(tag_num * tag_num * tag_num, 0);
+    for (const Counter &counter : counters) self->Merge(counter);
+    if (self->token_num_ == 0)
+      *status = Status::Corruption("No tagged word in corpus");
+  }
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+void HMMTrainer::Merge(const Counter &counter) {
+  int tag_num = this->tag_num();
+
+  // Maps the local tag ids of counter to the ids of this trainer
+  std::vector<int> tag_ids(counter.tags().size());
+  for (size_t i = 0; i < tag_ids.size(); ++i) {
+    const std::string &tag = counter.tags()[i];
+    tag_ids[i] = i == 0? 0: std::lower_bound(tags_.begin() + 1,
+                                             tags_.end(),
+                                             tag) - tags_.begin();
+  }
+
+  for (size_t i = 0; i < tag_ids.size(); ++i) {
+    unigram_count_[tag_ids[i]] += counter.unigram_count()[i];
+  }
+
+  for (auto &x : counter.ngram_count()) {
+    int leftleft = static_cast<int>(x.first >> 32);
+    int left = tag_ids[(x.first >> 16) & (kTagNumMax - 1)];
+    int tag = tag_ids[x.first & (kTagNumMax - 1)];
+    if (leftleft == kTagNumMax - 1) {
+      bigram_count_[left * tag_num + tag] += x.second;
+    } else {
+      leftleft = tag_ids[leftleft];
+      trigram_count_[(leftleft * tag_num + left) * tag_num + tag] += x.second;
+    }
+  }
+
+  for (auto &x : counter.emit_count()) {
+    std::vector<std::pair<int, int64_t>> &emits = emit_count_[x.first];
+    for (auto &emit : x.second) {
+      int tag = tag_ids[emit.first];
+      auto it = std::find_if(
+          emits.begin(),
+          emits.end(),
+          [tag](const std::pair<int, int64_t> &e) { return e.first == tag; });
+      if (it != emits.end()) {
+        it->second += emit.second;
+      } else {
+        emits.emplace_back(tag, emit.second);
+      }
+    }
+  }
+
+  sentence_num_ += counter.sentence_num();
+  token_num_ += counter.token_num();
+}
+
+void HMMTrainer::EstimateLambdas(int order,
+                                 const std::vector<int64_t> &context1,
+                                 const std::vector<int64_t> &context2) {
+  int tag_num = this->tag_num();
+  int context_num = order == 2? tag_num * tag_num: tag_num;
+
+  // For each n-gram, adds its count to the weight of the order that
+  // predicts it best without this occurrence
+  double weights[3] = {0.0, 0.0, 0.0};
+  for (int context = 0; context < context_num; ++context) {
+    int left = context % tag_num;
+    for (int tag = 0; tag < tag_num; ++tag) {
+      int64_t bigram_count = bigram_count_[left * tag_num + tag];
+      int64_t count = order == 2?
+          trigram_count_[context * tag_num + tag]:
+          bigram_count;
+      if (count == 0) continue;
+
+      double ratios[3] = {
+        DeletedRatio(unigram_count_[tag], token_num_),
+        DeletedRatio(bigram_count, context1[left]),
+        order == 2? DeletedRatio(count, context2[context]): 0.0
+      };
+      int best = 0;
+      for (int n = 1; n <= order; ++n) {
+        if (ratios[n] > ratios[best]) best = n;
+      }
+      weights[best] += count;
+    }
+  }
+
+  double sum = weights[0] + weights[1] + weights[2];
+  for (int n = 0; n < 3; ++n) lambdas_[n] = sum > 0? weights[n] / sum: 0.0;
+}
+
+HMMModel *HMMTrainer::Train(const char *index_path,
+                            int order,
+                            Status *status) {
+  if (order != 1 && order != 2) {
+    *status = Status::NotImplemented("Only HMM of order 1 or 2 is supported");
+    return nullptr;
+  }
+
+  int tag_num = this->tag_num();
+  double N = static_cast<double>(token_num_);
+
+  // The number of times each tag and tag bigram appears as the context
+  std::vector<int64_t> context1(tag_num, 0),
+                       context2(tag_num * tag_num, 0);
+  for (int i = 0; i < tag_num * tag_num; ++i) {
+    context1[i / tag_num] += bigram_count_[i];
+    for (int tag = 0; tag < tag_num; ++tag) {
+      context2[i] += trigram_count_[i * tag_num + tag];
+    }
+  }
+  EstimateLambdas(order, context1, context2);
+
+  std::vector<float> tag_cost(tag_num);
+  tag_cost[0] = 0.0f;
+  for (int tag = 1; tag < tag_num; ++tag) {
+    tag_cost[tag] = Cost(unigram_count_[tag] / N);
+  }
+
+  std::vector<float> transition_matrix;
+  int context_num = order == 2? tag_num * tag_num: tag_num;
+  transition_matrix.reserve(context_num * tag_num);
+  for (int context = 0; context < context_num; ++context) {
+    int left = context % tag_num;
+    for (int tag = 0; tag < tag_num; ++tag) {
+      double p1 = unigram_count_[tag] / N;
+      double p2 = context1[left]?
+          bigram_count_[left * tag_num + tag] /
+              static_cast<double>(context1[left]):
+          0.0;
+      double p3 = order == 2 && context2[context]?
+          trigram_count_[context * tag_num + tag] /
+              static_cast<double>(context2[context]):
+          0.0;
+      double p = tag == 0? 0.0:
+          lambdas_[0] * p1 + lambdas_[1] * p2 + lambdas_[2] * p3;
+      transition_matrix.push_back(Cost(p));
+    }
+  }
+
+  // Emits of the words in index, the cost is -log P(word | tag)
+  TrieTree *index = DoubleArrayTrieTree::New(index_path, status);
+  std::vector<std::vector<HMMModel::Emit>> emits;
+  if (status->ok()) {
+    for (auto &x : emit_count_) {
+      int term_id = index->Search(x.first.c_str());
+      if (term_id < 0) continue;
+
+      if (term_id >= static_cast<int>(emits.size())) emits.resize(term_id + 1);
+      for (auto &emit_count : x.second) {
+        HMMModel::Emit emit;
+        emit.tag = emit_count.first;
+        emit.cost = Cost(emit_count.second /
+                         static_cast<double>(unigram_count_[emit.tag]));
+        emits[term_id].push_back(emit);
+      }
+      std::sort(emits[term_id].begin(),
+                emits[term_id].end(),
+                [](const HMMModel::Emit &e1, const HMMModel::Emit &e2) {
+                  return e1.tag < e2.tag;
+                });
+    }
+  }
+  delete index;
+
+  HMMModel *model = nullptr;
+  if (status->ok()) {
+    model = HMMModel::NewFromCosts(tags_,
+                                   tag_cost,
+                                   transition_matrix,
+                                   emits,
+                                   order,
+                                   status);
+  }
+  return model;
+}
+
+}  // namespace milkcat
@@ -0,0 +1,113 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// hmm_trainer.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_COMMON_HMM_TRAINER_H_
+#define SRC_COMMON_HMM_TRAINER_H_
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "milkcat/hmm_model.h"
+#include "utils/utils.h"
+#include "utils/status.h"
+
+namespace milkcat {
+
+// Counts the tag n-grams and the emissions of words from a tagged corpus and
+// estimates the HMM part-of-speech tagger model from them. The corpus is
+// counted in parallel, each thread counts into its own tables and they are
+// merged after the whole corpus is read. The transitions are smoothed by
+// the deleted interpolation of TnT
+class HMMTrainer {
+ public:
+  // Counts the corpus in corpus_path with thread_num threads. Each line of
+  // the corpus is a sentence of "word/TAG" separated by spaces. If progress
+  // is not nullptr it is called per second with the bytes read
+  static HMMTrainer *New(const char *corpus_path,
+                         int thread_num,
+                         void (* progress)(int64_t bytes_processed,
+                                           int64_t file_size,
+                                           int64_t bytes_per_second),
+                         Status *status);
+
+  ~HMMTrainer();
+
+  // Estimates the HMM model of order (2 for tag trigrams and 1 for tag
+  // bigrams) from the counts. Only the emissions of words in the index of
+  // index_path are kept
+  HMMModel *Train(const char *index_path, int order, Status *status);
+
+  // Interpolation weight of unigram (n = 0), bigram and trigram transitions
+  // estimated by the recent Train()
+  double lambda(int n) const { return lambdas_[n]; }
+
+  int tag_num() const { return tags_.size(); }
+  int64_t sentence_num() const { return sentence_num_; }
+  int64_t token_num() const { return token_num_; }
+  int word_num() const { return emit_count_.size(); }
+
+ private:
+  // Tags in the corpus, tags_[0] is "BOS" for the beginning of sentences
+  std::vector<std::string> tags_;
+
+  // Counts of tag unigrams, bigrams (left * tag_num + tag) and trigrams
+  // ((leftleft * tag_num + left) * tag_num + tag). The two contexts of the
+  // first tag in sentence are BOS
+  std::vector<int64_t> unigram_count_;
+  std::vector<int64_t> bigram_count_;
+  std::vector<int64_t> trigram_count_;
+
+  // (tag, count) of each word
+  std::unordered_map<std::string,
+                     std::vector<std::pair<int, int64_t>>> emit_count_;
+
+  int64_t sentence_num_;
+  int64_t token_num_;
+  double lambdas_[3];
+
+  // Counts of one thread
+  class Counter;
+
+  HMMTrainer();
+
+  // Merges the counts of counter into this trainer
+  void Merge(const Counter &counter);
+
+  // Estimates the weights of the interpolation of orders from the n-gram
+  // counts by deleted interpolation. context1 and context2 are the number of
+  // times each tag and tag bigram appears as the context
+  void EstimateLambdas(int order,
+                       const std::vector<int64_t> &context1,
+                       const std::vector<int64_t> &context2);
+
+  DISALLOW_COPY_AND_ASSIGN(HMMTrainer);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_COMMON_HMM_TRAINER_H_
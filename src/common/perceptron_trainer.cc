@@ -0,0 +1,277 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_trainer.cc --- Created at 2026-10-19
+//
+
+#include "common/perceptron_trainer.h"
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "milkcat/tokenizer.h"
+#include "milkcat/token_instance.h"
+#include "utils/readable_file.h"
+
+namespace milkcat {
+
+namespace {
+
+const int kLineMax = 1024 * 1024;
+
+// Seed of shuffling the sentences, a fixed one makes the training repeatable
+const int kShuffleSeed = 1;
+
+}  // namespace
+
+PerceptronTrainer::PerceptronTrainer(): model_(nullptr),
+                                        character_num_(0),
+                                        step_(0) {
+}
+
+PerceptronTrainer::~PerceptronTrainer() {
+  delete model_;
+  model_ = nullptr;
+}
+
+PerceptronTrainer *PerceptronTrainer::New(const char *corpus_path,
+                                          int bucket_bits,
+                                          int min_frequency,
+                                          Status *status) {
+  PerceptronTrainer *self = new PerceptronTrainer();
+  self->ReadCorpus(corpus_path, bucket_bits, min_frequency, status);
+
+  if (status->ok()) {
+    self->weight_sums_.assign(self->model_->weight_num(), 0.0);
+    self->weight_steps_.assign(self->model_->weight_num(), 0);
+    self->transition_sums_.assign(PerceptronModel::kTagNum *
+                                  PerceptronModel::kTagNum, 0.0);
+    self->transition_steps_.assign(PerceptronModel::kTagNum *
+                                   PerceptronModel::kTagNum, 0);
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+void PerceptronTrainer::ReadCorpus(const char *corpus_path,
+                                   int bucket_bits,
+                                   int min_frequency,
+                                   Status *status) {
+  ReadableFile *fd = ReadableFile::New(corpus_path, status);
+  char *line = new char[kLineMax];
+  Tokenization tokenizer;
+  TokenInstance token_instance;
+
+  // Texts and types of the tokens in corpus, they are converted to ids after
+  // the characters are counted
+  std::vector<std::string> token_texts;
+  std::vector<int> token_types;
+  std::unordered_map<std::string, int> frequency;
+  sentence_begin_.push_back(0);
+  while (status->ok() && !fd->Eof()) {
+    fd->ReadLine(line, kLineMax, status);
+    if (!status->ok()) break;
+
+    for (char *word = strtok(line, " \t\r\n"); word != nullptr;
+         word = strtok(nullptr, " \t\r\n")) {
+      char *slash = strrchr(word, '/');
+      if (slash != nullptr && slash != word) *slash = '\0';
+
+      int token_num = 0;
+      tokenizer.Scan(word);
+      while (tokenizer.GetSentence(&token_instance)) {
+        for (int i = 0; i < token_instance.size(); ++i) {
+          int token_type = token_instance.token_type_at(i);
+          token_texts.push_back(token_instance.token_text_at(i));
+          token_types.push_back(token_type);
+          if (token_type == TokenInstance::kChineseChar) {
+            frequency[token_texts.back()]++;
+          }
+          tags_.push_back(PerceptronModel::kM);
+          token_num++;
+        }
+      }
+
+      if (token_num == 1) {
+        tags_.back() = PerceptronModel::kS;
+      } else if (token_num > 1) {
+        tags_[tags_.size() - token_num] = PerceptronModel::kB;
+        tags_.back() = PerceptronModel::kE;
+      }
+    }
+
+    if (sentence_begin_.back() != static_cast<int>(tags_.size())) {
+      sentence_begin_.push_back(tags_.size());
+    }
+  }
+
+  if (status->ok() && tags_.empty()) {
+    *status = Status::Corruption(corpus_path);
+  }
+
+  std::vector<std::string> characters;
+  for (auto &item : frequency) {
+    if (item.second >= min_frequency) characters.push_back(item.first);
+  }
+  if (status->ok() && characters.empty()) {
+    *status = Status::Corruption("no Chinese character in corpus");
+  }
+
+  if (status->ok()) {
+    character_num_ = characters.size();
+    model_ = PerceptronModel::NewEmpty(characters, bucket_bits);
+    ids_.resize(token_texts.size());
+    for (size_t i = 0; i < token_texts.size(); ++i) {
+      ids_[i] = model_->token_id(token_texts[i].c_str(), token_types[i]);
+    }
+  }
+
+  delete fd;
+  delete[] line;
+}
+
+void PerceptronTrainer::Update(float *weight,
+                               double *sum,
+                               int64_t *updated_step,
+                               float delta) {
+  *sum += (step_ - *updated_step) * static_cast<double>(*weight);
+  *updated_step = step_;
+  *weight += delta;
+}
+
+int PerceptronTrainer::TrainSentence(int sentence) {
+  const int S = PerceptronModel::kS;
+  const int tag_num = PerceptronModel::kTagNum;
+  int begin = sentence_begin_[sentence];
+  int size = sentence_begin_[sentence + 1] - begin;
+  const int *ids = ids_.data() + begin;
+  const int *tags = tags_.data() + begin;
+
+  predicted_tags_.resize(size);
+  model_->Decode(ids, size, 0, size, &scores_, &backs_, predicted_tags_.data());
+
+  int error_num = 0;
+  float *weights = model_->weights();
+  int buckets[PerceptronModel::kFeatureNum];
+  for (int i = 0; i < size; ++i) {
+    int tag = tags[i];
+    int predicted_tag = predicted_tags_[i];
+    if (tag == predicted_tag) continue;
+
+    error_num++;
+    model_->FeatureBuckets(ids, size, i, buckets);
+    for (int bucket : buckets) {
+      int index = bucket * tag_num + tag;
+      Update(weights + index,
+             &weight_sums_[index],
+             &weight_steps_[index],
+             1.0f);
+      index = bucket * tag_num + predicted_tag;
+      Update(weights + index,
+             &weight_sums_[index],
+             &weight_steps_[index],
+             -1.0f);
+    }
+  }
+
+  // The transitions from the S before sentence and to the S after it are
+  // updated too
+  if (error_num > 0) {
+    float *transitions = model_->transitions();
+    for (int i = 0; i <= size; ++i) {
+      int left = i > 0? tags[i - 1]: S;
+      int right = i < size? tags[i]: S;
+      int predicted_left = i > 0? predicted_tags_[i - 1]: S;
+      int predicted_right = i < size? predicted_tags_[i]: S;
+      if (left == predicted_left && right == predicted_right) continue;
+
+      int index = left * tag_num + right;
+      Update(transitions + index,
+             &transition_sums_[index],
+             &transition_steps_[index],
+             1.0f);
+      index = predicted_left * tag_num + predicted_right;
+      Update(transitions + index,
+             &transition_sums_[index],
+             &transition_steps_[index],
+             -1.0f);
+    }
+  }
+
+  step_++;
+  return error_num;
+}
+
+void PerceptronTrainer::Train(int iteration_num,
+                              void (* progress)(int iteration,
+                                                double error_rate)) {
+  std::vector<int> order(sentence_num());
+  for (int i = 0; i < sentence_num(); ++i) order[i] = i;
+  std::mt19937 random_engine(kShuffleSeed);
+
+  for (int iteration = 1; iteration <= iteration_num; ++iteration) {
+    std::shuffle(order.begin(), order.end(), random_engine);
+    int64_t error_num = 0;
+    for (int sentence : order) error_num += TrainSentence(sentence);
+
+    if (progress) {
+      progress(iteration, static_cast<double>(error_num) / token_num());
+    }
+  }
+}
+
+void PerceptronTrainer::Save(const char *model_path, Status *status) {
+  float *weights = model_->weights();
+  float *transitions = model_->transitions();
+  int transition_num = PerceptronModel::kTagNum * PerceptronModel::kTagNum;
+
+  // Replaces the weights with the averaged ones while saving
+  std::vector<float> current_weights(weights, weights + model_->weight_num());
+  std::vector<float> current_transitions(transitions,
+                                         transitions + transition_num);
+  if (step_ > 0) {
+    for (int i = 0; i < model_->weight_num(); ++i) {
+      double sum = weight_sums_[i] + (step_ - weight_steps_[i]) *
+                                     static_cast<double>(weights[i]);
+      weights[i] = static_cast<float>(sum / step_);
+    }
+    for (int i = 0; i < transition_num; ++i) {
+      double sum = transition_sums_[i] + (step_ - transition_steps_[i]) *
+                                         static_cast<double>(transitions[i]);
+      transitions[i] = static_cast<float>(sum / step_);
+    }
+  }
+
+  model_->Save(model_path, status);
+
+  std::copy(current_weights.begin(), current_weights.end(), weights);
+  std::copy(current_transitions.begin(),
+            current_transitions.end(),
+            transitions);
+}
+
+}  // namespace milkcat
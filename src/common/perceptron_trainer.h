@@ -0,0 +1,115 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_trainer.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_COMMON_PERCEPTRON_TRAINER_H_
+#define SRC_COMMON_PERCEPTRON_TRAINER_H_
+
+#include <stdint.h>
+#include <vector>
+#include "milkcat/perceptron_model.h"
+#include "utils/utils.h"
+#include "utils/status.h"
+
+namespace milkcat {
+
+// Trains the averaged perceptron model of PerceptronSegmenter from a
+// segmented corpus. The words are split into tokens by the tokenizer of
+// MilkCat and tagged with B, M, E, S. The averaged weights are computed
+// lazily, a weight is only touched when it is updated
+class PerceptronTrainer {
+ public:
+  static const int kDefaultIteration = 10;
+  static const int kDefaultMinFrequency = 1;
+
+  // Reads the corpus in corpus_path, each line of it is a sentence of words
+  // separated by spaces, the part-of-speech tags in "word/tag" are ignored.
+  // The Chinese characters appear less than min_frequency times are taken as
+  // unknown characters. The model has 2 ^ bucket_bits buckets of weights
+  static PerceptronTrainer *New(const char *corpus_path,
+                                int bucket_bits,
+                                int min_frequency,
+                                Status *status);
+
+  ~PerceptronTrainer();
+
+  // Trains iteration_num passes over the sentences in random order. If
+  // progress is not nullptr it is called after each pass with the token
+  // error rate of that pass
+  void Train(int iteration_num,
+             void (* progress)(int iteration, double error_rate));
+
+  // Saves the averaged model
+  void Save(const char *model_path, Status *status);
+
+  int sentence_num() const { return sentence_begin_.size() - 1; }
+  int token_num() const { return tags_.size(); }
+  int character_num() const { return character_num_; }
+
+ private:
+  PerceptronModel *model_;
+  int character_num_;
+
+  // Training data. The tokens of sentence i are [sentence_begin_[i],
+  // sentence_begin_[i + 1]) of ids_ and tags_
+  std::vector<int> sentence_begin_;
+  std::vector<int> ids_;
+  std::vector<int> tags_;
+
+  // For each weight of the features and the transitions, the sum of its
+  // values before the step it is last updated
+  std::vector<double> weight_sums_;
+  std::vector<int64_t> weight_steps_;
+  std::vector<double> transition_sums_;
+  std::vector<int64_t> transition_steps_;
+  int64_t step_;
+
+  // Decoded tags of a sentence and the buffers of decoding
+  std::vector<int> predicted_tags_;
+  std::vector<float> scores_;
+  std::vector<int> backs_;
+
+  PerceptronTrainer();
+
+  // Reads the sentences in corpus_path, builds the model and converts the
+  // sentences into the token ids
+  void ReadCorpus(const char *corpus_path,
+                  int bucket_bits,
+                  int min_frequency,
+                  Status *status);
+
+  // Decodes sentence and updates the weights if it is wrong, returns the
+  // number of wrongly tagged tokens
+  int TrainSentence(int sentence);
+
+  // Adds delta to weight, whose sum and step are in sum and updated_step
+  void Update(float *weight, double *sum, int64_t *updated_step, float delta);
+
+  DISALLOW_COPY_AND_ASSIGN(PerceptronTrainer);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_COMMON_PERCEPTRON_TRAINER_H_
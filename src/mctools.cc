@@ -35,14 +35,25 @@
 #include <map>
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <random>
 #include <thread>
 #include <set>
+#include "common/crf_trainer.h"
 #include "common/get_vocabulary.h"
+#include "common/hmm_trainer.h"
+#include "common/perceptron_trainer.h"
 #include "utils/utils.h"
 #include "utils/readable_file.h"
 #include "utils/writable_file.h"
+#include "milkcat/crf_part_of_speech_tagger.h"
+#include "milkcat/greedy_part_of_speech_tagger.h"
 #include "milkcat/hmm_part_of_speech_tagger.h"
+#include "milkcat/libmilkcat.h"
 #include "milkcat/milkcat.h"
+#include "milkcat/simd_kernel.h"
+#include "milkcat/tokenizer.h"
+#include "milkcat/token_instance.h"
 #include "milkcat/static_hashtable.h"
 #include "milkcat/darts.h"
 #include "neko/maxent_classifier.h"
@@ -298,17 +309,52 @@ int MakeIndexFile(int argc, char **argv) {
   return 0;
 }
 
+// Makes the binary HMM tagger model from the text model files. The order of
+// transitions is specified by option -o, 2 for tag trigrams (default) and 1
+// for tag bigrams
 int MakeHMMTaggerModel(int argc, char **argv) {
   Status status;
-  if (argc != 7)
-    status = Status::Info("Usage: mctools hmm index-file tag-set-file "
-                          "trans-file emit-file binary-model-file");
+  char message[1024];
+  int c = '\0';
+  int order = 2;
+
+  while ((c = getopt(argc, argv, "o:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'o':
+        order = atoi(optarg);
+        if (order != 1 && order != 2) {
+          status = Status::Info("Option -o: order should be 1 or 2");
+        }
+        break;
 
-  const char *index_file = argv[2];
-  const char *yset_file = argv[3];
-  const char *trans_file = argv[4];
-  const char *emit_file = argv[5];
-  const char *model_file = argv[6];
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 5) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools hmm [-o order] index-file tag-set-file trans-file "
+         "emit-file binary-model-file");
+    return -1;
+  }
+
+  const char *index_file = argv[optind];
+  const char *yset_file = argv[optind + 1];
+  const char *trans_file = argv[optind + 2];
+  const char *emit_file = argv[optind + 3];
+  const char *model_file = argv[optind + 4];
 
   HMMModel *hmm_model = nullptr;
   if (status.ok()) {
@@ -316,6 +362,7 @@ int MakeHMMTaggerModel(int argc, char **argv) {
                                       emit_file,
                                       yset_file,
                                       index_file,
+                                      order,
                                       &status);
   }
   if (status.ok()) hmm_model->Save(model_file, &status);
@@ -353,6 +400,143 @@ int MakeMaxentFile(int argc, char **argv) {
   }
 }
 
+// Gets the term type of word like the segmenters: a word of one token has the
+// type of the token, otherwise it is a Chinese word
+int WordTermType(const char *word,
+                 Tokenization *tokenizer,
+                 TokenInstance *token_instance) {
+  int token_num = 0, token_type = TokenInstance::kOther;
+  tokenizer->Scan(word);
+  while (tokenizer->GetSentence(token_instance)) {
+    if (token_num == 0 && token_instance->size() > 0)
+      token_type = token_instance->token_type_at(0);
+    token_num += token_instance->size();
+  }
+
+  return token_num == 1? TokenTypeToTermType(token_type):
+                         TermInstance::kChineseWord;
+}
+
+// Extracts the training events of greedy part-of-speech tagger from corpus,
+// each line of corpus is a sentence of "word/tag" separated by spaces. Each
+// line of events file is the tag and the features of a word
+void ExtractGreedyTaggerEvents(const char *corpus_file,
+                               const char *events_file,
+                               Status *status) {
+  int buf_size = 1024 * 1024;
+  char *buf = new char[buf_size];
+  ReadableFile *fd = nullptr;
+  WritableFile *wfd = nullptr;
+
+  Tokenization tokenizer;
+  TokenInstance token_instance;
+  TermInstance term_instance;
+  std::vector<std::string> tags, features;
+  std::string line;
+
+  fd = ReadableFile::New(corpus_file, status);
+  if (status->ok()) wfd = WritableFile::New(events_file, status);
+  while (status->ok() && !fd->Eof()) {
+    fd->ReadLine(buf, buf_size, status);
+
+    // Reads words and tags into term_instance and tags
+    int term_num = 0;
+    tags.clear();
+    char *word = strtok(buf, " \t\r\n");
+    while (status->ok() && word != nullptr && term_num < kTokenMax) {
+      char *slash = strrchr(word, '/');
+      if (slash == nullptr || slash == word) {
+        std::string message = std::string("Invalid word: ") + word;
+        *status = Status::Corruption(message.c_str());
+      } else {
+        *slash = '\0';
+        term_instance.set_value_at(
+            term_num,
+            word,
+            1,
+            WordTermType(word, &tokenizer, &token_instance));
+        tags.push_back(slash + 1);
+        ++term_num;
+      }
+      word = strtok(nullptr, " \t\r\n");
+    }
+    term_instance.set_size(term_num);
+
+    for (int i = 0; i < term_num && status->ok(); ++i) {
+      GreedyPartOfSpeechTagger::ExtractFeatures(
+          &term_instance,
+          i,
+          i >= 2? tags[i - 2].c_str(): "BOS",
+          i >= 1? tags[i - 1].c_str(): "BOS",
+          &features);
+      line = tags[i];
+      for (const std::string &feature : features) line += " " + feature;
+      wfd->WriteLine(line.c_str(), status);
+    }
+  }
+
+  delete fd;
+  delete wfd;
+  delete[] buf;
+}
+
+// Makes the model of greedy part-of-speech tagger. With option -e, extracts
+// the training events from a tagged corpus, which could be trained by
+// maximum entropy toolkits. Otherwise converts the text model, each line of
+// which is "tag feature cost", to the binary model
+int MakeGreedyTaggerModel(int argc, char **argv) {
+  Status status;
+  char message[1024];
+  int c = '\0';
+  bool extract_events = false;
+
+  while ((c = getopt(argc, argv, "e")) != -1 && status.ok()) {
+    switch (c) {
+      case 'e':
+        extract_events = true;
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 2) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools greedy text-model-file binary-model-file\n"
+         "       mctools greedy -e corpus-file events-file");
+    return -1;
+  }
+
+  if (extract_events) {
+    ExtractGreedyTaggerEvents(argv[optind], argv[optind + 1], &status);
+  } else {
+    MaxentModel *maxent = MaxentModel::NewFromText(argv[optind], &status);
+
+    // Checks the features of the model are the ones of greedy tagger
+    if (status.ok() && maxent->feature_id("T-1:BOS") ==
+                       MaxentModel::kFeatureIdNone) {
+      status = Status::Corruption("No feature T-1:BOS in model, is it a "
+                                  "model of greedy part-of-speech tagger?");
+    }
+    if (status.ok()) maxent->Save(argv[optind + 1], &status);
+    delete maxent;
+  }
+
+  if (status.ok()) {
+    return 0;
+  } else {
+    puts(status.what());
+    return -1;
+  }
+}
+
 void DisplayProgress(int64_t bytes_processed,
                      int64_t file_size,
                      int64_t bytes_per_second) {
@@ -463,6 +647,838 @@ int CorpusVocabulary(int argc, char **argv) {
   }
 }
 
+// Tags the sentences of corpus with the exact and the pruned CRF tagger and
+// reports the agreement of them and the time they used
+int EvaluatePrunedTagger(int argc, char **argv) {
+  Status status;
+  char message[1024],
+       model_path[1024] = MODEL_PATH;
+  int c = '\0';
+  int top_k = CRFTagger::kDefaultPruneTopK;
+  float delta = CRFTagger::kDefaultPruneDelta;
+
+  while ((c = getopt(argc, argv, "d:k:e:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'd':
+        strcpy(model_path, optarg);
+        if (model_path[strlen(model_path) - 1] != '/') 
+          strcat(model_path, "/");
+        break;
+
+      case 'k':
+        top_k = atoi(optarg);
+        if (top_k <= 0) status = Status::Info("Option -k: invalid top-k");
+        break;
+
+      case 'e':
+        delta = static_cast<float>(atof(optarg));
+        if (!(delta >= 0)) status = Status::Info("Option -e: invalid delta");
+        break;
+
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 1) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools prune [-d model_dir] [-k top_k] [-e delta] "
+         "corpus_file");
+  }
+
+  ModelFactory model_factory(model_path);
+  ReadableFile *fd = nullptr;
+  Segmenter *segmenter = nullptr;
+  const CRFModel *crf_model = nullptr;
+  if (status.ok()) fd = ReadableFile::New(argv[optind], &status);
+  if (status.ok()) {
+    milkcat_config_t config;
+    milkcat_config_init(&config, MC_PROFILE_DEFAULT);
+    config.analyzer_type = SEGMENTER_MIXED;
+    segmenter = SegmenterFactory(&model_factory, &config, &status);
+  }
+  if (status.ok()) crf_model = model_factory.CRFPosModel(&status);
+
+  int64_t word_num = 0, agreed_num = 0;
+  double exact_seconds = 0, pruned_seconds = 0;
+  if (status.ok()) {
+    CRFPartOfSpeechTagger exact_tagger(crf_model), pruned_tagger(crf_model);
+    pruned_tagger.crf_tagger()->set_pruning(top_k, delta);
+
+    Tokenization tokenizer;
+    TokenInstance token_instance;
+    TermInstance term_instance;
+    PartOfSpeechTagInstance exact_result, pruned_result;
+    char *line = new char[1024 * 1024];
+    while (status.ok() && !fd->Eof()) {
+      fd->ReadLine(line, 1024 * 1024, &status);
+      if (!status.ok()) break;
+
+      tokenizer.Scan(line);
+      while (tokenizer.GetSentence(&token_instance)) {
+        segmenter->Segment(&term_instance, &token_instance);
+
+        auto start = std::chrono::steady_clock::now();
+        exact_tagger.Tag(&exact_result, &term_instance);
+        auto middle = std::chrono::steady_clock::now();
+        pruned_tagger.Tag(&pruned_result, &term_instance);
+        auto end = std::chrono::steady_clock::now();
+        exact_seconds += std::chrono::duration<double>(middle - start).count();
+        pruned_seconds += std::chrono::duration<double>(end - middle).count();
+
+        for (int i = 0; i < term_instance.size(); ++i) {
+          if (exact_result.tag_id_at(i) == pruned_result.tag_id_at(i)) {
+            agreed_num++;
+          }
+        }
+        word_num += term_instance.size();
+      }
+    }
+    delete[] line;
+  }
+
+  if (status.ok()) {
+    printf("top-k = %d, delta = %.2f\n", top_k, delta);
+    printf("words: %lld, agreement with exact Viterbi: %.4f%%\n",
+           static_cast<long long>(word_num),
+           word_num? 100.0 * agreed_num / word_num: 100.0);
+    printf("exact: %.3fs, pruned: %.3fs\n", exact_seconds, pruned_seconds);
+  }
+
+  delete segmenter;
+  delete fd;
+
+  if (status.ok()) {
+    return 0;
+  } else {
+    if (*status.what()) puts(status.what());
+    return -1;
+  }
+}
+
+// Tags the sentences of corpus_path segmented by segmenter with the CRF
+// part-of-speech tagger using kernel. kSimdLaneNum sentences are tagged one
+// by one and then together in lanes, the tags of both are appended to tags
+void TagCorpusWithKernel(const char *corpus_path,
+                         Segmenter *segmenter,
+                         const CRFModel *crf_model,
+                         const SimdKernel *kernel,
+                         std::vector<int> *tags,
+                         double *seconds,
+                         Status *status) {
+  ReadableFile *fd = ReadableFile::New(corpus_path, status);
+  CRFPartOfSpeechTagger tagger(crf_model);
+  tagger.crf_tagger()->set_kernel(kernel);
+
+  Tokenization tokenizer;
+  TokenInstance token_instance;
+  TermInstance term_instances[kSimdLaneNum];
+  PartOfSpeechTagInstance tag_instances[kSimdLaneNum];
+  TermInstance *term_instance_ptrs[kSimdLaneNum];
+  PartOfSpeechTagInstance *tag_instance_ptrs[kSimdLaneNum];
+  for (int i = 0; i < kSimdLaneNum; ++i) {
+    term_instance_ptrs[i] = term_instances + i;
+    tag_instance_ptrs[i] = tag_instances + i;
+  }
+
+  int sentence_num = 0;
+  bool eof = false;
+  char *line = new char[1024 * 1024];
+  *seconds = 0;
+  while (status->ok() && !(eof && sentence_num == 0)) {
+    // Fill the lanes with sentences
+    while (status->ok() && !eof && sentence_num < kSimdLaneNum) {
+      if (tokenizer.GetSentence(&token_instance)) {
+        segmenter->Segment(term_instances + sentence_num, &token_instance);
+        sentence_num++;
+      } else if (fd->Eof()) {
+        eof = true;
+      } else {
+        fd->ReadLine(line, 1024 * 1024, status);
+        if (status->ok()) tokenizer.Scan(line);
+      }
+    }
+    if (!status->ok() || sentence_num == 0) break;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < sentence_num; ++i) {
+      tagger.Tag(tag_instances + i, term_instances + i);
+      for (int j = 0; j < term_instances[i].size(); ++j) {
+        tags->push_back(tag_instances[i].tag_id_at(j));
+      }
+    }
+    tagger.TagBatch(tag_instance_ptrs, term_instance_ptrs, sentence_num);
+    for (int i = 0; i < sentence_num; ++i) {
+      for (int j = 0; j < term_instances[i].size(); ++j) {
+        tags->push_back(tag_instances[i].tag_id_at(j));
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    *seconds += std::chrono::duration<double>(end - start).count();
+    sentence_num = 0;
+  }
+
+  delete[] line;
+  delete fd;
+}
+
+// Tag numbers of the random inputs in CompareKernelOnRandomInputs. The ones
+// that are not multiples of 4 or 8 check the tail loops of the kernels
+const int kCheckTagNums[] = {1, 2, 3, 4, 5, 7, 8, 9, 12, 13, 16, 17, 31, 33};
+const int kCheckDataSize = 4096;
+const int kCheckRepeatNum = 8;
+const float kCheckTolerance = 1e-5f;
+
+// Compares n float outputs of a kernel with the expected outputs of scalar
+// kernel. The difference is relative to the larger one of min_scale and the
+// values
+void CompareOutputs(const float *output,
+                    const float *expected,
+                    int n,
+                    float min_scale,
+                    int64_t *compared_num,
+                    int64_t *differed_num) {
+  for (int i = 0; i < n; ++i) {
+    float scale = std::max(min_scale,
+                           std::max(fabsf(output[i]), fabsf(expected[i])));
+    if (!(fabsf(output[i] - expected[i]) <= kCheckTolerance * scale)) {
+      (*differed_num)++;
+    }
+  }
+  *compared_num += n;
+}
+
+// Compares n tag or context outputs of a kernel with the expected outputs
+void CompareOutputs(const int *output,
+                    const int *expected,
+                    int n,
+                    int64_t *compared_num,
+                    int64_t *differed_num) {
+  for (int i = 0; i < n; ++i) {
+    if (output[i] != expected[i]) (*differed_num)++;
+  }
+  *compared_num += n;
+}
+
+// Runs add_rows, max_plus_arc, exp, lane_max_plus_arc and min_plus_trans of
+// kernel and scalar kernel on the same random inputs from random_engine, and
+// compares the outputs
+void CompareKernelOnRandomInputs(const SimdKernel *kernel,
+                                 const SimdKernel *scalar,
+                                 std::mt19937 *random_engine,
+                                 int64_t *compared_num,
+                                 int64_t *differed_num) {
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  std::vector<float> cost_data(kCheckDataSize);
+  for (float &value : cost_data) value = uniform(*random_engine);
+
+  for (int tag_num : kCheckTagNums) {
+    std::uniform_int_distribution<int> offset_distribution(
+        0,
+        kCheckDataSize - tag_num * tag_num);
+    for (int repeat = 0; repeat < kCheckRepeatNum; ++repeat) {
+      int offset_num = repeat % 5;
+      std::vector<int> offsets(offset_num);
+      for (int &offset : offsets) offset = offset_distribution(*random_engine);
+
+      std::vector<float> left_cost(tag_num);
+      for (float &value : left_cost) value = uniform(*random_engine);
+
+      // add_rows
+      std::vector<float> cost(left_cost), expected_cost(left_cost);
+      kernel->add_rows(cost.data(),
+                       cost_data.data(),
+                       offsets.data(),
+                       offset_num,
+                       tag_num);
+      scalar->add_rows(expected_cost.data(),
+                       cost_data.data(),
+                       offsets.data(),
+                       offset_num,
+                       tag_num);
+      CompareOutputs(cost.data(),
+                     expected_cost.data(),
+                     tag_num,
+                     1.0f,
+                     compared_num,
+                     differed_num);
+
+      // max_plus_arc
+      std::vector<int> left_tag(tag_num), expected_left_tag(tag_num);
+      kernel->max_plus_arc(cost.data(),
+                           left_tag.data(),
+                           left_cost.data(),
+                           cost_data.data(),
+                           offsets.data(),
+                           offset_num,
+                           tag_num);
+      scalar->max_plus_arc(expected_cost.data(),
+                           expected_left_tag.data(),
+                           left_cost.data(),
+                           cost_data.data(),
+                           offsets.data(),
+                           offset_num,
+                           tag_num);
+      CompareOutputs(cost.data(),
+                     expected_cost.data(),
+                     tag_num,
+                     1.0f,
+                     compared_num,
+                     differed_num);
+      CompareOutputs(left_tag.data(),
+                     expected_left_tag.data(),
+                     tag_num,
+                     compared_num,
+                     differed_num);
+
+      // exp, the inputs cover the range flushed to 0
+      std::vector<float> x(tag_num);
+      for (float &value : x) value = 50.0f * uniform(*random_engine) - 40.0f;
+      float bias = 10.0f * uniform(*random_engine);
+      kernel->exp(cost.data(), x.data(), bias, tag_num);
+      scalar->exp(expected_cost.data(), x.data(), bias, tag_num);
+      CompareOutputs(cost.data(),
+                     expected_cost.data(),
+                     tag_num,
+                     1e-30f,
+                     compared_num,
+                     differed_num);
+
+      // lane_max_plus_arc, the offset of a feature is either the same in all
+      // lanes or different in each lane, and -1 sometimes
+      int lane_size = tag_num * kSimdLaneNum;
+      std::vector<int> lane_offsets(offset_num * kSimdLaneNum);
+      for (int i = 0; i < offset_num; ++i) {
+        bool same_offset = uniform(*random_engine) < 0.0f;
+        for (int lane = 0; lane < kSimdLaneNum; ++lane) {
+          int &offset = lane_offsets[i * kSimdLaneNum + lane];
+          if (same_offset && lane > 0) {
+            offset = lane_offsets[i * kSimdLaneNum];
+          } else if (uniform(*random_engine) < -0.6f) {
+            offset = -1;
+          } else {
+            offset = offset_distribution(*random_engine);
+          }
+        }
+      }
+      std::vector<float> lane_left_cost(lane_size);
+      for (float &value : lane_left_cost) value = uniform(*random_engine);
+      std::vector<float> lane_cost(lane_size), expected_lane_cost(lane_size);
+      std::vector<int> lane_left_tag(lane_size),
+                       expected_lane_left_tag(lane_size);
+      kernel->lane_max_plus_arc(lane_cost.data(),
+                                lane_left_tag.data(),
+                                lane_left_cost.data(),
+                                cost_data.data(),
+                                lane_offsets.data(),
+                                offset_num,
+                                tag_num);
+      scalar->lane_max_plus_arc(expected_lane_cost.data(),
+                                expected_lane_left_tag.data(),
+                                lane_left_cost.data(),
+                                cost_data.data(),
+                                lane_offsets.data(),
+                                offset_num,
+                                tag_num);
+      CompareOutputs(lane_cost.data(),
+                     expected_lane_cost.data(),
+                     lane_size,
+                     1.0f,
+                     compared_num,
+                     differed_num);
+      CompareOutputs(lane_left_tag.data(),
+                     expected_lane_left_tag.data(),
+                     lane_size,
+                     compared_num,
+                     differed_num);
+
+      // min_plus_trans, the candidate tags are picked from a larger tag set
+      int context_num = repeat + 1;
+      int row_size = tag_num + 5;
+      std::vector<float> trans(context_num * row_size);
+      for (float &value : trans) value = uniform(*random_engine);
+      std::vector<const float *> trans_rows(context_num);
+      for (int i = 0; i < context_num; ++i) {
+        trans_rows[i] = trans.data() + i * row_size;
+      }
+      std::uniform_int_distribution<int> tag_distribution(0, row_size - 1);
+      std::vector<int> tags(tag_num);
+      for (int &tag : tags) tag = tag_distribution(*random_engine);
+      std::vector<float> context_cost(context_num);
+      for (float &value : context_cost) value = uniform(*random_engine);
+      std::vector<int> context(tag_num), expected_context(tag_num);
+      kernel->min_plus_trans(cost.data(),
+                             context.data(),
+                             context_cost.data(),
+                             trans_rows.data(),
+                             context_num,
+                             tags.data(),
+                             tag_num);
+      scalar->min_plus_trans(expected_cost.data(),
+                             expected_context.data(),
+                             context_cost.data(),
+                             trans_rows.data(),
+                             context_num,
+                             tags.data(),
+                             tag_num);
+      CompareOutputs(cost.data(),
+                     expected_cost.data(),
+                     tag_num,
+                     1.0f,
+                     compared_num,
+                     differed_num);
+      CompareOutputs(context.data(),
+                     expected_context.data(),
+                     tag_num,
+                     compared_num,
+                     differed_num);
+    }
+  }
+}
+
+// Checks each SIMD kernel supported by current CPU against the scalar kernel.
+// First the kernels run on random inputs, then if corpus is given the
+// sentences of corpus are tagged with the CRF part-of-speech tagger using each
+// kernel, and the tags should be exactly the same as the tags of scalar kernel
+int CheckSimdKernels(int argc, char **argv) {
+  Status status;
+  char message[1024],
+       model_path[1024] = MODEL_PATH;
+  int c = '\0';
+
+  while ((c = getopt(argc, argv, "d:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'd':
+        strcpy(model_path, optarg);
+        if (model_path[strlen(model_path) - 1] != '/')
+          strcat(model_path, "/");
+        break;
+
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind > 1) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools simd [-d model_dir] [corpus_file]");
+  }
+
+  const char *kernel_names[] = {"sse", "avx2"};
+  const SimdKernel *scalar = GetSimdKernel("scalar");
+  bool all_agreed = true;
+  for (const char *kernel_name : kernel_names) {
+    if (!status.ok()) break;
+    const SimdKernel *kernel = GetSimdKernel(kernel_name);
+    if (kernel == nullptr) {
+      printf("%s: not supported by CPU\n", kernel_name);
+      continue;
+    }
+
+    std::mt19937 random_engine(20131108);
+    int64_t compared_num = 0, differed_num = 0;
+    CompareKernelOnRandomInputs(kernel,
+                                scalar,
+                                &random_engine,
+                                &compared_num,
+                                &differed_num);
+    if (differed_num != 0) all_agreed = false;
+
+    printf("%s: %lld random outputs, %lld differ from scalar\n",
+           kernel_name,
+           static_cast<long long>(compared_num),
+           static_cast<long long>(differed_num));
+  }
+
+  bool has_corpus = argc - optind == 1;
+  ModelFactory model_factory(model_path);
+  Segmenter *segmenter = nullptr;
+  const CRFModel *crf_model = nullptr;
+  if (status.ok() && has_corpus) {
+    milkcat_config_t config;
+    milkcat_config_init(&config, MC_PROFILE_DEFAULT);
+    config.analyzer_type = SEGMENTER_MIXED;
+    segmenter = SegmenterFactory(&model_factory, &config, &status);
+  }
+  if (status.ok() && has_corpus) {
+    crf_model = model_factory.CRFPosModel(&status);
+  }
+
+  // The first kernel is scalar, which is the reference of others
+  const char *corpus_kernel_names[] = {"scalar", "sse", "avx2"};
+  std::vector<int> scalar_tags, tags;
+  for (const char *kernel_name : corpus_kernel_names) {
+    if (!status.ok() || !has_corpus) break;
+    const SimdKernel *kernel = GetSimdKernel(kernel_name);
+    if (kernel == nullptr) {
+      printf("%s: not supported by CPU\n", kernel_name);
+      continue;
+    }
+
+    double seconds = 0;
+    tags.clear();
+    TagCorpusWithKernel(argv[optind],
+                        segmenter,
+                        crf_model,
+                        kernel,
+                        &tags,
+                        &seconds,
+                        &status);
+    if (!status.ok()) break;
+    if (kernel == GetSimdKernel("scalar")) scalar_tags = tags;
+
+    int64_t differed_num = 0;
+    if (tags.size() != scalar_tags.size()) {
+      differed_num = std::max(tags.size(), scalar_tags.size());
+    } else {
+      for (size_t i = 0; i < tags.size(); ++i) {
+        if (tags[i] != scalar_tags[i]) differed_num++;
+      }
+    }
+    if (differed_num != 0) all_agreed = false;
+
+    printf("%s: %lld tags, %lld differ from scalar, %.3fs\n",
+           kernel_name,
+           static_cast<long long>(tags.size()),
+           static_cast<long long>(differed_num),
+           seconds);
+  }
+
+  delete segmenter;
+
+  if (status.ok() && !all_agreed) {
+    status = Status::RuntimeError("outputs of SIMD kernels differ from scalar");
+  }
+
+  if (status.ok()) {
+    return 0;
+  } else {
+    if (*status.what()) puts(status.what());
+    return -1;
+  }
+}
+
+// Counts the HMM tagger model from a tagged corpus of "word/TAG" and saves
+// it as the binary model
+int TrainHMMTaggerModel(int argc, char **argv) {
+  Status status;
+  char message[1024];
+  int c = '\0';
+  int order = 2;
+  int thread_num = std::thread::hardware_concurrency();
+
+  while ((c = getopt(argc, argv, "o:t:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'o':
+        order = atoi(optarg);
+        if (order != 1 && order != 2) {
+          status = Status::Info("Option -o: order should be 1 or 2");
+        }
+        break;
+
+      case 't':
+        thread_num = atoi(optarg);
+        if (thread_num <= 0) {
+          status = Status::Info("Option -t: invalid thread number");
+        }
+        break;
+
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 3) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools hmm-train [-o order] [-t thread_num] index-file "
+         "corpus-file binary-model-file");
+    return -1;
+  }
+
+  const char *index_file = argv[optind];
+  const char *corpus_file = argv[optind + 1];
+  const char *model_file = argv[optind + 2];
+
+  auto start = std::chrono::steady_clock::now();
+  HMMTrainer *trainer = HMMTrainer::New(corpus_file,
+                                        thread_num,
+                                        DisplayProgress,
+                                        &status);
+  HMMModel *hmm_model = nullptr;
+  if (status.ok()) {
+    auto end = std::chrono::steady_clock::now();
+    printf("\nNumber of sentences: %ld\n",
+           static_cast<long>(trainer->sentence_num()));
+    printf("Number of tokens:    %ld\n",
+           static_cast<long>(trainer->token_num()));
+    printf("Number of tags:      %d\n", trainer->tag_num() - 1);
+    printf("Number of words:     %d\n", trainer->word_num());
+    printf("Number of threads:   %d\n", thread_num);
+    printf("Counting time: %.2fs\n",
+           std::chrono::duration<double>(end - start).count());
+
+    hmm_model = trainer->Train(index_file, order, &status);
+  }
+
+  if (status.ok()) {
+    printf("Lambdas: %.4f %.4f %.4f\n",
+           trainer->lambda(0),
+           trainer->lambda(1),
+           trainer->lambda(2));
+    printf("Save model: %s\n", model_file);
+    hmm_model->Save(model_file, &status);
+  }
+
+  delete hmm_model;
+  delete trainer;
+  if (status.ok()) {
+    return 0;
+  } else {
+    puts(status.what());
+    return -1;
+  }
+}
+
+void DisplayTrainingProgress(int iteration,
+                             double error_rate,
+                             double objective,
+                             double difference) {
+  printf("iter=%d terr=%.5f obj=%.5f diff=%.5f\n",
+         iteration,
+         error_rate,
+         objective,
+         difference);
+  fflush(stdout);
+}
+
+// Trains the CRF model from the training data and templates in CRF++ format
+int TrainCRFModel(int argc, char **argv) {
+  Status status;
+  char message[1024];
+  int c = '\0';
+  double cost = CRFTrainer::kDefaultCost;
+  double eta = CRFTrainer::kDefaultEta;
+  int min_frequency = CRFTrainer::kDefaultMinFrequency;
+  int max_iteration = CRFTrainer::kDefaultMaxIteration;
+  int thread_num = std::thread::hardware_concurrency();
+
+  while ((c = getopt(argc, argv, "c:e:f:m:t:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'c':
+        cost = atof(optarg);
+        if (cost <= 0) status = Status::Info("Option -c: invalid cost");
+        break;
+
+      case 'e':
+        eta = atof(optarg);
+        break;
+
+      case 'f':
+        min_frequency = atoi(optarg);
+        break;
+
+      case 'm':
+        max_iteration = atoi(optarg);
+        break;
+
+      case 't':
+        thread_num = atoi(optarg);
+        if (thread_num <= 0) {
+          status = Status::Info("Option -t: invalid thread number");
+        }
+        break;
+
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 3) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools crf-train [-c cost] [-e eta] [-f min_frequency] "
+         "[-m max_iteration] [-t thread_num] template_file train_file "
+         "model_file");
+    return -1;
+  }
+
+  const char *template_file = argv[optind];
+  const char *train_file = argv[optind + 1];
+  const char *model_file = argv[optind + 2];
+
+  CRFTrainer *trainer = CRFTrainer::New(template_file,
+                                        train_file,
+                                        min_frequency,
+                                        &status);
+  if (status.ok()) {
+    printf("Number of sentences: %d\n", trainer->sentence_num());
+    printf("Number of tokens:    %d\n", trainer->token_num());
+    printf("Number of tags:      %d\n", trainer->tag_num());
+    printf("Number of features:  %d\n", trainer->feature_num());
+    printf("Number of weights:   %d\n", trainer->weight_num());
+    printf("Number of threads:   %d\n", thread_num);
+
+    auto start = std::chrono::steady_clock::now();
+    trainer->Train(cost,
+                   max_iteration,
+                   eta,
+                   thread_num,
+                   DisplayTrainingProgress,
+                   &status);
+    auto end = std::chrono::steady_clock::now();
+    printf("Training time: %.2fs\n",
+           std::chrono::duration<double>(end - start).count());
+  }
+
+  if (status.ok()) {
+    printf("Save model: %s\n", model_file);
+    trainer->Save(model_file, &status);
+  }
+
+  delete trainer;
+  if (status.ok()) {
+    return 0;
+  } else {
+    puts(status.what());
+    return -1;
+  }
+}
+
+void DisplayPerceptronProgress(int iteration, double error_rate) {
+  printf("iter=%d terr=%.5f\n", iteration, error_rate);
+  fflush(stdout);
+}
+
+// Trains the averaged perceptron segmenter model from a segmented corpus
+int TrainPerceptronModel(int argc, char **argv) {
+  Status status;
+  char message[1024];
+  int c = '\0';
+  int bucket_bits = PerceptronModel::kDefaultBucketBits;
+  int min_frequency = PerceptronTrainer::kDefaultMinFrequency;
+  int iteration_num = PerceptronTrainer::kDefaultIteration;
+
+  while ((c = getopt(argc, argv, "b:f:i:")) != -1 && status.ok()) {
+    switch (c) {
+      case 'b':
+        bucket_bits = atoi(optarg);
+        if (bucket_bits <= 0 || bucket_bits > 30) {
+          status = Status::Info("Option -b: invalid bucket bits");
+        }
+        break;
+
+      case 'f':
+        min_frequency = atoi(optarg);
+        break;
+
+      case 'i':
+        iteration_num = atoi(optarg);
+        if (iteration_num <= 0) {
+          status = Status::Info("Option -i: invalid iteration number");
+        }
+        break;
+
+      case ':':
+        sprintf(message, "Option -%c: requires an operand\n", optopt);
+        status = Status::Info(message);
+        break;
+
+      case '?':
+        sprintf(message, "Unrecognized option: -%c\n", optopt);
+        status = Status::Info(message);
+        break;
+    }
+  }
+
+  if (status.ok() && argc - optind != 2) {
+    status = Status::Info("");
+  }
+
+  if (!status.ok()) {
+    if (*status.what()) puts(status.what());
+    puts("Usage: mctools perceptron-train [-b bucket_bits] "
+         "[-f min_frequency] [-i iteration_num] segmented_corpus_file "
+         "model_file");
+    return -1;
+  }
+
+  const char *corpus_file = argv[optind];
+  const char *model_file = argv[optind + 1];
+
+  PerceptronTrainer *trainer = PerceptronTrainer::New(corpus_file,
+                                                      bucket_bits,
+                                                      min_frequency,
+                                                      &status);
+  if (status.ok()) {
+    printf("Number of sentences:  %d\n", trainer->sentence_num());
+    printf("Number of tokens:     %d\n", trainer->token_num());
+    printf("Number of characters: %d\n", trainer->character_num());
+    printf("Number of buckets:    %d\n", 1 << bucket_bits);
+
+    auto start = std::chrono::steady_clock::now();
+    trainer->Train(iteration_num, DisplayPerceptronProgress);
+    auto end = std::chrono::steady_clock::now();
+    printf("Training time: %.2fs\n",
+           std::chrono::duration<double>(end - start).count());
+  }
+
+  if (status.ok()) {
+    printf("Save model: %s\n", model_file);
+    trainer->Save(model_file, &status);
+  }
+
+  delete trainer;
+  if (status.ok()) {
+    return 0;
+  } else {
+    puts(status.what());
+    return -1;
+  }
+}
+
 }  // namespace milkcat
 
 int main(int argc, char **argv) {
@@ -478,13 +1494,27 @@ int main(int argc, char **argv) {
   } else if (strcmp(tool, "gram") == 0) {
     return milkcat::MakeGramModel(argc, argv);
   } else if (strcmp(tool, "hmm") == 0) {
-    return milkcat::MakeHMMTaggerModel(argc, argv);
+    return milkcat::MakeHMMTaggerModel(argc - 1, argv + 1);
+  } else if (strcmp(tool, "hmm-train") == 0) {
+    return milkcat::TrainHMMTaggerModel(argc - 1, argv + 1);
   } else if (strcmp(tool, "maxent") == 0) {
     return milkcat::MakeMaxentFile(argc, argv);
   } else if (strcmp(tool, "vocab") == 0) {
     return milkcat::CorpusVocabulary(argc - 1, argv + 1);
+  } else if (strcmp(tool, "prune") == 0) {
+    return milkcat::EvaluatePrunedTagger(argc - 1, argv + 1);
+  } else if (strcmp(tool, "simd") == 0) {
+    return milkcat::CheckSimdKernels(argc - 1, argv + 1);
+  } else if (strcmp(tool, "crf-train") == 0) {
+    return milkcat::TrainCRFModel(argc - 1, argv + 1);
+  } else if (strcmp(tool, "greedy") == 0) {
+    return milkcat::MakeGreedyTaggerModel(argc - 1, argv + 1);
+  } else if (strcmp(tool, "perceptron-train") == 0) {
+    return milkcat::TrainPerceptronModel(argc - 1, argv + 1);
   } else {
-    fprintf(stderr, "Usage: mc_model [dict|gram|hmm|maxent|vocab]\n");
+    fprintf(stderr,
+            "Usage: mc_model [dict|gram|hmm|hmm-train|maxent|vocab|prune|"
+            "simd|crf-train|greedy|perceptron-train]\n");
     return 1;
   }
 
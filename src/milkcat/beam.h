@@ -41,7 +41,7 @@ class NodePool {
 
   // Alloc a node
   Node *Alloc() {
-    if (alloc_index_ == nodes_.size()) {
+    if (alloc_index_ == static_cast<int>(nodes_.size())) {
       nodes_.push_back(new Node());
     }
     return nodes_[alloc_index_++];
@@ -71,6 +71,26 @@ static inline bool NodePtrCmp(BigramSegmenter::Node *n1,
   return n1->cost < n2->cost;
 }
 
+// If the token at position is stored as a term without decoding, that is
+// neither the token nor its neighbors are Chinese characters. The tokens next
+// to Chinese characters are still decoded since they may be a part of a term
+// in dictionary with the characters, such as "1998年"
+bool IsBypassedToken(const TokenInstance *token_instance, int position) {
+  if (token_instance->token_type_at(position) == TokenInstance::kChineseChar)
+    return false;
+
+  if (position > 0 && token_instance->token_type_at(position - 1) ==
+                      TokenInstance::kChineseChar)
+    return false;
+
+  if (position + 1 < token_instance->size() &&
+      token_instance->token_type_at(position + 1) ==
+      TokenInstance::kChineseChar)
+    return false;
+
+  return true;
+}
+
 }  // namespace
 
 BigramSegmenter::BigramSegmenter(): beam_size_(0),
@@ -81,6 +101,7 @@ BigramSegmenter::BigramSegmenter(): beam_size_(0),
                                     index_(nullptr),
                                     user_index_(nullptr),
                                     has_user_index_(false),
+                                    bypass_non_cjk_(false),
                                     use_disabled_term_ids_(false) {
 }
 
@@ -96,10 +117,11 @@ BigramSegmenter::~BigramSegmenter() {
 
 BigramSegmenter *BigramSegmenter::New(ModelFactory *model_factory,
                                       bool use_bigram,
+                                      int beam_size,
                                       Status *status) {
   BigramSegmenter *self = new BigramSegmenter();
 
-  self->beam_size_ = use_bigram? kDefaultBeamSize: 1;
+  self->beam_size_ = use_bigram? beam_size: 1;
   self->node_pool_ = new NodePool<Node>();
 
   // Initialize the beams_
@@ -216,22 +238,39 @@ inline double BigramSegmenter::CalculateBigramCost(int left_id,
 }
 
 int BigramSegmenter::GetTermId(const char *term_str) {
+  double cost = 0.0;
+  return GetTermIdAndCost(term_str, &cost);
+}
+
+int BigramSegmenter::GetTermIdAndCost(const char *term_str,
+                                      double *right_cost) {
   bool system_flag = true;
   bool user_flag = has_user_index_;
   size_t system_node = 0;
   size_t user_node = 0;
-  double cost = 0.0;
 
   return GetTermIdAndUnigramCost(term_str,
                                  &system_flag,
                                  &user_flag,
                                  &system_node,
                                  &user_node,
-                                 &cost);
+                                 right_cost);
 }
 
-void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance, 
-                                            int position) {
+double BigramSegmenter::TokenArcCost(int left_id,
+                                     int right_id,
+                                     double left_cost,
+                                     double right_cost) {
+  if (right_id >= 0) {
+    return CalculateBigramCost(left_id, right_id, left_cost, right_cost);
+  } else {
+    return left_cost + kOOVCost;
+  }
+}
+
+void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
+                                            int position,
+                                            int end) {
   size_t index_node = 0,
          user_node = 0;
   bool index_flag = true, 
@@ -242,7 +281,7 @@ void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
 
   beams_[position]->Shrink();
   const char *token_str = nullptr;
-  int length_end = token_instance->size() - position;
+  int length_end = end - position;
   for (int length = 0; length < length_end; ++length) {
     LOG("Position: [%d, %d)\n", position, position + length + 1);
 
@@ -255,7 +294,7 @@ void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
                                           &user_node,
                                           &right_cost);
 
-    double min_cost = 1e38;
+    double min_cost = 1e38, second_cost = 1e38;
     const Node *min_node = nullptr;
 
     assert(beams_[position]->size() > 0);
@@ -272,15 +311,18 @@ void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
                                           right_cost);
         LOG("final cost is %lf\n", cost - node->cost);
         if (cost < min_cost) {
+          second_cost = min_cost;
           min_cost = cost;
           min_node = node;
+        } else if (cost < second_cost) {
+          second_cost = cost;
         }
       }
 
       // Add the min_node to decode graph
       new_node = node_pool_->Alloc();
       new_node->set_value(position + length + 1, term_id, min_cost, min_node);
-      beams_[position + length + 1]->Add(new_node);
+      AddNode(position + length + 1, new_node, second_cost);
     } else {
       // One token out-of-vocabulary word should be always put into Decode
       // Graph When no arc to next bucket
@@ -289,17 +331,20 @@ void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
              node_id < beams_[position]->size();
              ++node_id) {
           node = beams_[position]->node_at(node_id);
-          cost = node->cost + 20;
+          cost = node->cost + kOOVCost;
 
           if (cost < min_cost) {
+            second_cost = min_cost;
             min_cost = cost;
             min_node = node;
+          } else if (cost < second_cost) {
+            second_cost = cost;
           }
         }
 
         new_node = node_pool_->Alloc();
         new_node->set_value(position + length + 1, 0, min_cost, min_node);
-        beams_[position + 1]->Add(new_node);
+        AddNode(position + 1, new_node, second_cost);
       }  // end if node count == 0
     }  // end if term_id >= 0
 
@@ -307,18 +352,12 @@ void BigramSegmenter::BuildBeamFromPosition(TokenInstance *token_instance,
   }  // end for length
 }
 
-void BigramSegmenter::FindTheBestResult(TermInstance *term_instance, 
-                                        TokenInstance *token_instance) {
-  // Find the best result from decoding graph
-  const Node *node = beams_[token_instance->size()]->MinimalNode();
-
-  // Set the cost data for RecentSegCost()
-  cost_ = node->cost;
-
-  term_instance->set_size(node->term_position + 1);
+void BigramSegmenter::FindTheBestResult(TermInstance *term_instance,
+                                        TokenInstance *token_instance,
+                                        const Node *node) {
   int beam_id, from_beam_id, term_type;
   std::string buffer;
-  while (node->term_position >= 0) {
+  while (node->from_node != nullptr) {
     buffer.clear();
     beam_id = node->beam_id;
     from_beam_id = node->from_node->beam_id;
@@ -338,30 +377,155 @@ void BigramSegmenter::FindTheBestResult(TermInstance *term_instance,
         beam_id - from_beam_id,
         term_type,
         node->term_id == 0? oov_id: node->term_id);
+    term_costs_[node->term_position] = node->cost - node->from_node->cost;
+
+    // The best one of other paths ending at beam_id
+    double alternative_cost = node == min_nodes_[beam_id]?
+        second_costs_[beam_id]:
+        min_costs_[beam_id];
+    term_margins_[node->term_position] = alternative_cost < kMaxTermMargin?
+        alternative_cost - node->cost:
+        kMaxTermMargin;
+
     node = node->from_node;
   }  // end while
 }
 
-void BigramSegmenter::Segment(TermInstance *term_instance,
-                              TokenInstance *token_instance) {
+void BigramSegmenter::AddNode(int position,
+                              Node *node,
+                              double runner_up_cost) {
+  double &min_cost = min_costs_[position];
+  double &second_cost = second_costs_[position];
+  if (node->cost < min_cost) {
+    second_cost = std::min(min_cost, runner_up_cost);
+    min_cost = node->cost;
+    min_nodes_[position] = node;
+  } else {
+    second_cost = std::min(second_cost, node->cost);
+  }
+  beams_[position]->Add(node);
+}
+
+int BigramSegmenter::DecodeRange(TermInstance *term_instance,
+                                 TokenInstance *token_instance,
+                                 int begin,
+                                 int end,
+                                 int term_begin,
+                                 int *left_term_id) {
+  for (int i = begin; i <= end; ++i) {
+    min_costs_[i] = kMaxTermMargin;
+    second_costs_[i] = kMaxTermMargin;
+    min_nodes_[i] = nullptr;
+  }
+
+  // Add the node of the left term as begin node
   Node *new_node = node_pool_->Alloc();
-  new_node->set_value(0, 0, 0, nullptr);
-  // Add begin-of-sentence node
-  beams_[0]->Add(new_node);
+  new_node->set_value(begin, *left_term_id, cost_, nullptr);
+  new_node->term_position = term_begin - 1;
+  beams_[begin]->Add(new_node);
 
-  // Strat decoding
-  for (int beam_id = 0; beam_id < token_instance->size(); ++beam_id) {
-    // Shrink current bucket to ensure node number < n_best
-    BuildBeamFromPosition(token_instance, beam_id);
-  }  // end for decode_start
+  for (int position = begin; position < end; ++position) {
+    BuildBeamFromPosition(token_instance, position, end);
+  }
 
-  FindTheBestResult(term_instance, token_instance);
+  const Node *node = nullptr;
+  if (end < token_instance->size()) {
+    // The range is followed by a bypassed token, choose the path with minimal
+    // cost to it just like it is decoded
+    beams_[end]->Shrink();
+    double right_cost = 0.0;
+    int right_id = GetTermIdAndCost(token_instance->token_text_at(end),
+                                    &right_cost);
+    double min_cost = 1e38;
+    for (int node_id = 0; node_id < beams_[end]->size(); ++node_id) {
+      const Node *end_node = beams_[end]->node_at(node_id);
+      double cost = TokenArcCost(end_node->term_id,
+                                 right_id,
+                                 end_node->cost,
+                                 right_cost);
+      if (cost < min_cost) {
+        min_cost = cost;
+        node = end_node;
+      }
+    }
+  } else {
+    node = beams_[end]->MinimalNode();
+  }
+
+  FindTheBestResult(term_instance, token_instance, node);
+  *left_term_id = node->term_id;
+  cost_ = node->cost;
+  int term_end = node->term_position + 1;
 
   // Clear decode_node
-  for (int i = 0; i < token_instance->size() + 1; ++i) {
+  for (int i = begin; i <= end; ++i) {
     beams_[i]->Clear();
   }
   node_pool_->ReleaseAll();
+
+  return term_end;
+}
+
+void BigramSegmenter::StoreBypassedTerm(TermInstance *term_instance,
+                                        TokenInstance *token_instance,
+                                        int position,
+                                        int term_position,
+                                        int *left_term_id) {
+  const char *token_str = token_instance->token_text_at(position);
+  double right_cost = 0.0;
+  int term_id = GetTermIdAndCost(token_str, &right_cost);
+  double cost = TokenArcCost(*left_term_id, term_id, cost_, right_cost);
+
+  int oov_id = TermInstance::kTermIdOutOfVocabulary;
+  term_instance->set_value_at(
+      term_position,
+      token_str,
+      1,
+      TokenTypeToTermType(token_instance->token_type_at(position)),
+      term_id <= 0? oov_id: term_id);
+  term_costs_[term_position] = cost - cost_;
+  term_margins_[term_position] = kMaxTermMargin;
+
+  // Out-of-vocabulary token has term-id 0 in the bigram context, the same as
+  // the node in decode graph
+  *left_term_id = term_id >= 0? term_id: 0;
+  cost_ = cost;
+}
+
+void BigramSegmenter::Segment(TermInstance *term_instance,
+                              TokenInstance *token_instance) {
+  int token_num = token_instance->size();
+  int left_term_id = 0;
+  int term_position = 0;
+  int position = 0;
+  cost_ = 0.0;
+  while (position < token_num) {
+    if (bypass_non_cjk_ && IsBypassedToken(token_instance, position)) {
+      StoreBypassedTerm(term_instance,
+                        token_instance,
+                        position,
+                        term_position,
+                        &left_term_id);
+      term_position++;
+      position++;
+    } else {
+      // Decode the tokens until next bypassed token
+      int end = position + 1;
+      while (end < token_num &&
+             !(bypass_non_cjk_ && IsBypassedToken(token_instance, end))) {
+        ++end;
+      }
+      term_position = DecodeRange(term_instance,
+                                  token_instance,
+                                  position,
+                                  end,
+                                  term_position,
+                                  &left_term_id);
+      position = end;
+    }
+  }
+
+  term_instance->set_size(term_position);
 }
 
 }  // namespace milkcat
@@ -51,11 +51,16 @@ class BigramSegmenter: public Segmenter {
   // A node in decode graph
   struct Node;
 
-  // Create the bigram segmenter from a model factory. On success, return an
-  // instance of BigramSegmenter. On failed, return nullptr and set status
-  // a failed value
+  // Number of nodes kept in each position by default
+  static constexpr int kDefaultBeamSize = 3;
+
+  // Create the bigram segmenter from a model factory, which keeps beam_size
+  // nodes in each position. The unigram segmenter (use_bigram is false)
+  // always keeps 1 node. On success, return an instance of BigramSegmenter.
+  // On failed, return nullptr and set status a failed value
   static BigramSegmenter *New(ModelFactory *model_factory,
                               bool use_bigram,
+                              int beam_size,
                               Status *status);
 
   ~BigramSegmenter();
@@ -64,9 +69,35 @@ class BigramSegmenter: public Segmenter {
   void Segment(TermInstance *term_instance,
                TokenInstance *token_instance) override;
 
+  // If bypass is true, the tokens other than Chinese characters whose
+  // neighbors are not Chinese characters either, such as the words in a span
+  // of English text, are stored as terms directly without decoding, and only
+  // the ranges between them are decoded. Then the dictionary terms made of
+  // several such tokens, like "C++" or "U.S." in user dictionary, are no
+  // longer matched. It is disabled by default
+  void set_bypass_non_cjk(bool bypass) { bypass_non_cjk_ = bypass; }
+
   // Get the recent segmentation cost
   double RecentSegCost() { return cost_; }
 
+  // Get the cost of term at position in the recent segmentation result, that
+  // is the increment of path cost by this term
+  double RecentTermCost(int position) const { return term_costs_[position]; }
+
+  // Get the margin of the recent segmentation at the end of term at position,
+  // that is the minimal cost of the other paths ending at the same token
+  // minus the cost of the best path there. The paths dropped when the beam is
+  // shrunk are counted too. It is kMaxTermMargin if there is no other path
+  double RecentTermMargin(int position) const {
+    return term_margins_[position];
+  }
+
+  // The cost of a token not in dictionary
+  static constexpr double kOOVCost = 20;
+
+  // The margin of a term without other paths ending with it
+  static constexpr double kMaxTermMargin = 1e38;
+
   // Get term-id by string. Return term-id if term exists, or a negative value
   // if the term neither in system dictionary nor in user dictionry.
   int GetTermId(const char *term_str);
@@ -85,7 +116,6 @@ class BigramSegmenter: public Segmenter {
   }
 
  private:
-  static constexpr int kDefaultBeamSize = 3;
   // Number of Node in each buckets_
   int beam_size_;
 
@@ -106,8 +136,22 @@ class BigramSegmenter: public Segmenter {
   const TrieTree *user_index_;
   bool has_user_index_;
 
-  // Stores the final cost of recent segmentation
+  // Stores the final cost of recent segmentation, the cost and the margin of
+  // each term
   double cost_;
+  std::array<double, kTokenMax> term_costs_;
+  std::array<double, kTokenMax> term_margins_;
+
+  // The lowest and the second lowest cost of the paths ending at each
+  // position, recorded before the beams are shrunk, and the node of the
+  // lowest one
+  std::array<double, kTokenMax + 1> min_costs_;
+  std::array<double, kTokenMax + 1> second_costs_;
+  std::array<const Node *, kTokenMax + 1> min_nodes_;
+
+  // If the non-CJK tokens are stored without decoding, see
+  // set_bypass_non_cjk()
+  bool bypass_non_cjk_;
 
   // The disabled term-ids variables
   bool use_disabled_term_ids_;
@@ -115,11 +159,18 @@ class BigramSegmenter: public Segmenter {
 
   BigramSegmenter();
 
+  // Calculates the cost of path from the left term to the right term, where
+  // left_cost is the cost of path ending with left term and right_cost is the
+  // unigram cost of right term
   double CalculateBigramCost(int left_id,
                              int right_id,
                              double left_cost,
                              double right_cost);
 
+  // Traverses the system and user index by one more token from the nodes
+  // system_node and user_node, returns the term-id of the tokens traversed
+  // and stores its unigram cost into right_cost. The flags are set to false
+  // if there is no more term in the index with the traversed prefix
   int GetTermIdAndUnigramCost(const char *token_str,
                               bool *system_flag,
                               bool *user_flag,
@@ -127,12 +178,53 @@ class BigramSegmenter: public Segmenter {
                               size_t *user_node,
                               double *right_cost);
 
-  // Builds the beams_ from the words starts from current position in index
-  void BuildBeamFromPosition(TokenInstance *token_instance, int position);
-
-  // Finds the best result from beams_ and save the result to term_instance 
+  // Builds the beams_ from the words starts from current position and ends
+  // before end in index
+  void BuildBeamFromPosition(TokenInstance *token_instance,
+                             int position,
+                             int end);
+
+  // Adds node to beams_[position] and records the cost of it in min_costs_
+  // and second_costs_. runner_up_cost is the cost of the best path to the
+  // same term through another node in the beam of its begin position
+  void AddNode(int position, Node *node, double runner_up_cost);
+
+  // Decodes the tokens [begin, end) following the term left_term_id and
+  // stores the best result into term_instance from position term_begin.
+  // Updates left_term_id and cost_ with the last term and returns the end
+  // position of the terms
+  int DecodeRange(TermInstance *term_instance,
+                  TokenInstance *token_instance,
+                  int begin,
+                  int end,
+                  int term_begin,
+                  int *left_term_id);
+
+  // Stores the bypassed token at position into term_instance at term_position
+  // as a term following the term left_term_id. Updates left_term_id and
+  // cost_ with it
+  void StoreBypassedTerm(TermInstance *term_instance,
+                         TokenInstance *token_instance,
+                         int position,
+                         int term_position,
+                         int *left_term_id);
+
+  // Gets the term-id of term_str and stores its unigram cost into
+  // right_cost. Returns a negative value if it is not in dictionary
+  int GetTermIdAndCost(const char *term_str, double *right_cost);
+
+  // Gets the path cost from the path ending with the term left_id with cost
+  // left_cost to the token of term-id right_id, which is an out-of-vocabulary
+  // token if right_id is negative
+  double TokenArcCost(int left_id,
+                      int right_id,
+                      double left_cost,
+                      double right_cost);
+
+  // Saves the result ending with node to term_instance
   void FindTheBestResult(TermInstance *term_instance,
-                         TokenInstance *token_instance);
+                         TokenInstance *token_instance,
+                         const Node *node);
 };
 
 }  // namespace milkcat
@@ -0,0 +1,121 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// character_property.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/character_property.h"
+
+namespace milkcat {
+
+namespace {
+
+// Encode codepoint in the Basic Multilingual Plane into the NUL-terminated
+// UTF-8 text
+void EncodeUTF8(int codepoint, char *text) {
+  if (codepoint < 0x80) {
+    text[0] = codepoint;
+    text[1] = '\0';
+  } else if (codepoint < 0x800) {
+    text[0] = 0xc0 | (codepoint >> 6);
+    text[1] = 0x80 | (codepoint & 0x3f);
+    text[2] = '\0';
+  } else {
+    text[0] = 0xe0 | (codepoint >> 12);
+    text[1] = 0x80 | ((codepoint >> 6) & 0x3f);
+    text[2] = 0x80 | (codepoint & 0x3f);
+    text[3] = '\0';
+  }
+}
+
+// Decode the text if it is exactly one character in the Basic Multilingual
+// Plane, returns its codepoint or -1 if it is not
+int DecodeUTF8Character(const char *text) {
+  const uint8_t *s = reinterpret_cast<const uint8_t *>(text);
+  int codepoint;
+  if (s[0] < 0x80) {
+    if (s[0] == 0 || s[1] != 0) return -1;
+    codepoint = s[0];
+  } else if ((s[0] & 0xe0) == 0xc0) {
+    if ((s[1] & 0xc0) != 0x80 || s[2] != 0) return -1;
+    codepoint = ((s[0] & 0x1f) << 6) | (s[1] & 0x3f);
+    if (codepoint < 0x80) return -1;
+  } else if ((s[0] & 0xf0) == 0xe0) {
+    if ((s[1] & 0xc0) != 0x80 || (s[2] & 0xc0) != 0x80 || s[3] != 0) {
+      return -1;
+    }
+    codepoint = ((s[0] & 0x0f) << 12) | ((s[1] & 0x3f) << 6) | (s[2] & 0x3f);
+    if (codepoint < 0x800) return -1;
+  } else {
+    return -1;
+  }
+
+  // The surrogates are not characters
+  if (codepoint >= 0xd800 && codepoint < 0xe000) return -1;
+  return codepoint;
+}
+
+}  // namespace
+
+CharacterProperty::CharacterProperty(): index_(nullptr) {
+}
+
+CharacterProperty::~CharacterProperty() {
+  delete index_;
+  index_ = nullptr;
+}
+
+CharacterProperty *CharacterProperty::New(const TrieTree *index) {
+  CharacterProperty *self = new CharacterProperty();
+  self->index_ = index;
+  self->table_.resize(kCodepointNum);
+
+  char text[4];
+  for (int codepoint = 0; codepoint < kCodepointNum; ++codepoint) {
+    if (codepoint == 0 || (codepoint >= 0xd800 && codepoint < 0xe000)) {
+      self->table_[codepoint] = kSearchIndex;
+      continue;
+    }
+
+    EncodeUTF8(codepoint, text);
+    int value = index->Search(text);
+    if (value > INT8_MIN && value <= INT8_MAX) {
+      self->table_[codepoint] = value;
+    } else {
+      self->table_[codepoint] = kSearchIndex;
+    }
+  }
+
+  return self;
+}
+
+int CharacterProperty::Get(const char *text) const {
+  int codepoint = DecodeUTF8Character(text);
+  if (codepoint >= 0 && table_[codepoint] != kSearchIndex) {
+    return table_[codepoint];
+  } else {
+    return index_->Search(text);
+  }
+}
+
+}  // namespace milkcat
@@ -0,0 +1,69 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// character_property.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_CHARACTER_PROPERTY_H_
+#define SRC_MILKCAT_CHARACTER_PROPERTY_H_
+
+#include <stdint.h>
+#include <vector>
+#include "milkcat/trie_tree.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+// CharacterProperty is the property of single characters stored in a trie
+// tree, such as the OOV property of characters. The values of the characters
+// in the Basic Multilingual Plane are expanded into a flat table indexed by
+// codepoint when it is created, so that getting the property of a character
+// is one array read instead of a search of the trie tree. The other texts
+// are still searched in the trie tree
+class CharacterProperty {
+ public:
+  // Create the property from index and take the ownership of it
+  static CharacterProperty *New(const TrieTree *index);
+  ~CharacterProperty();
+
+  // Get the property of the UTF-8 text, returns the same value as
+  // TrieTree::Search
+  int Get(const char *text) const;
+
+ private:
+  // The value in table_ of the characters whose value is out of int8_t, they
+  // are searched in index_
+  static const int8_t kSearchIndex = INT8_MIN;
+  static const int kCodepointNum = 0x10000;
+
+  const TrieTree *index_;
+  std::vector<int8_t> table_;
+
+  CharacterProperty();
+
+  DISALLOW_COPY_AND_ASSIGN(CharacterProperty);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_CHARACTER_PROPERTY_H_
@@ -34,6 +34,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <assert.h>
 #include "utils/utils.h"
 #include "utils/readable_file.h"
@@ -152,4 +153,19 @@ CRFModel *CRFModel::New(const char *model_path, Status *status) {
   }
 }
 
+int CRFModel::ContextSize() const {
+  int context_size = 0;
+  std::vector<const char *> templs(unigram_templs_);
+  templs.insert(templs.end(), bigram_templs_.begin(), bigram_templs_.end());
+  for (const char *templ : templs) {
+    for (const char *p = strstr(templ, "%x["); p; p = strstr(p, "%x[")) {
+      p += 3;
+      int row = abs(atoi(p));
+      if (row > context_size) context_size = row;
+    }
+  }
+
+  return context_size;
+}
+
 }  // namespace milkcat
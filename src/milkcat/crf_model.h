@@ -102,9 +102,19 @@ class CRFModel {
     return cost_data_[feature_id + left_tag_id * y_.size() + right_tag_id];
   }
 
+  // Get the cost array of features. The costs of unigram feature are at
+  // [feature_id, feature_id + tag_num), and the costs of bigram feature are at
+  // [feature_id, feature_id + tag_num * tag_num) with the right tag innermost
+  const float *cost_data() const { return cost_data_; }
+
   // Get feature column number
   int xsize() const { return xsize_; }
 
+  // Get the maximal distance of the rows in %x[row,col] of all templates
+  // from the current position, so the features of a position only depend on
+  // the positions within this distance
+  int ContextSize() const;
+
  private:
   std::vector<const char *> y_;
   std::vector<const char *> unigram_templs_;
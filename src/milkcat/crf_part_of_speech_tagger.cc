@@ -89,6 +89,11 @@ CRFPartOfSpeechTagger::~CRFPartOfSpeechTagger() {
   delete feature_extractor_;
   feature_extractor_ = NULL;
 
+  for (PartOfSpeechFeatureExtractor *extractor : batch_feature_extractors_) {
+    delete extractor;
+  }
+  batch_feature_extractors_.clear();
+
   delete crf_tagger_;
   crf_tagger_ = NULL;
 }
@@ -101,11 +106,40 @@ void CRFPartOfSpeechTagger::TagRange(
   feature_extractor_->set_term_instance(term_instance);
   crf_tagger_->TagRange(feature_extractor_, begin, end);
   for (size_t i = 0; i < end - begin; ++i) {
+    int tag_id = crf_tagger_->GetTagAt(i);
     part_of_speech_tag_instance->set_value_at(
         i,
-        crf_tagger_->GetTagText(crf_tagger_->GetTagAt(i)));
+        tag_id,
+        crf_tagger_->GetTagText(tag_id));
   }
   part_of_speech_tag_instance->set_size(end - begin);
 }
 
+void CRFPartOfSpeechTagger::TagBatch(
+    PartOfSpeechTagInstance **part_of_speech_tag_instances,
+    TermInstance **term_instances,
+    int instance_num) {
+  while (static_cast<int>(batch_feature_extractors_.size()) < instance_num) {
+    batch_feature_extractors_.push_back(new PartOfSpeechFeatureExtractor());
+  }
+  batch_feature_extractor_ptrs_.resize(instance_num);
+  for (int i = 0; i < instance_num; ++i) {
+    batch_feature_extractors_[i]->set_term_instance(term_instances[i]);
+    batch_feature_extractor_ptrs_[i] = batch_feature_extractors_[i];
+  }
+
+  crf_tagger_->TagBatch(batch_feature_extractor_ptrs_.data(), instance_num);
+  for (int i = 0; i < instance_num; ++i) {
+    int term_num = term_instances[i]->size();
+    for (int position = 0; position < term_num; ++position) {
+      int tag_id = crf_tagger_->GetTagAt(i, position);
+      part_of_speech_tag_instances[i]->set_value_at(
+          position,
+          tag_id,
+          crf_tagger_->GetTagText(tag_id));
+    }
+    part_of_speech_tag_instances[i]->set_size(term_num);
+  }
+}
+
 }  // namespace milkcat
@@ -30,6 +30,7 @@
 #ifndef SRC_MILKCAT_CRF_PART_OF_SPEECH_TAGGER_H_
 #define SRC_MILKCAT_CRF_PART_OF_SPEECH_TAGGER_H_
 
+#include <vector>
 #include "milkcat/term_instance.h"
 #include "milkcat/part_of_speech_tag_instance.h"
 #include "milkcat/crf_tagger.h"
@@ -61,6 +62,11 @@ class CRFPartOfSpeechTagger: public PartOfSpeechTagger {
 
   CRFTagger *crf_tagger() const { return crf_tagger_; }
 
+  int tag_num() const override { return crf_tagger_->GetTagSize(); }
+  const char *tag_str(int tag_id) const override {
+    return crf_tagger_->GetTagText(tag_id);
+  }
+
   // Tag the TermInstance and put the result to PartOfSpeechTagInstance
   void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
            TermInstance *term_instance) {
@@ -77,9 +83,20 @@ class CRFPartOfSpeechTagger: public PartOfSpeechTagger {
                 int begin,
                 int end);
 
+  // Tag instance_num TermInstances term_instances[i] and put the results to
+  // part_of_speech_tag_instances[i]. The sentences are decoded together in
+  // SIMD lanes via CRFTagger::TagBatch
+  void TagBatch(PartOfSpeechTagInstance **part_of_speech_tag_instances,
+                TermInstance **term_instances,
+                int instance_num);
+
  private:
   CRFTagger *crf_tagger_;
 
+  // Feature extractors of the sentences in TagBatch
+  std::vector<PartOfSpeechFeatureExtractor *> batch_feature_extractors_;
+  std::vector<FeatureExtractor *> batch_feature_extractor_ptrs_;
+
   CRFPartOfSpeechTagger();
 
   // Use FeatureExtractor to extract part-of-speech tagging features from
@@ -71,6 +71,7 @@ CRFSegmenter *CRFSegmenter::New(ModelFactory *model_factory, Status *status) {
   if (status->ok()) {
     self->crf_tagger_ = new CRFTagger(model);
     self->feature_extractor_ = new SegmentFeatureExtractor();
+    self->context_size_ = model->ContextSize();
 
     // Get the tag's value in CRF++ model
     self->S = self->crf_tagger_->GetTagId("S");
@@ -99,24 +100,86 @@ CRFSegmenter::~CRFSegmenter() {
   delete feature_extractor_;
   feature_extractor_ = NULL;
 
+  for (SegmentFeatureExtractor *extractor : batch_feature_extractors_) {
+    delete extractor;
+  }
+  batch_feature_extractors_.clear();
+
   delete crf_tagger_;
   crf_tagger_ = NULL;
 }
 
 CRFSegmenter::CRFSegmenter(): crf_tagger_(NULL),
-                              feature_extractor_(NULL) {}
+                              feature_extractor_(NULL),
+                              context_size_(0) {}
 
 void CRFSegmenter::SegmentRange(TermInstance *term_instance,
                                 TokenInstance *token_instance,
                                 int begin,
                                 int end) {
-  std::string buffer;
-
   feature_extractor_->set_token_instance(token_instance);
   crf_tagger_->TagRange(feature_extractor_, begin, end, S, S);
+  StoreTerms(term_instance, token_instance, begin, end, -1, 0);
+}
+
+void CRFSegmenter::SegmentRanges(TermInstance *term_instance,
+                                 TokenInstance *token_instance,
+                                 const int *begins,
+                                 const int *ends,
+                                 int range_num,
+                                 int *term_ends) {
+  feature_extractor_->set_token_instance(token_instance);
+  crf_tagger_->TagRanges(feature_extractor_, begins, ends, range_num, S, S);
+
+  int term_end = 0;
+  for (int i = 0; i < range_num; ++i) {
+    term_end = StoreTerms(term_instance,
+                          token_instance,
+                          begins[i],
+                          ends[i],
+                          i,
+                          term_end);
+    term_ends[i] = term_end;
+  }
+  term_instance->set_size(term_end);
+}
+
+void CRFSegmenter::SegmentBatch(TermInstance **term_instances,
+                                TokenInstance **token_instances,
+                                int instance_num) {
+  while (static_cast<int>(batch_feature_extractors_.size()) < instance_num) {
+    batch_feature_extractors_.push_back(new SegmentFeatureExtractor());
+  }
+  batch_feature_extractor_ptrs_.resize(instance_num);
+  batch_begin_.assign(instance_num, 0);
+  batch_end_.resize(instance_num);
+  for (int i = 0; i < instance_num; ++i) {
+    batch_feature_extractors_[i]->set_token_instance(token_instances[i]);
+    batch_feature_extractor_ptrs_[i] = batch_feature_extractors_[i];
+    batch_end_[i] = token_instances[i]->size();
+  }
+
+  crf_tagger_->TagBatch(batch_feature_extractor_ptrs_.data(),
+                        batch_begin_.data(),
+                        batch_end_.data(),
+                        instance_num,
+                        S,
+                        S);
+  for (int i = 0; i < instance_num; ++i) {
+    StoreTerms(term_instances[i], token_instances[i], 0, batch_end_[i], i, 0);
+  }
+}
+
+int CRFSegmenter::StoreTerms(TermInstance *term_instance,
+                             TokenInstance *token_instance,
+                             int begin,
+                             int end,
+                             int sentence,
+                             int term_begin) {
+  std::string buffer;
 
   int tag_id;
-  int term_count = 0;
+  int term_count = term_begin;
   size_t i = 0;
   int token_count = 0;
   int term_type;
@@ -124,7 +187,11 @@ void CRFSegmenter::SegmentRange(TermInstance *term_instance,
     token_count++;
     buffer.append(token_instance->token_text_at(begin + i));
 
-    tag_id = crf_tagger_->GetTagAt(i);
+    if (sentence >= 0) {
+      tag_id = crf_tagger_->GetTagAt(sentence, i);
+    } else {
+      tag_id = crf_tagger_->GetTagAt(i);
+    }
     if (tag_id == S || tag_id == E) {
       if (tag_id == S) {
         term_type = TokenTypeToTermType(
@@ -152,6 +219,7 @@ void CRFSegmenter::SegmentRange(TermInstance *term_instance,
   }
 
   term_instance->set_size(term_count);
+  return term_count;
 }
 
 }  // namespace milkcat
@@ -27,6 +27,7 @@
 #ifndef SRC_MILKCAT_CRF_SEGMENTER_H_
 #define SRC_MILKCAT_CRF_SEGMENTER_H_
 
+#include <vector>
 #include "utils/utils.h"
 #include "milkcat/crf_tagger.h"
 #include "milkcat/token_instance.h"
@@ -38,7 +39,7 @@ class SegmentFeatureExtractor;
 class TermInstance;
 class ModelFactory;
 
-class CRFSegmenter: public Segmenter {
+class CRFSegmenter: public RangeSegmenter {
  public:
   static CRFSegmenter *New(ModelFactory *model_factory, Status *status);
   ~CRFSegmenter();
@@ -49,19 +50,62 @@ class CRFSegmenter: public Segmenter {
                     int begin,
                     int end);
 
+  // Segment range_num ranges [begins[i], ends[i]) of token_instance together
+  // with S tag at the bounds of each range. The terms of all ranges are
+  // stored into term_instance one range after another, the terms of range i
+  // are [term_ends[i - 1], term_ends[i]) with term_ends[-1] = 0. It decodes
+  // the ranges via CRFTagger::TagRanges, so it is faster than calling
+  // SegmentRange one by one
+  void SegmentRanges(TermInstance *term_instance,
+                     TokenInstance *token_instance,
+                     const int *begins,
+                     const int *ends,
+                     int range_num,
+                     int *term_ends);
+
+  // The terms of a range only depend on the tokens within context_size() of
+  // it, see CRFModel::ContextSize
+  int context_size() const { return context_size_; }
+
   void Segment(TermInstance *term_instance, TokenInstance *token_instance) {
     SegmentRange(term_instance, token_instance, 0, token_instance->size());
   }
 
+  // Segment instance_num TokenInstances token_instances[i] into
+  // term_instances[i] together, it decodes the sentences in SIMD lanes via
+  // CRFTagger::TagBatch, so it is faster than calling Segment one by one
+  void SegmentBatch(TermInstance **term_instances,
+                    TokenInstance **token_instances,
+                    int instance_num);
+
  private:
   CRFTagger *crf_tagger_;
 
   SegmentFeatureExtractor *feature_extractor_;
 
+  // Feature extractors and ranges of the sentences in SegmentBatch
+  std::vector<SegmentFeatureExtractor *> batch_feature_extractors_;
+  std::vector<FeatureExtractor *> batch_feature_extractor_ptrs_;
+  std::vector<int> batch_begin_;
+  std::vector<int> batch_end_;
+
   int S, B, B1, B2, M, E;
+  int context_size_;
 
   CRFSegmenter();
 
+  // Stores the terms of range [begin, end) of token_instance into
+  // term_instance from position term_begin, from the tags in crf_tagger_. If
+  // sentence >= 0 the tags are the result of sentence in recent TagBatch,
+  // otherwise they are the result of recent TagRange. Returns the end
+  // position of the terms, which is also the size of term_instance
+  int StoreTerms(TermInstance *term_instance,
+                 TokenInstance *token_instance,
+                 int begin,
+                 int end,
+                 int sentence,
+                 int term_begin);
+
   DISALLOW_COPY_AND_ASSIGN(CRFSegmenter);
 };
 
@@ -37,52 +37,116 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
 #include <string>
 #include "utils/utils.h"
+#include "milkcat/crf_template.h"
 
 namespace milkcat {
 
-struct CRFTagger::Node {
-  double cost;
-  int left_tag_id;
-};
-
-const size_t kMaxContextSize = 8;
-const char *BOS[kMaxContextSize] = { "_B-1", "_B-2", "_B-3", "_B-4",
-                                     "_B-5", "_B-6", "_B-7", "_B-8" };
-const char *EOS[kMaxContextSize] = { "_B+1", "_B+2", "_B+3", "_B+4",
-                                     "_B+5", "_B+6", "_B+7", "_B+8" };
+// The minimal cost in decoding, the same as SimdKernel
+const float kMinCost = -1e37f;
 
 CRFTagger::CRFTagger(const CRFModel *model): model_(model),
+                                             kernel_(GetSimdKernel()),
+                                             tag_num_(model->GetTagNumber()),
+                                             xsize_(model->xsize()),
+                                             prune_top_k_(0),
+                                             prune_delta_(0.0f),
+                                             score_cache_mask_(0),
+                                             score_cache_hit_num_(0),
+                                             score_cache_miss_num_(0),
                                              feature_cache_left_(INT_MAX),
                                              feature_cache_right_(INT_MIN) {
-  for (int i = 0; i < kMaxBucket; ++i) {
-    buckets_[i] = new Node[model_->GetTagNumber()];
-    feature_cache_flag_[i] = false;
-  }
+  feature_buffer_ = new char[xsize_][kFeatureLengthMax];
+  unigram_cost_.resize(tag_num_);
 }
 
 CRFTagger::~CRFTagger() {
-  for (int i = 0; i < kMaxBucket; ++i) {
-    delete[] buckets_[i];
+  delete[] feature_buffer_;
+  feature_buffer_ = nullptr;
+}
+
+void CRFTagger::set_score_cache_capacity(int capacity) {
+  score_cache_hit_num_ = 0;
+  score_cache_miss_num_ = 0;
+  score_cache_keys_.clear();
+  score_cache_rows_.clear();
+  score_cache_mask_ = 0;
+  if (capacity <= 0) return;
+
+  size_t slot_num = 1;
+  while (slot_num < static_cast<size_t>(capacity)) slot_num *= 2;
+  score_cache_keys_.resize(slot_num);
+  score_cache_rows_.resize(slot_num * tag_num_);
+  score_cache_mask_ = slot_num - 1;
+
+  // Finds the (row, column) pairs of unigram templates by expanding them at
+  // the middle of a sentence long enough
+  score_window_.clear();
+  std::string feature_str;
+  for (int i = 0; i < model_->UnigramTemplateNum(); ++i) {
+    ApplyCRFTemplate(&feature_str,
+                     model_->GetUnigramTemplate(i),
+                     kMaxContextSize,
+                     2 * kMaxContextSize + 1,
+                     xsize_,
+                     [this](int position, int column) {
+                       score_window_.emplace_back(position - kMaxContextSize,
+                                                  column);
+                       return "";
+                     });
+  }
+  std::sort(score_window_.begin(), score_window_.end());
+  score_window_.erase(std::unique(score_window_.begin(), score_window_.end()),
+                      score_window_.end());
+}
+
+void CRFTagger::GetScoreCacheKey(int position, std::string *key) {
+  int size = feature_extractor_->size();
+  key->clear();
+  for (const std::pair<int, int> &cell : score_window_) {
+    int i = position + cell.first;
+    if (i < 0 || i >= size) {
+      // The features out of sentence only depend on the distance to the
+      // bound, a feature never starts with '\1'
+      key->push_back('\1');
+      key->push_back(static_cast<char>(i < 0? i: i - size + 1));
+    } else {
+      key->append(GetFeatureAt(i, cell.second));
+      key->push_back('\0');
+    }
   }
 }
 
 void CRFTagger::ClearFeatureCache() {
   for (int i = feature_cache_left_; i <= feature_cache_right_; ++i) {
-    feature_cache_flag_[i] = false;
+    feature_offset_[i * xsize_] = -1;
   }
   feature_cache_left_ = INT_MAX;
   feature_cache_right_ = INT_MIN;
+  feature_data_.clear();
+
+  size_t offset_num = feature_extractor_->size() * xsize_;
+  if (feature_offset_.size() < offset_num) {
+    feature_offset_.resize(offset_num, -1);
+  }
 }
 
 const char *CRFTagger::GetFeatureAt(int position, int index) {
-  if (feature_cache_flag_[position] == false) {
+  int *offset = feature_offset_.data() + position * xsize_;
+  if (offset[0] == -1) {
     // Cache unmatch
-    feature_extractor_->ExtractFeatureAt(position,
-                                         feature_cache_[position],
-                                         model_->xsize());
-    feature_cache_flag_[position] = true;
+    feature_extractor_->ExtractFeatureAt(position, feature_buffer_, xsize_);
+    for (int i = 0; i < xsize_; ++i) {
+      offset[i] = feature_data_.size();
+      const char *feature = feature_buffer_[i];
+      feature_data_.insert(feature_data_.end(),
+                           feature,
+                           feature + strlen(feature) + 1);
+    }
 
     if (feature_cache_left_ > position) {
       feature_cache_left_ = position;
@@ -93,7 +157,17 @@ const char *CRFTagger::GetFeatureAt(int position, int index) {
     }
   }
 
-  return feature_cache_[position][index];
+  return feature_data_.data() + offset[index];
+}
+
+void CRFTagger::ReserveBucket(int bucket_num) {
+  size_t size = bucket_num * tag_num_;
+  if (bucket_cost_.size() < size) {
+    bucket_cost_.resize(size);
+    bucket_left_tag_.resize(size);
+    active_tag_.resize(size);
+    active_tag_num_.resize(bucket_num);
+  }
 }
 
 void CRFTagger::TagRange(FeatureExtractor *feature_extractor,
@@ -104,35 +178,283 @@ void CRFTagger::TagRange(FeatureExtractor *feature_extractor,
   feature_extractor_ = feature_extractor;
 
   ClearFeatureCache();
+  ReserveBucket(end + 1);
+  if (static_cast<int>(result_.size()) < end - begin) {
+    result_.resize(end - begin);
+  }
 
-  Viterbi(begin, end, begin_tag, end_tag);
+  if (prune_top_k_ > 0) {
+    PrunedViterbi(begin, end, begin_tag, end_tag);
+  } else {
+    Viterbi(begin, end, begin_tag, end_tag);
+  }
   FindBestResult(begin, end, end_tag);
 }
 
-void CRFTagger::ProbabilityAtPosition(FeatureExtractor *feature_extractor, 
-                                      int position,
-                                      double *probability) {
+void CRFTagger::TagBatch(FeatureExtractor **feature_extractors,
+                         int sentence_num) {
+  batch_begin_.assign(sentence_num, 0);
+  batch_end_.resize(sentence_num);
+  for (int i = 0; i < sentence_num; ++i) {
+    batch_end_[i] = feature_extractors[i]->size();
+  }
+  TagBatch(feature_extractors,
+           batch_begin_.data(),
+           batch_end_.data(),
+           sentence_num,
+           -1,
+           -1);
+}
+
+void CRFTagger::TagRanges(FeatureExtractor *feature_extractor,
+                          const int *begins,
+                          const int *ends,
+                          int range_num,
+                          int begin_tag,
+                          int end_tag) {
+  batch_feature_extractors_.assign(range_num, feature_extractor);
+  TagBatch(batch_feature_extractors_.data(),
+           begins,
+           ends,
+           range_num,
+           begin_tag,
+           end_tag);
+}
+
+void CRFTagger::TagBatch(FeatureExtractor **feature_extractors,
+                         const int *begins,
+                         const int *ends,
+                         int sentence_num,
+                         int begin_tag,
+                         int end_tag) {
+  batch_result_offset_.resize(sentence_num + 1);
+  batch_result_offset_[0] = 0;
+  for (int i = 0; i < sentence_num; ++i) {
+    batch_result_offset_[i + 1] = batch_result_offset_[i] + ends[i] - begins[i];
+  }
+  batch_result_.resize(batch_result_offset_[sentence_num]);
+
+  // The feature cache is shared by the lanes of the same instance in this
+  // batch, it may be stale from the recent call even if the instance is the
+  // same one
+  feature_extractor_ = nullptr;
+
+  // Sentences with similar length are put into the same lanes, so that less
+  // lanes are idle
+  batch_order_.resize(sentence_num);
+  for (int i = 0; i < sentence_num; ++i) batch_order_[i] = i;
+  std::stable_sort(batch_order_.begin(),
+                   batch_order_.end(),
+                   [begins, ends](int s1, int s2) {
+                     return ends[s1] - begins[s1] < ends[s2] - begins[s2];
+                   });
+
+  for (int i = 0; i < sentence_num; i += kSimdLaneNum) {
+    TagLanes(feature_extractors,
+             begins,
+             ends,
+             batch_order_.data() + i,
+             std::min(kSimdLaneNum, sentence_num - i),
+             begin_tag,
+             end_tag);
+  }
+}
+
+void CRFTagger::TagLanes(FeatureExtractor **feature_extractors,
+                         const int *begins,
+                         const int *ends,
+                         const int *sentences,
+                         int lane_num,
+                         int begin_tag,
+                         int end_tag) {
+  const int L = kSimdLaneNum;
+  int unigram_num = model_->UnigramTemplateNum();
+  int bigram_num = model_->BigramTemplateNum();
+
+  // The extra bucket is for the arc to end tag
+  int length[kSimdLaneNum] = {0};
+  int bigram_end[kSimdLaneNum] = {0};
+  int max_length = 0;
+  for (int lane = 0; lane < lane_num; ++lane) {
+    length[lane] = ends[sentences[lane]] - begins[sentences[lane]];
+    bigram_end[lane] = end_tag != -1? length[lane] + 1: length[lane];
+    max_length = std::max(max_length, length[lane]);
+  }
+  int bucket_num = end_tag != -1? max_length + 1: max_length;
+  if (max_length == 0) return;
+
+  lane_unigram_offset_.resize(bucket_num * L * unigram_num);
+  lane_unigram_num_.assign(bucket_num * L, 0);
+  lane_bigram_offset_.assign(bucket_num * bigram_num * L, -1);
+  lane_bucket_cost_.resize(bucket_num * tag_num_ * L);
+  lane_bucket_left_tag_.resize(bucket_num * tag_num_ * L);
+  lane_cost_.resize(L * tag_num_);
+
+  // Extract the feature ids of each sentence into its lane. The unigram ids
+  // are stored as [position][lane][template] since they are added to the
+  // costs lane by lane
+  int feature_ids[kMaxFeature];
+  for (int lane = 0; lane < lane_num; ++lane) {
+    int sentence = sentences[lane];
+    int begin = begins[sentence];
+    if (feature_extractor_ != feature_extractors[sentence]) {
+      feature_extractor_ = feature_extractors[sentence];
+      ClearFeatureCache();
+    }
+
+    for (int position = 0; position < length[lane]; ++position) {
+      lane_unigram_num_[position * L + lane] = GetUnigramFeatureIds(
+          begin + position,
+          lane_unigram_offset_.data() + (position * L + lane) * unigram_num);
+    }
+
+    // The bigram features at 0 are the arcs from begin tag, and the ones at
+    // length are the arcs to end tag
+    for (int position = 0; position < bigram_end[lane]; ++position) {
+      if (position == 0 && begin_tag == -1) continue;
+      int *offset = lane_bigram_offset_.data() + position * bigram_num * L;
+      int feature_num = GetBigramFeatureIds(begin + position, feature_ids);
+      int shift = position == 0? begin_tag * tag_num_: 0;
+      for (int i = 0; i < feature_num; ++i) {
+        offset[i * L + lane] = feature_ids[i] + shift;
+      }
+    }
+  }
+
+  // The lanes out of their sentence are not used, so copy the bigram
+  // features of an active lane to them. Then the bigram features are usually
+  // the same in all lanes, see SimdKernel::lane_max_plus_arc
+  for (int position = 1; position < bucket_num; ++position) {
+    int *offset = lane_bigram_offset_.data() + position * bigram_num * L;
+    int active_lane = 0;
+    while (position >= bigram_end[active_lane]) active_lane++;
+    for (int lane = 0; lane < L; ++lane) {
+      if (position < bigram_end[lane]) continue;
+      for (int i = 0; i < bigram_num; ++i) {
+        offset[i * L + lane] = offset[i * L + active_lane];
+      }
+    }
+  }
+
+  // Viterbi on lanes. The transition step is done in lanes, while the
+  // unigram costs are added to each lane by add_rows after transposing the
+  // costs into [lane][tag], so the float operations are exactly the same as
+  // TagRange
+  const float *cost_data = model_->cost_data();
+  for (int position = 0; position < bucket_num; ++position) {
+    float *cost = lane_bucket_cost_.data() + position * tag_num_ * L;
+    if (position == 0) {
+      std::fill(lane_cost_.begin(), lane_cost_.end(), 0.0f);
+    } else {
+      kernel_->lane_max_plus_arc(
+          cost,
+          lane_bucket_left_tag_.data() + position * tag_num_ * L,
+          cost - tag_num_ * L,
+          cost_data,
+          lane_bigram_offset_.data() + position * bigram_num * L,
+          bigram_num,
+          tag_num_);
+      for (int tag = 0; tag < tag_num_; ++tag) {
+        for (int lane = 0; lane < L; ++lane) {
+          lane_cost_[lane * tag_num_ + tag] = cost[tag * L + lane];
+        }
+      }
+    }
+
+    for (int lane = 0; lane < lane_num; ++lane) {
+      if (position >= length[lane]) continue;
+      float *lane_cost = lane_cost_.data() + lane * tag_num_;
+      if (position == 0 && begin_tag != -1) {
+        int feature_num = 0;
+        for (int i = 0; i < bigram_num; ++i) {
+          int offset = lane_bigram_offset_[i * L + lane];
+          if (offset >= 0) feature_ids[feature_num++] = offset;
+        }
+        kernel_->add_rows(lane_cost,
+                          cost_data,
+                          feature_ids,
+                          feature_num,
+                          tag_num_);
+      }
+      kernel_->add_rows(
+          lane_cost,
+          cost_data,
+          lane_unigram_offset_.data() + (position * L + lane) * unigram_num,
+          lane_unigram_num_[position * L + lane],
+          tag_num_);
+    }
+
+    for (int tag = 0; tag < tag_num_; ++tag) {
+      for (int lane = 0; lane < L; ++lane) {
+        cost[tag * L + lane] = lane_cost_[lane * tag_num_ + tag];
+      }
+    }
+  }
+
+  // Find the best result of each lane
+  for (int lane = 0; lane < lane_num; ++lane) {
+    if (length[lane] == 0) continue;
+    int *result = batch_result_.data() + batch_result_offset_[sentences[lane]];
+    int best_tag_id = 0;
+    if (end_tag != -1) {
+      const int *left_tag = lane_bucket_left_tag_.data() +
+                            length[lane] * tag_num_ * L;
+      best_tag_id = left_tag[end_tag * L + lane];
+    } else {
+      const float *last_cost = lane_bucket_cost_.data() +
+                               (length[lane] - 1) * tag_num_ * L;
+      float best_cost = kMinCost;
+      for (int tag_id = 0; tag_id < tag_num_; ++tag_id) {
+        if (best_cost < last_cost[tag_id * L + lane]) {
+          best_tag_id = tag_id;
+          best_cost = last_cost[tag_id * L + lane];
+        }
+      }
+    }
+
+    for (int position = length[lane] - 1; position >= 0; --position) {
+      result[position] = best_tag_id;
+      const int *left_tag = lane_bucket_left_tag_.data() +
+                            position * tag_num_ * L;
+      best_tag_id = left_tag[best_tag_id * L + lane];
+    }
+  }
+}
+
+void CRFTagger::ProbabilityAtPositions(FeatureExtractor *feature_extractor,
+                                       const int *positions,
+                                       int position_num,
+                                       float *probabilities) {
   feature_extractor_ = feature_extractor;
   ClearFeatureCache();
-  ClearBucket(position);
 
-  CalculateBucketCost(position);
+  for (int i = 0; i < position_num; ++i) {
+    int position = positions[i];
+    ReserveBucket(position + 1);
+    ClearBucket(position);
+    CalculateBucketCost(position);
+
+    // the weight value is in bucket_cost(position), shift it by the maximal
+    // weight before exp to avoid overflow
+    const float *cost = bucket_cost(position);
+    float max_cost = *std::max_element(cost, cost + tag_num_);
+    float *probability = probabilities + i * tag_num_;
+    kernel_->exp(probability, cost, -max_cost, tag_num_);
 
-  // the weight value is in buckets_[position]
-  double sum = 0;
-  for (int tag = 0; tag < model_->GetTagNumber(); ++tag) {
-    probability[tag] = exp(buckets_[position][tag].cost);
-    sum += probability[tag];
-  }
-  for (int tag = 0; tag < model_->GetTagNumber(); ++tag) {
-    probability[tag] /= sum;
+    float sum = 0;
+    for (int tag = 0; tag < tag_num_; ++tag) {
+      sum += probability[tag];
+    }
+    for (int tag = 0; tag < tag_num_; ++tag) {
+      probability[tag] /= sum;
+    }
   }
 }
 
 void CRFTagger::Viterbi(int begin, int end, int begin_tag, int end_tag) {
   assert(begin >= 0 && begin < end && end <= feature_extractor_->size());
   ClearBucket(begin);
-  if (begin_tag != -1) CalculateBeginTagArcCost(begin_tag);
+  if (begin_tag != -1) CalculateBeginTagArcCost(begin, begin_tag);
   CalculateBucketCost(begin);
 
   for (int position = begin + 1; position < end; ++position) {
@@ -144,97 +466,188 @@ void CRFTagger::Viterbi(int begin, int end, int begin_tag, int end_tag) {
   if (end_tag != -1) CalculateArcCost(end);
 }
 
+void CRFTagger::PrunedViterbi(int begin, int end, int begin_tag, int end_tag) {
+  assert(begin >= 0 && begin < end &&
+         end <= static_cast<int>(feature_extractor_->size()));
+  ClearBucket(begin);
+  if (begin_tag != -1) CalculateBeginTagArcCost(begin, begin_tag);
+  CalculateBucketCost(begin);
+  PruneBucket(begin, bucket_cost(begin));
+
+  for (int position = begin + 1; position < end; ++position) {
+    // Prune the tags by unigram cost before the transition step
+    CalculateUnigramCost(position);
+    PruneBucket(position, unigram_cost_.data());
+    CalculatePrunedArcCost(position);
+  }
+
+  // The costs of inactive tags in last bucket are minimal, so the full arc
+  // step is still right for the end tag
+  if (end_tag != -1) CalculateArcCost(end);
+}
+
+void CRFTagger::PruneBucket(int position, const float *cost) {
+  int *active_tag = active_tag_.data() + position * tag_num_;
+  for (int tag = 0; tag < tag_num_; ++tag) active_tag[tag] = tag;
+
+  // Keep the top-k tags, then drop the tags out of delta
+  int active_num = std::min(prune_top_k_, tag_num_);
+  std::partial_sort(active_tag,
+                    active_tag + active_num,
+                    active_tag + tag_num_,
+                    [cost](int t1, int t2) { return cost[t1] > cost[t2]; });
+  // The best tag is always kept, even if delta is negative or NaN
+  float min_cost = cost[active_tag[0]] - prune_delta_;
+  while (active_num > 1 && cost[active_tag[active_num - 1]] < min_cost) {
+    active_num--;
+  }
+
+  // Sort the active tags by id, so that the ties are broken like the exact
+  // Viterbi
+  std::sort(active_tag, active_tag + active_num);
+  active_tag_num_[position] = active_num;
+
+  float *bucket = bucket_cost(position);
+  int active_index = 0;
+  for (int tag = 0; tag < tag_num_; ++tag) {
+    if (active_index < active_num && active_tag[active_index] == tag) {
+      active_index++;
+    } else {
+      bucket[tag] = kMinCost;
+    }
+  }
+}
+
+void CRFTagger::CalculatePrunedArcCost(int position) {
+  int feature_ids[kMaxFeature];
+  int feature_num = GetBigramFeatureIds(position, feature_ids);
+
+  const float *cost_data = model_->cost_data();
+  const float *left_cost = bucket_cost(position - 1);
+  const int *left_active = active_tag_.data() + (position - 1) * tag_num_;
+  int left_active_num = active_tag_num_[position - 1];
+  const int *active = active_tag_.data() + position * tag_num_;
+  int active_num = active_tag_num_[position];
+  float *cost = bucket_cost(position);
+  int *left_tag = bucket_left_tag(position);
+
+  for (int i = 0; i < active_num; ++i) {
+    int right = active[i];
+    float best_cost = kMinCost;
+    int best_left = 0;
+    for (int j = 0; j < left_active_num; ++j) {
+      int left = left_active[j];
+      const float *row = cost_data + left * tag_num_ + right;
+      float arc_cost = left_cost[left];
+      for (int k = 0; k < feature_num; ++k) {
+        arc_cost += row[feature_ids[k]];
+      }
+      if (arc_cost > best_cost) {
+        best_cost = arc_cost;
+        best_left = left;
+      }
+    }
+    cost[right] = best_cost + unigram_cost_[right];
+    left_tag[right] = best_left;
+  }
+}
+
 void CRFTagger::FindBestResult(int begin, int end, int end_tag) {
   int best_tag_id = 0;
-  double best_cost = -1e37;
-  const Node *last_bucket = buckets_[end - 1];
+  float best_cost = kMinCost;
+  const float *last_bucket_cost = bucket_cost(end - 1);
 
   if (end_tag != -1) {
     // Have the end tag ... so find the previous tag pf the end tag
-    best_tag_id = buckets_[end][end_tag].left_tag_id;
+    best_tag_id = bucket_left_tag(end)[end_tag];
   } else {
-    for (int tag_id = 0; tag_id < model_->GetTagNumber(); ++tag_id) {
-      if (best_cost < last_bucket[tag_id].cost) {
+    for (int tag_id = 0; tag_id < tag_num_; ++tag_id) {
+      if (best_cost < last_bucket_cost[tag_id]) {
         best_tag_id = tag_id;
-        best_cost = last_bucket[tag_id].cost;
+        best_cost = last_bucket_cost[tag_id];
       }
     }
   }
 
   for (int position = end - 1; position >= begin; --position) {
     result_[position - begin] = best_tag_id;
-    best_tag_id = buckets_[position][best_tag_id].left_tag_id;
+    best_tag_id = bucket_left_tag(position)[best_tag_id];
   }
 }
 
 void CRFTagger::ClearBucket(int position) {
-  memset(buckets_[position], 0, sizeof(Node) * model_->GetTagNumber());
+  memset(bucket_cost(position), 0, sizeof(float) * tag_num_);
 }
 
-void CRFTagger::CalculateBucketCost(int position) {
-  int feature_ids[kMaxFeature],
-      feature_id;
-  int feature_num = GetUnigramFeatureIds(position, feature_ids);
-  double cost;
-
-  for (int tag_id = 0; tag_id < model_->GetTagNumber(); ++tag_id) {
-    cost = buckets_[position][tag_id].cost;
-    for (int i = 0; i < feature_num; ++i) {
-      feature_id = feature_ids[i];
-      cost += model_->GetUnigramCost(feature_id, tag_id);
+void CRFTagger::CalculateUnigramCost(int position) {
+  float *cached_row = nullptr;
+  if (!score_cache_keys_.empty()) {
+    GetScoreCacheKey(position, &score_cache_key_);
+    size_t slot = std::hash<std::string>()(score_cache_key_) &
+                  score_cache_mask_;
+    cached_row = score_cache_rows_.data() + slot * tag_num_;
+    if (score_cache_keys_[slot] == score_cache_key_) {
+      score_cache_hit_num_++;
+      std::copy(cached_row, cached_row + tag_num_, unigram_cost_.begin());
+      return;
     }
-    buckets_[position][tag_id].cost = cost;
-    // printf("Bucket Cost: %d %s %lf\n", position,
-    // model_->GetTagText(tag_id), cost);
+    score_cache_miss_num_++;
+    score_cache_keys_[slot] = score_cache_key_;
+  }
+
+  int feature_ids[kMaxFeature];
+  int feature_num = GetUnigramFeatureIds(position, feature_ids);
+  std::fill(unigram_cost_.begin(), unigram_cost_.end(), 0.0f);
+  kernel_->add_rows(unigram_cost_.data(),
+                    model_->cost_data(),
+                    feature_ids,
+                    feature_num,
+                    tag_num_);
+
+  if (cached_row) {
+    std::copy(unigram_cost_.begin(), unigram_cost_.end(), cached_row);
   }
 }
 
-void CRFTagger::CalculateBeginTagArcCost(int begin_tag) {
-  int feature_ids[kMaxFeature],
-      feature_id;
-  int feature_num = GetBigramFeatureIds(0, feature_ids);
-  double cost;
-
-  for (int tag_id = 0; tag_id < model_->GetTagNumber(); ++tag_id) {
-    cost = 0;
-    for (int i = 0; i < feature_num; ++i) {
-      feature_id = feature_ids[i];
-      cost += model_->GetBigramCost(feature_id, begin_tag, tag_id);
-    }
-    buckets_[0][tag_id].cost = cost;
+void CRFTagger::CalculateBucketCost(int position) {
+  // The unigram costs are summed before added to bucket, so the costs are the
+  // same with or without the score cache
+  CalculateUnigramCost(position);
+  const int offset = 0;
+  kernel_->add_rows(bucket_cost(position),
+                    unigram_cost_.data(),
+                    &offset,
+                    1,
+                    tag_num_);
+}
+
+void CRFTagger::CalculateBeginTagArcCost(int position, int begin_tag) {
+  int feature_ids[kMaxFeature];
+  int feature_num = GetBigramFeatureIds(position, feature_ids);
+
+  // Costs of the arcs from begin_tag are the row of begin_tag in each bigram
+  // feature, so just add the rows to the cleared bucket
+  for (int i = 0; i < feature_num; ++i) {
+    feature_ids[i] += begin_tag * tag_num_;
   }
+  kernel_->add_rows(bucket_cost(position),
+                    model_->cost_data(),
+                    feature_ids,
+                    feature_num,
+                    tag_num_);
 }
 
 void CRFTagger::CalculateArcCost(int position) {
-  int feature_ids[kMaxFeature],
-      feature_id;
+  int feature_ids[kMaxFeature];
   int feature_num = GetBigramFeatureIds(position, feature_ids);
-  double cost, best_cost;
-  int best_tag_id;
-
-  for (int tag_id = 0; tag_id < model_->GetTagNumber(); ++tag_id) {
-    best_cost = -1e37;
-    for (int left_tag_id = 0;
-         left_tag_id < model_->GetTagNumber();
-         ++left_tag_id) {
-      cost = buckets_[position - 1][left_tag_id].cost;
-      for (int i = 0; i < feature_num; ++i) {
-        feature_id = feature_ids[i];
-        cost += model_->GetBigramCost(feature_id, left_tag_id, tag_id);
-        // printf("Arc Cost: %s %s %lf\n", model_->GetTagText(left_tag_id),
-        // model_->GetTagText(tag_id),
-        // model_->GetBigramCost(feature_id, left_tag_id, tag_id));
-      }
-      if (cost > best_cost) {
-        best_tag_id = left_tag_id;
-        best_cost = cost;
-      }
-    }
-    buckets_[position][tag_id].cost = best_cost;
-    buckets_[position][tag_id].left_tag_id = best_tag_id;
-    // printf("Arc Cost: %d %s %s %lf\n", position, model_->GetTagText(tag_id),
-    // model_->GetTagText(best_tag_id), best_cost);
-  }
+
+  kernel_->max_plus_arc(bucket_cost(position),
+                        bucket_left_tag(position),
+                        bucket_cost(position - 1),
+                        model_->cost_data(),
+                        feature_ids,
+                        feature_num,
+                        tag_num_);
 }
 
 int CRFTagger::GetUnigramFeatureIds(int position, int *feature_ids) {
@@ -278,95 +691,17 @@ int CRFTagger::GetBigramFeatureIds(int position, int *feature_ids) {
   return count;
 }
 
-const char *CRFTagger::GetIndex(const char **pp, int position) {
-  const char *&p = *pp;
-  if (*p++ !='[') {
-    return 0;
-  }
-
-  int col = 0;
-  int row = 0;
-
-  int neg = 1;
-  if (*p++ == '-') {
-    neg = -1;
-  } else {
-    --p;
-  }
-
-  for (; *p; ++p) {
-    switch (*p) {
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        row = 10 * row +(*p - '0');
-        break;
-      case ',':
-        ++p;
-        goto NEXT1;
-      default: return  0;
-    }
-  }
-
-NEXT1:
-  for (; *p; ++p) {
-    switch (*p) {
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        col = 10 * col + (*p - '0');
-        break;
-      case ']': goto NEXT2;
-      default: return 0;
-    }
-  }
-
-NEXT2:
-  row *= neg;
-
-  if (row < -static_cast<int>(kMaxContextSize) ||
-      row > static_cast<int>(kMaxContextSize) ||
-      col < 0 || col >= static_cast<int>(model_->xsize())) {
-    return 0;
-  }
-
-  const int idx = position + row;
-  if (idx < 0) {
-    return BOS[-idx-1];
-  }
-  if (idx >= static_cast<int>(feature_extractor_->size())) {
-    return EOS[idx - feature_extractor_->size()];
-  }
-
-  return GetFeatureAt(idx, col);
-}
-
 bool CRFTagger::ApplyRule(std::string *output_str,
                           const char *template_str,
                           size_t position) {
-  const char *p = template_str,
-             *index_str;
-  output_str->clear();
-  for (; *p; p++) {
-    switch (*p) {
-      default:
-        output_str->push_back(*p);
-        break;
-      case '%':
-        switch (*++p) {
-          case 'x':
-            ++p;
-            index_str = GetIndex(&p, position);
-            if (!index_str) {
-              return false;
-            }
-            output_str->append(index_str);
-            break;
-          default:
-            return false;
-        }
-        break;
-    }
-  }
-  return true;
+  return ApplyCRFTemplate(output_str,
+                          template_str,
+                          position,
+                          feature_extractor_->size(),
+                          xsize_,
+                          [this](int position, int column) {
+                            return GetFeatureAt(position, column);
+                          });
 }
 
 }  // namespace milkcat
@@ -34,10 +34,14 @@
 #ifndef SRC_MILKCAT_CRF_TAGGER_H_
 #define SRC_MILKCAT_CRF_TAGGER_H_
 
+#include <stdint.h>
 #include <string>
+#include <utility>
+#include <vector>
 #include "milkcat/milkcat_config.h"
 #include "milkcat/feature_extractor.h"
 #include "milkcat/crf_model.h"
+#include "milkcat/simd_kernel.h"
 
 namespace milkcat {
 
@@ -45,9 +49,12 @@ class CRFTagger {
  public:
   explicit CRFTagger(const CRFModel *model);
   ~CRFTagger();
-  static const int kMaxBucket = kTokenMax;
   static const int kMaxFeature = 24;
 
+  // Default parameters of the pruned Viterbi decoding
+  static const int kDefaultPruneTopK = 6;
+  static constexpr float kDefaultPruneDelta = 8.0f;
+
   // Tag a range of instance with the begin tag before the result and the end
   // tag after the result
   void TagRange(FeatureExtractor *feature_extractor,
@@ -66,18 +73,61 @@ class CRFTagger {
     TagRange(feature_extractor, 0, feature_extractor->size(), -1, -1);
   }
 
+  // Tag sentence_num ranges [begins[i], ends[i]) of instances
+  // feature_extractors[i] together, with the begin tag before and the end tag
+  // after each range. The sentences are decoded kSimdLaneNum at a time with
+  // the scores of them laid out in lanes, so it is much faster than calling
+  // TagRange one by one for short sentences. The result of sentence i could
+  // be retrieved by GetTagAt(i, position). The pruning is not used in batch
+  void TagBatch(FeatureExtractor **feature_extractors,
+                const int *begins,
+                const int *ends,
+                int sentence_num,
+                int begin_tag,
+                int end_tag);
+
+  // Tag sentence_num instances together, see TagBatch above
+  void TagBatch(FeatureExtractor **feature_extractors, int sentence_num);
+
+  // Tag range_num ranges [begins[i], ends[i]) of one instance together, see
+  // TagBatch above. The features of instance are extracted only once for all
+  // ranges. The result of range i could be retrieved by GetTagAt(i, position)
+  void TagRanges(FeatureExtractor *feature_extractor,
+                 const int *begins,
+                 const int *ends,
+                 int range_num,
+                 int begin_tag,
+                 int end_tag);
+
+  // Get the tag probabilities at some positions in instance, only use the
+  // unigram feature. The probability of tag at positions[i] is written into
+  // probabilities[i * GetTagSize() + tag]. The features of instance are
+  // extracted only once for all positions.
+  void ProbabilityAtPositions(FeatureExtractor *feature_extractor,
+                              const int *positions,
+                              int position_num,
+                              float *probabilities);
+
   // Get the tag probability at one position in instance, only use the unigram
   // feature write the result into probability (probability of tag at
   // probability[tag]).
-  void ProbabilityAtPosition(FeatureExtractor *feature_extractor, 
+  void ProbabilityAtPosition(FeatureExtractor *feature_extractor,
                              int position,
-                             double *probability);
+                             float *probability) {
+    ProbabilityAtPositions(feature_extractor, &position, 1, probability);
+  }
 
   // Get the result tag at position, position starts from 0
   int GetTagAt(int position) {
     return result_[position];
   }
 
+  // Get the result tag at position of sentence in recent TagBatch, position
+  // starts from the begin of the range
+  int GetTagAt(int sentence, int position) {
+    return batch_result_[batch_result_offset_[sentence] + position];
+  }
+
   // Get the number of tags in model
   int GetTagSize() const {
     return model_->GetTagNumber();
@@ -89,22 +139,112 @@ class CRFTagger {
   }
 
   // Get Tag's string text by its id
-  const char *GetTagText(int tag_id) {
+  const char *GetTagText(int tag_id) const {
     return model_->GetTagText(tag_id);
   }
 
- private:
-  struct Node;
+  // Enables the pruned Viterbi decoding. Before the transition step of each
+  // position, only the top_k tags by the unigram cost are kept and the tags
+  // worse than the best one by more than delta are dropped. So the
+  // transition step costs O(top_k^2) instead of O(tag_num^2). top_k = 0
+  // disables the pruning. delta should not be negative, otherwise only the
+  // best tag is kept
+  void set_pruning(int top_k, float delta) {
+    prune_top_k_ = top_k;
+    prune_delta_ = delta;
+  }
+
+  // Enables the cache of unigram score rows with capacity (rounded up to a
+  // power of 2) entries, 0 disables it. The key of an entry is the features
+  // in the window of unigram templates at a position, and the value is the
+  // sum of the cost rows of all unigram features there. So a position whose
+  // window is in the cache costs one hash probe and one contiguous read of
+  // tag costs, instead of expanding the templates and searching each feature.
+  // The cache is direct-mapped, an entry evicts the one in the same slot.
+  // The tags are the same with or without the cache. TagBatch doesn't use
+  // the cache. Resets the counters of cache
+  void set_score_cache_capacity(int capacity);
 
+  // Counters of the score cache, the hit rate is
+  // hit_num / (hit_num + miss_num)
+  int64_t score_cache_hit_num() const { return score_cache_hit_num_; }
+  int64_t score_cache_miss_num() const { return score_cache_miss_num_; }
+
+  // Get the SIMD kernel used in decoding
+  const SimdKernel *kernel() const { return kernel_; }
+
+  // Use kernel in decoding instead of the one from GetSimdKernel(), it is
+  // used to check that all kernels give the same tags
+  void set_kernel(const SimdKernel *kernel) { kernel_ = kernel; }
+
+ private:
   const CRFModel *model_;
-  Node *buckets_[kMaxBucket];
-  int result_[kMaxBucket];
+  const SimdKernel *kernel_;
+  int tag_num_;
+
+  int xsize_;
+
+  // The decode buckets are stored as arrays of float cost and int left tag,
+  // so the kernels could process all tags of a bucket at once. Each bucket
+  // has tag_num_ elements. They grow with the longest sentence ever tagged
+  // plus the extra bucket for the arc to end tag.
+  std::vector<float> bucket_cost_;
+  std::vector<int> bucket_left_tag_;
+  std::vector<int> result_;
   FeatureExtractor *feature_extractor_;
 
-  char feature_cache_[kMaxBucket][kMaxFeature][kFeatureLengthMax];
+  // Parameters and states of the pruned Viterbi. The tags kept at position
+  // are active_tag_[position * tag_num_, position * tag_num_ +
+  // active_tag_num_[position]) in ascending order. unigram_cost_ is the
+  // scratch of unigram cost of current position
+  int prune_top_k_;
+  float prune_delta_;
+  std::vector<int> active_tag_;
+  std::vector<int> active_tag_num_;
+  std::vector<float> unigram_cost_;
+
+  // The cache of unigram score rows, empty if it is disabled. Slot i has the
+  // key score_cache_keys_[i] and the row score_cache_rows_[i * tag_num_, (i
+  // + 1) * tag_num_), the number of slots is score_cache_mask_ + 1. The
+  // unigram templates refer to the (row, column) pairs in score_window_,
+  // where row is relative to the position. score_cache_key_ is the scratch
+  // of key
+  std::vector<std::string> score_cache_keys_;
+  std::vector<float> score_cache_rows_;
+  size_t score_cache_mask_;
+  std::vector<std::pair<int, int>> score_window_;
+  std::string score_cache_key_;
+  int64_t score_cache_hit_num_;
+  int64_t score_cache_miss_num_;
+
+  // States of TagBatch. The lane buckets are laid out as [position][tag]
+  // [lane]. The unigram feature ids are laid out as [position][lane]
+  // [template] with the number of them in lane_unigram_num_, and the bigram
+  // feature ids as [position][template][lane] with -1 for no feature.
+  // lane_cost_ is the scratch of costs in [lane][tag]
+  std::vector<float> lane_bucket_cost_;
+  std::vector<int> lane_bucket_left_tag_;
+  std::vector<int> lane_unigram_offset_;
+  std::vector<int> lane_unigram_num_;
+  std::vector<int> lane_bigram_offset_;
+  std::vector<float> lane_cost_;
+  std::vector<int> batch_order_;
+  std::vector<int> batch_begin_;
+  std::vector<int> batch_end_;
+  std::vector<int> batch_result_;
+  std::vector<int> batch_result_offset_;
+  std::vector<FeatureExtractor *> batch_feature_extractors_;
+
+  // The feature cache of current sentence. Features of a position are
+  // extracted once into feature_buffer_ and then appended to feature_data_
+  // as NUL-terminated strings. feature_offset_[position * xsize_ + column]
+  // is the offset of the feature in feature_data_, feature_offset_[position
+  // * xsize_] is -1 if the position is not extracted yet.
+  char (*feature_buffer_)[kFeatureLengthMax];
+  std::vector<char> feature_data_;
+  std::vector<int> feature_offset_;
   int feature_cache_left_;
   int feature_cache_right_;
-  bool feature_cache_flag_[kMaxBucket];
 
   // Get the feature from cache or feature extractor
   const char *GetFeatureAt(int position, int index);
@@ -120,25 +260,63 @@ class CRFTagger {
   // list
   int GetUnigramFeatureIds(int position, int *feature_ids);
 
+  // Make sure there are at least bucket_num buckets
+  void ReserveBucket(int bucket_num);
+
+  // Get the cost and left tag array of bucket at position
+  float *bucket_cost(int position) {
+    return bucket_cost_.data() + position * tag_num_;
+  }
+  int *bucket_left_tag(int position) {
+    return bucket_left_tag_.data() + position * tag_num_;
+  }
+
   // CLear the decode bucket
   void ClearBucket(int position);
 
+  // Calculate the sum of unigram cost rows of position into unigram_cost_,
+  // from the score cache if it is enabled
+  void CalculateUnigramCost(int position);
+
+  // Get the key of position in score cache into key
+  void GetScoreCacheKey(int position, std::string *key);
+
   // Calculate the unigram cost for each tag in bucket
   void CalculateBucketCost(int position);
 
   // Calcualte the bigram cost from tag to tag in bucket
   void CalculateArcCost(int position);
 
-  // Calculate the cost of the arc from begin tag to all tags in position 0
-  void CalculateBeginTagArcCost(int begin_tag);
+  // Calculate the cost of the arc from begin tag to all tags in position
+  void CalculateBeginTagArcCost(int position, int begin_tag);
+
+  // Selects the active tags at position from cost, and sets the cost of
+  // inactive tags in bucket at position to minimal
+  void PruneBucket(int position, const float *cost);
+
+  // Calculate the bigram cost from the active tags in previous bucket to the
+  // active tags in bucket, then add the unigram cost in unigram_cost_
+  void CalculatePrunedArcCost(int position);
 
   // Viterbi algorithm
   void Viterbi(int begin, int end, int begin_tag, int end_tag);
 
+  // Viterbi algorithm with the tags pruned by their unigram cost
+  void PrunedViterbi(int begin, int end, int begin_tag, int end_tag);
+
   // Get the best tag sequence from Viterbi result
   void FindBestResult(int begin, int end, int end_tag);
 
-  const char *GetIndex(const char **pp, int position);
+  // Tag the sentences in sentences[0, lane_num) of TagBatch in lanes
+  void TagLanes(FeatureExtractor **feature_extractors,
+                const int *begins,
+                const int *ends,
+                const int *sentences,
+                int lane_num,
+                int begin_tag,
+                int end_tag);
+
+  // Expand the template at position into output_str
   bool ApplyRule(std::string *output_str,
                  const char *template_str,
                  size_t position);
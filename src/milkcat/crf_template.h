@@ -0,0 +1,161 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// Part of this code comes from CRF++
+//
+// CRF++ -- Yet Another CRF toolkit
+// Copyright(C) 2005-2007 Taku Kudo <taku@chasen.org>
+//
+// crf_template.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_CRF_TEMPLATE_H_
+#define SRC_MILKCAT_CRF_TEMPLATE_H_
+
+#include <string>
+
+namespace milkcat {
+
+const int kMaxContextSize = 8;
+
+// The feature of position out of the sentence in %x[row,col]
+const char *const kCRFTemplateBOS[kMaxContextSize] = {
+  "_B-1", "_B-2", "_B-3", "_B-4", "_B-5", "_B-6", "_B-7", "_B-8"
+};
+const char *const kCRFTemplateEOS[kMaxContextSize] = {
+  "_B+1", "_B+2", "_B+3", "_B+4", "_B+5", "_B+6", "_B+7", "_B+8"
+};
+
+// Parses the "[row,col]" of %x[row,col] at *pp and returns the feature it
+// refers to at position of a sentence with size positions and xsize columns.
+// get_feature(position, col) returns the feature of position in sentence.
+// Moves *pp to the ']'. Returns nullptr if the index is invalid
+template <class GetFeature>
+const char *GetCRFTemplateIndex(const char **pp,
+                                int position,
+                                int size,
+                                int xsize,
+                                GetFeature get_feature) {
+  const char *&p = *pp;
+  if (*p++ !='[') {
+    return nullptr;
+  }
+
+  int col = 0;
+  int row = 0;
+
+  int neg = 1;
+  if (*p++ == '-') {
+    neg = -1;
+  } else {
+    --p;
+  }
+
+  for (; *p; ++p) {
+    switch (*p) {
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        row = 10 * row +(*p - '0');
+        break;
+      case ',':
+        ++p;
+        goto NEXT1;
+      default: return nullptr;
+    }
+  }
+
+NEXT1:
+  for (; *p; ++p) {
+    switch (*p) {
+      case '0': case '1': case '2': case '3': case '4':
+      case '5': case '6': case '7': case '8': case '9':
+        col = 10 * col + (*p - '0');
+        break;
+      case ']': goto NEXT2;
+      default: return nullptr;
+    }
+  }
+
+NEXT2:
+  row *= neg;
+
+  if (row < -kMaxContextSize || row > kMaxContextSize ||
+      col < 0 || col >= xsize) {
+    return nullptr;
+  }
+
+  const int idx = position + row;
+  if (idx < 0) {
+    return kCRFTemplateBOS[-idx-1];
+  }
+  if (idx >= size) {
+    return kCRFTemplateEOS[idx - size];
+  }
+
+  return get_feature(idx, col);
+}
+
+// Expands the CRF++ template template_str at position into output_str, see
+// GetCRFTemplateIndex for the other parameters. Returns false if the template
+// is invalid
+template <class GetFeature>
+bool ApplyCRFTemplate(std::string *output_str,
+                      const char *template_str,
+                      int position,
+                      int size,
+                      int xsize,
+                      GetFeature get_feature) {
+  const char *p = template_str,
+             *index_str;
+  output_str->clear();
+  for (; *p; p++) {
+    switch (*p) {
+      default:
+        output_str->push_back(*p);
+        break;
+      case '%':
+        switch (*++p) {
+          case 'x':
+            ++p;
+            index_str = GetCRFTemplateIndex(&p,
+                                            position,
+                                            size,
+                                            xsize,
+                                            get_feature);
+            if (!index_str) {
+              return false;
+            }
+            output_str->append(index_str);
+            break;
+          default:
+            return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_CRF_TEMPLATE_H_
@@ -0,0 +1,42 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// emit_cache.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_EMIT_CACHE_H_
+#define SRC_MILKCAT_EMIT_CACHE_H_
+
+#include "milkcat/hmm_model.h"
+#include "milkcat/sharded_lru_cache.h"
+
+namespace milkcat {
+
+// EmitCache is a bounded cache of the emit rows computed by CRFEmitGetter for
+// the OOV words. The key is the CRF feature atoms in the window of a word, so
+// that a hit returns exactly the emits the CRF model would compute
+typedef ShardedLRUCache<HMMModel::Emit> EmitCache;
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_EMIT_CACHE_H_
@@ -0,0 +1,219 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// greedy_part_of_speech_tagger.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/greedy_part_of_speech_tagger.h"
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "milkcat/libmilkcat.h"
+#include "milkcat/part_of_speech_tag_instance.h"
+#include "milkcat/term_instance.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+namespace {
+
+constexpr const char *kBOS = "BOS";
+constexpr const char *kEOS = "EOS";
+
+// Get the term string used in features at position, BOS or EOS if out of the
+// sentence
+const char *TermFeature(const TermInstance *term_instance, int position) {
+  if (position < 0) return kBOS;
+  if (position >= term_instance->size()) return kEOS;
+
+  switch (term_instance->term_type_at(position)) {
+    case TermInstance::kChineseWord:
+      return term_instance->term_text_at(position);
+
+    case TermInstance::kEnglishWord:
+    case TermInstance::kSymbol:
+      return "A";
+
+    case TermInstance::kNumber:
+      return "1";
+
+    default:
+      return ".";
+  }
+}
+
+// Get the length in bytes of the UTF-8 character starting with lead
+int CharacterLength(const char *lead) {
+  uint8_t c = static_cast<uint8_t>(*lead);
+  if (c < 0x80) return 1;
+  if ((c >> 5) == 0x6) return 2;
+  if ((c >> 4) == 0xe) return 3;
+  if ((c >> 3) == 0x1e) return 4;
+  return 1;
+}
+
+// Get the first and the last character of term into prefix and suffix. The
+// terms which are not Chinese words use their class as prefix and suffix
+void TermAffixes(const TermInstance *term_instance,
+                 int position,
+                 char *prefix,
+                 char *suffix) {
+  const char *term = TermFeature(term_instance, position);
+  if (term_instance->term_type_at(position) != TermInstance::kChineseWord) {
+    strlcpy(prefix, term, kFeatureLengthMax);
+    strlcpy(suffix, term, kFeatureLengthMax);
+    return;
+  }
+
+  int length = strlen(term);
+  int prefix_length = std::min(CharacterLength(term), length);
+  strlcpy(prefix, term, prefix_length + 1);
+
+  // Find the lead byte of the last character
+  const char *last = term + length - 1;
+  while (last > term && (static_cast<uint8_t>(*last) & 0xc0) == 0x80) --last;
+  strlcpy(suffix, last, kFeatureLengthMax);
+}
+
+}  // namespace
+
+GreedyPartOfSpeechTagger::GreedyPartOfSpeechTagger(): model_(nullptr),
+                                                      tag_num_(0) {
+}
+
+GreedyPartOfSpeechTagger::~GreedyPartOfSpeechTagger() {
+}
+
+GreedyPartOfSpeechTagger *GreedyPartOfSpeechTagger::New(
+    ModelFactory *model_factory,
+    Status *status) {
+  GreedyPartOfSpeechTagger *self = new GreedyPartOfSpeechTagger();
+  self->model_ = model_factory->MaxentPosModel(status);
+
+  // Look up the features of the previous tags once, so that there is no
+  // string operation of tags in Tag()
+  if (status->ok()) {
+    int tag_num = self->model_->ysize();
+    self->tag_num_ = tag_num;
+    self->tag_costs_.resize(tag_num);
+    self->left_tag_features_.resize(tag_num + 1);
+    self->leftleft_tag_features_.resize((tag_num + 1) * (tag_num + 1));
+
+    std::string feature;
+    for (int left = 0; left <= tag_num; ++left) {
+      const char *left_tag = left < tag_num? self->model_->yname(left): kBOS;
+      self->left_tag_features_[left] = self->FeatureId("T-1:", left_tag);
+
+      for (int leftleft = 0; leftleft <= tag_num; ++leftleft) {
+        feature = leftleft < tag_num? self->model_->yname(leftleft): kBOS;
+        feature += "/";
+        feature += left_tag;
+        self->leftleft_tag_features_[leftleft * (tag_num + 1) + left] =
+            self->FeatureId("T-2:", feature.c_str());
+      }
+    }
+  }
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+int GreedyPartOfSpeechTagger::FeatureId(const char *prefix,
+                                        const char *value) {
+  size_t prefix_length = strlcpy(feature_str_, prefix, kFeatureLengthMax);
+  strlcpy(feature_str_ + prefix_length,
+          value,
+          kFeatureLengthMax - prefix_length);
+  return model_->feature_id(feature_str_);
+}
+
+void GreedyPartOfSpeechTagger::AddFeature(int feature_id) {
+  if (feature_id == MaxentModel::kFeatureIdNone) return;
+
+  const float *cost = model_->cost_row(feature_id);
+  for (int tag = 0; tag < tag_num_; ++tag) {
+    tag_costs_[tag] += cost[tag];
+  }
+}
+
+void GreedyPartOfSpeechTagger::Tag(
+    PartOfSpeechTagInstance *part_of_speech_tag_instance,
+    TermInstance *term_instance) {
+  char prefix[kFeatureLengthMax], suffix[kFeatureLengthMax];
+  int term_num = term_instance->size();
+  int leftleft_tag = tag_num_, left_tag = tag_num_;
+
+  for (int position = 0; position < term_num; ++position) {
+    std::fill(tag_costs_.begin(), tag_costs_.end(), 0.0f);
+
+    TermAffixes(term_instance, position, prefix, suffix);
+    AddFeature(FeatureId("W:", TermFeature(term_instance, position)));
+    AddFeature(FeatureId("W-1:", TermFeature(term_instance, position - 1)));
+    AddFeature(FeatureId("W+1:", TermFeature(term_instance, position + 1)));
+    AddFeature(FeatureId("P:", prefix));
+    AddFeature(FeatureId("S:", suffix));
+    AddFeature(left_tag_features_[left_tag]);
+    AddFeature(leftleft_tag_features_[leftleft_tag * (tag_num_ + 1) +
+                                      left_tag]);
+
+    int tag = std::max_element(tag_costs_.begin(), tag_costs_.end()) -
+              tag_costs_.begin();
+    part_of_speech_tag_instance->set_value_at(position,
+                                              tag,
+                                              model_->yname(tag));
+    leftleft_tag = left_tag;
+    left_tag = tag;
+  }
+
+  part_of_speech_tag_instance->set_size(term_num);
+}
+
+void GreedyPartOfSpeechTagger::ExtractFeatures(
+    const TermInstance *term_instance,
+    int position,
+    const char *leftleft_tag,
+    const char *left_tag,
+    std::vector<std::string> *features) {
+  char prefix[kFeatureLengthMax], suffix[kFeatureLengthMax];
+  TermAffixes(term_instance, position, prefix, suffix);
+
+  features->clear();
+  features->push_back(std::string("W:") +
+                      TermFeature(term_instance, position));
+  features->push_back(std::string("W-1:") +
+                      TermFeature(term_instance, position - 1));
+  features->push_back(std::string("W+1:") +
+                      TermFeature(term_instance, position + 1));
+  features->push_back(std::string("P:") + prefix);
+  features->push_back(std::string("S:") + suffix);
+  features->push_back(std::string("T-1:") + left_tag);
+  features->push_back(std::string("T-2:") + leftleft_tag + "/" + left_tag);
+}
+
+}  // namespace milkcat
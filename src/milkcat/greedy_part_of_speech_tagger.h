@@ -0,0 +1,109 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// greedy_part_of_speech_tagger.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_GREEDY_PART_OF_SPEECH_TAGGER_H_
+#define SRC_MILKCAT_GREEDY_PART_OF_SPEECH_TAGGER_H_
+
+#include <string>
+#include <vector>
+#include "milkcat/milkcat_config.h"
+#include "milkcat/part_of_speech_tagger.h"
+#include "neko/maxent_classifier.h"
+#include "utils/status.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+class ModelFactory;
+class PartOfSpeechTagInstance;
+class TermInstance;
+
+// GreedyPartOfSpeechTagger tags the terms from left to right with one
+// classification of the maximum entropy model per term, and the tags of
+// previous terms are features of the current term. It is much faster than HMM
+// and CRF tagger since there is no search over the tag sequences, but a bit
+// less accurate.
+//
+// The features of the term at position i are
+//   W:<term i>  W-1:<term i-1>  W+1:<term i+1>
+//   P:<first character of term i>  S:<last character of term i>
+//   T-1:<tag i-1>  T-2:<tag i-2>/<tag i-1>
+// The terms and tags out of the sentence are BOS or EOS. Like the features
+// of CRFPartOfSpeechTagger, the terms which are not Chinese words are
+// replaced by their classes: "A" for english words and symbols, "1" for
+// numbers and "." for others
+class GreedyPartOfSpeechTagger: public PartOfSpeechTagger {
+ public:
+  static GreedyPartOfSpeechTagger *New(ModelFactory *model_factory,
+                                       Status *status);
+  ~GreedyPartOfSpeechTagger();
+
+  // Tag the TermInstance and put the result to PartOfSpeechTagInstance
+  void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
+           TermInstance *term_instance);
+
+  int tag_num() const override { return tag_num_; }
+  const char *tag_str(int tag_id) const override {
+    return model_->yname(tag_id);
+  }
+
+  // Extract the feature strings of the term at position into features, where
+  // leftleft_tag and left_tag are the tags of the previous two terms. It is
+  // used to generate the training data of the model
+  static void ExtractFeatures(const TermInstance *term_instance,
+                              int position,
+                              const char *leftleft_tag,
+                              const char *left_tag,
+                              std::vector<std::string> *features);
+
+ private:
+  const MaxentModel *model_;
+  int tag_num_;
+
+  // Feature ids of T-1 indexed by the left tag and T-2 indexed by leftleft
+  // tag * (tag_num_ + 1) + left tag, where tag_num_ stands for BOS
+  std::vector<int> left_tag_features_;
+  std::vector<int> leftleft_tag_features_;
+
+  // The costs of each tag of current term
+  std::vector<float> tag_costs_;
+
+  char feature_str_[kFeatureLengthMax];
+
+  GreedyPartOfSpeechTagger();
+
+  // Get the id of feature prefix + value in model
+  int FeatureId(const char *prefix, const char *value);
+
+  // Add the costs of feature_id to tag_costs_
+  void AddFeature(int feature_id);
+
+  DISALLOW_COPY_AND_ASSIGN(GreedyPartOfSpeechTagger);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_GREEDY_PART_OF_SPEECH_TAGGER_H_
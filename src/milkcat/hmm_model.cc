@@ -28,24 +28,31 @@
 // see also:
 //     TnT -- A Statistical Part-of-Speech Tagger
 //     http://aclweb.org/anthology//A/A00/A00-1031.pdf
+// or the first order Hidden Markov Model with tag bigram transitions
 
 // HMMModel data file struct
 // -------------------------
-// int32_t kHmmModelMagicNumber
+// int32_t kHmmModelCSRMagicNumber or kHmmBigramModelMagicNumber
 // int32_t tag_num
 // int32_t max_termid
 // int32_t emit_num
 // char[kTagStrLenMax * tag_num] tag_str
 // float[tag_num] tag_cost
-// float[tag_num ^ 3] transition_matrix
-// HMMEmitRecord[emit_num] emits
+// float[tag_num ^ 3] or float[tag_num ^ 2] transition_matrix
+// int32_t[max_termid + 2] emit_offset
+// HMMModel::Emit[emit_num] emit_data
+//
+// The old model file (kHmmModelMagicNumber) stores HMMEmitRecord[emit_num]
+// instead of emit_offset and emit_data, it is converted when loading
 
 #include "milkcat/hmm_model.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
+#include <algorithm>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "milkcat/milkcat_config.h"
 #include "milkcat/trie_tree.h"
 #include "utils/utils.h"
@@ -71,8 +78,11 @@ HMMModel *HMMModel::New(const char *model_path, Status *status) {
 
   LOG_IF(status->ok(), "Magic number is %d\n", magic_number);
 
-  if (magic_number != kHmmModelMagicNumber) 
+  if (magic_number != kHmmModelMagicNumber &&
+      magic_number != kHmmModelCSRMagicNumber &&
+      magic_number != kHmmBigramModelMagicNumber)
     *status = Status::Corruption(model_path);
+  if (magic_number == kHmmBigramModelMagicNumber) self->order_ = 1;
 
   if (status->ok()) fd->ReadValue<int32_t>(&(self->tag_num_), status);
   if (status->ok()) fd->ReadValue<int32_t>(&(self->max_term_id_), status);
@@ -80,6 +90,10 @@ HMMModel *HMMModel::New(const char *model_path, Status *status) {
   int tag_num = self->tag_num_;
   int32_t emit_num = 0;
   if (status->ok()) fd->ReadValue<int32_t>(&emit_num, status);
+  if (status->ok() &&
+      !CheckModelSize(self, magic_number, emit_num, fd->Size()))
+    *status = Status::Corruption(model_path);
+  self->emit_num_ = emit_num;
 
   LOG_IF(status->ok(), "Tag number is %d\n", tag_num);
   LOG_IF(status->ok(), "Emit number is %d\n", emit_num);
@@ -95,23 +109,41 @@ HMMModel *HMMModel::New(const char *model_path, Status *status) {
     fd->Read(self->tag_cost_, sizeof(float) * tag_num, status);
   }
   
-  self->transition_matrix_ = new float[tag_num * tag_num * tag_num];
+  int trans_matrix_size = self->trans_matrix_size();
+  self->transition_matrix_ = new float[trans_matrix_size];
   float f_weight;
-  for (int i = 0; i < tag_num * tag_num * tag_num && status->ok(); ++i) {
+  for (int i = 0; i < trans_matrix_size && status->ok(); ++i) {
     fd->ReadValue<float>(&f_weight, status);
     self->transition_matrix_[i] = f_weight;
   }
 
-  self->emits_ = new Emit *[self->max_term_id_ + 1];
-  memset(self->emits_, 0, sizeof(Emit *) * (self->max_term_id_ + 1));
-  HMMEmitRecord emit_record;
-  Emit *emit_node;
-  for (int i = 0; i < emit_num && status->ok(); ++i) {
-    fd->ReadValue<HMMEmitRecord>(&emit_record, status);
-    emit_node = new Emit(emit_record.tag_id, 
-                         emit_record.cost, 
-                         self->emits_[emit_record.term_id]);
-    self->emits_[emit_record.term_id] = emit_node;
+  if (status->ok() && magic_number != kHmmModelMagicNumber) {
+    int row_num = self->max_term_id_ + 1;
+    self->emit_offset_ = new int32_t[row_num + 1];
+    fd->Read(self->emit_offset_, sizeof(int32_t) * (row_num + 1), status);
+
+    self->emit_data_ = new Emit[emit_num];
+    if (status->ok() && emit_num > 0)
+      fd->Read(self->emit_data_, sizeof(Emit) * emit_num, status);
+
+    // Check the offsets since they are used to index emit_data_ directly
+    if (status->ok() && self->emit_offset_[0] != 0)
+      *status = Status::Corruption(model_path);
+    for (int i = 0; i < row_num && status->ok(); ++i) {
+      if (self->emit_offset_[i] > self->emit_offset_[i + 1])
+        *status = Status::Corruption(model_path);
+    }
+    if (status->ok() && self->emit_offset_[row_num] != emit_num)
+      *status = Status::Corruption(model_path);
+
+    // The tags are used to index the transition rows in decoders
+    for (int i = 0; i < emit_num && status->ok(); ++i) {
+      int tag = self->emit_data_[i].tag;
+      if (tag < 0 || tag >= tag_num)
+        *status = Status::Corruption(model_path);
+    }
+  } else if (status->ok()) {
+    LoadEmitFromRecords(self, fd, status);
   }
 
   LOG_IF(status->ok(), "File size: %ld, Tell: %ld\n", fd->Size(), fd->Tell());
@@ -128,6 +160,78 @@ HMMModel *HMMModel::New(const char *model_path, Status *status) {
   }
 }
 
+bool HMMModel::CheckModelSize(const HMMModel *self,
+                              int32_t magic_number,
+                              int32_t emit_num,
+                              int64_t file_size) {
+  if (self->tag_num_ <= 0 || self->max_term_id_ < 0 || emit_num < 0)
+    return false;
+
+  // The offsets of CSR rows are indexed by max_term_id_ + 1
+  if (self->max_term_id_ >= INT32_MAX - 1) return false;
+
+  // Each tag has its text and cost, then the transition matrix follows
+  int64_t tag_num = self->tag_num_;
+  int64_t size = tag_num * (kTagStrLenMax + sizeof(float));
+  if (size > file_size) return false;
+  int64_t trans_size = 1;
+  for (int i = 0; i <= self->order_; ++i) {
+    if (trans_size > file_size / tag_num) return false;
+    trans_size *= tag_num;
+  }
+  size += trans_size * sizeof(float);
+
+  // The emits are records of (term_id, tag_id, cost), or CSR rows of all the
+  // terms
+  if (magic_number == kHmmModelMagicNumber) {
+    size += emit_num * static_cast<int64_t>(sizeof(HMMEmitRecord));
+  } else {
+    size += (self->max_term_id_ + static_cast<int64_t>(2)) * sizeof(int32_t);
+    size += emit_num * static_cast<int64_t>(sizeof(Emit));
+  }
+
+  return size <= file_size;
+}
+
+void HMMModel::LoadEmitFromRecords(HMMModel *self,
+                                   ReadableFile *fd,
+                                   Status *status) {
+  int emit_num = self->emit_num_;
+  int row_num = self->max_term_id_ + 1;
+  std::vector<HMMEmitRecord> emit_records(emit_num);
+  if (emit_num > 0)
+    fd->Read(emit_records.data(), sizeof(HMMEmitRecord) * emit_num, status);
+
+  // Count the emits of each term, then emit_offset_[term_id + 1] is the end
+  // of the row of term_id after the prefix sum
+  self->emit_offset_ = new int32_t[row_num + 1]();
+  for (int i = 0; i < emit_num && status->ok(); ++i) {
+    int term_id = emit_records[i].term_id;
+    int tag_id = emit_records[i].tag_id;
+    if (term_id < 0 || term_id >= row_num) {
+      *status = Status::Corruption("Invalid term id in HMM model.");
+    } else if (tag_id < 0 || tag_id >= self->tag_num_) {
+      *status = Status::Corruption("Invalid tag id in HMM model.");
+    } else {
+      self->emit_offset_[term_id + 1]++;
+    }
+  }
+  for (int i = 0; i < row_num; ++i)
+    self->emit_offset_[i + 1] += self->emit_offset_[i];
+
+  // The linked list model prepends each record to the list of its term, so
+  // fill each row from its end to keep the same emit order
+  self->emit_data_ = new Emit[emit_num];
+  std::vector<int32_t> row_end(self->emit_offset_ + 1,
+                               self->emit_offset_ + row_num + 1);
+  for (int i = 0; i < emit_num && status->ok(); ++i) {
+    const HMMEmitRecord &emit_record = emit_records[i];
+    Emit *emit = self->emit_data_ + --row_end[emit_record.term_id];
+    emit->tag = emit_record.tag_id;
+    emit->cost = emit_record.cost;
+  }
+}
+
 std::unordered_map<std::string, int>
 HMMModel::LoadYTagFromText(HMMModel *self,
                            const char *yset_model_path,
@@ -153,7 +257,7 @@ HMMModel::LoadYTagFromText(HMMModel *self,
 
   if (status->ok()) {
     self->tag_str_ = reinterpret_cast<char (*)[16]>(
-        new char[kTagStrLenMax * y_tag.size()]);
+        new char[kTagStrLenMax * y_tag.size()]());
     for (auto &x: y_tag) {
       strlcpy(self->tag_str_[x.second], x.first.c_str(), kTagStrLenMax);
     }
@@ -178,8 +282,9 @@ void HMMModel::LoadTransFromText(
        tagstr[1024] = "\0";
   double cost = 0;
 
-  int trans_matrix_size = self->tag_num_ * self->tag_num_ * self->tag_num_;
-  self->transition_matrix_ = new float[trans_matrix_size];  
+  // The transitions not in trans_model file are set to zero
+  int trans_matrix_size = self->trans_matrix_size();
+  self->transition_matrix_ = new float[trans_matrix_size]();
 
   // Get the transition data from trans_model file
   ReadableFile *fd = nullptr;
@@ -187,7 +292,7 @@ void HMMModel::LoadTransFromText(
   if (status->ok()) fd = ReadableFile::New(trans_model_path, status);
   while (status->ok() && !fd->Eof()) {
     fd->ReadLine(buff, sizeof(buff), status);
-    if (status->ok()) {
+    if (status->ok() && self->order_ == 2) {
       sscanf(buff, 
              "%s %s %s %lf",
              leftleft_tagstr,
@@ -211,15 +316,31 @@ void HMMModel::LoadTransFromText(
                 tagstr);
         *status = Status::Corruption(buff);
       }
+    } else if (status->ok()) {
+      sscanf(buff, "%s %s %lf", left_tagstr, tagstr, &cost);
+      it_left = y_tag.find(left_tagstr);
+      it_curr = y_tag.find(tagstr);
+
+      // If some tag is not in tag set
+      if (it_curr == y_tag.end() || it_left == y_tag.end()) {
+        sprintf(buff, 
+                "%s: Invalid tag bigram %s %s "
+                "(one of them is not in tag set).", 
+                trans_model_path,
+                left_tagstr,
+                tagstr);
+        *status = Status::Corruption(buff);
+      }
     }
     
     if (status->ok()) {
-      int leftleft_tag = it_leftleft->second;
       int left_tag = it_left->second;
       int curr_tag = it_curr->second;
-      self->transition_matrix_[leftleft_tag * self->tag_num_ * self->tag_num_ +
-                               left_tag * self->tag_num_ +
-                               curr_tag] = static_cast<float>(cost);
+      int index = left_tag * self->tag_num_ + curr_tag;
+      if (self->order_ == 2) {
+        index += it_leftleft->second * self->tag_num_ * self->tag_num_;
+      }
+      self->transition_matrix_[index] = static_cast<float>(cost);
     }
   }
   delete fd;
@@ -238,7 +359,7 @@ void HMMModel::LoadEmitFromText(
   // Get emit data from file
   ReadableFile *fd = nullptr;
   TrieTree *index = nullptr;
-  std::unordered_map<int, Emit *> emit_map;
+  std::unordered_map<int, std::vector<Emit>> emit_map;
   char word[1024] = "\0";
   if (status->ok()) index = DoubleArrayTrieTree::New(index_path, status);
   if (status->ok()) fd = ReadableFile::New(emit_model_path, status);
@@ -270,30 +391,34 @@ void HMMModel::LoadEmitFromText(
     }
 
     if (status->ok()) {
-      auto it_emit = emit_map.find(term_id);
-      if (it_emit == emit_map.end()) {
-        emit_map[term_id] = new Emit(it_curr->second, 
-                                     static_cast<float>(cost),
-                                     nullptr);
-      } else {
-        Emit *next = it_emit->second;
-        emit_map[term_id] = new Emit(it_curr->second, 
-                                     static_cast<float>(cost),
-                                     next);
-      }
+      Emit emit;
+      emit.tag = it_curr->second;
+      emit.cost = static_cast<float>(cost);
+      emit_map[term_id].push_back(emit);
+      self->emit_num_++;
     }
-
-    self->emit_num_++;
   }
   delete fd;
   delete index;
 
+  // Build the emit table, the emits of each term are stored in the reversed
+  // order of the text file as the linked list model did
   if (status->ok()) {
-    self->emits_ = new Emit *[self->max_term_id_ + 1];
-    for (int i = 0; i <= self->max_term_id_; ++i) self->emits_[i] = nullptr;
-    for (auto &x: emit_map) {
-      self->emits_[x.first] = x.second;
+    int row_num = self->max_term_id_ + 1;
+    self->emit_offset_ = new int32_t[row_num + 1];
+    self->emit_data_ = new Emit[self->emit_num_];
+
+    int offset = 0;
+    for (int term_id = 0; term_id < row_num; ++term_id) {
+      self->emit_offset_[term_id] = offset;
+      auto it_emit = emit_map.find(term_id);
+      if (it_emit == emit_map.end()) continue;
+
+      const std::vector<Emit> &emits = it_emit->second;
+      std::copy(emits.rbegin(), emits.rend(), self->emit_data_ + offset);
+      offset += emits.size();
     }
+    self->emit_offset_[row_num] = offset;
   }
 }
 
@@ -302,9 +427,16 @@ HMMModel *HMMModel::NewFromText(const char *trans_model_path,
                                 const char *emit_model_path,
                                 const char *yset_model_path,
                                 const char *index_path,
+                                int order,
                                 Status *status) {
   HMMModel *self = new HMMModel();
-  auto y_tag = LoadYTagFromText(self, yset_model_path, status);
+  if (order != 1 && order != 2) {
+    *status = Status::NotImplemented("Only HMM of order 1 or 2 is supported");
+  }
+
+  self->order_ = order;
+  std::unordered_map<std::string, int> y_tag;
+  if (status->ok()) y_tag = LoadYTagFromText(self, yset_model_path, status);
 
   if (status->ok())
     LoadTransFromText(self, trans_model_path, y_tag, status);
@@ -319,10 +451,87 @@ HMMModel *HMMModel::NewFromText(const char *trans_model_path,
   }
 }
 
+HMMModel *HMMModel::NewFromCosts(const std::vector<std::string> &tags,
+                                 const std::vector<float> &tag_cost,
+                                 const std::vector<float> &transition_matrix,
+                                 const std::vector<std::vector<Emit>> &emits,
+                                 int order,
+                                 Status *status) {
+  HMMModel *self = new HMMModel();
+  if (order != 1 && order != 2) {
+    *status = Status::NotImplemented("Only HMM of order 1 or 2 is supported");
+  }
+
+  char message[1024];
+  self->order_ = order;
+  self->tag_num_ = tags.size();
+  for (const std::string &tag : tags) {
+    if (status->ok() && tag.size() >= kTagStrLenMax) {
+      sprintf(message, "Tag %s is too long", tag.c_str());
+      *status = Status::Corruption(message);
+    }
+  }
+  if (status->ok() &&
+      (static_cast<int>(tag_cost.size()) != self->tag_num_ ||
+       static_cast<int>(transition_matrix.size()) !=
+           self->trans_matrix_size())) {
+    *status = Status::Corruption("Invalid size of tag cost or transitions");
+  }
+
+  if (status->ok()) {
+    self->tag_str_ = reinterpret_cast<char (*)[kTagStrLenMax]>(
+        new char[kTagStrLenMax * self->tag_num_]());
+    for (int i = 0; i < self->tag_num_; ++i) {
+      strlcpy(self->tag_str_[i], tags[i].c_str(), kTagStrLenMax);
+    }
+
+    self->tag_cost_ = new float[self->tag_num_];
+    std::copy(tag_cost.begin(), tag_cost.end(), self->tag_cost_);
+
+    self->transition_matrix_ = new float[transition_matrix.size()];
+    std::copy(transition_matrix.begin(),
+              transition_matrix.end(),
+              self->transition_matrix_);
+  }
+
+  if (status->ok()) {
+    int row_num = std::max(1, static_cast<int>(emits.size()));
+    self->max_term_id_ = row_num - 1;
+    self->emit_num_ = 0;
+    for (const std::vector<Emit> &row : emits) self->emit_num_ += row.size();
+
+    self->emit_offset_ = new int32_t[row_num + 1];
+    self->emit_data_ = new Emit[self->emit_num_];
+    int offset = 0;
+    for (int term_id = 0; term_id < row_num; ++term_id) {
+      self->emit_offset_[term_id] = offset;
+      if (term_id >= static_cast<int>(emits.size())) continue;
+
+      for (const Emit &emit : emits[term_id]) {
+        if (emit.tag < 0 || emit.tag >= self->tag_num_) {
+          *status = Status::Corruption("Invalid tag of emit");
+          break;
+        }
+        self->emit_data_[offset++] = emit;
+      }
+    }
+    self->emit_offset_[row_num] = offset;
+  }
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
 void HMMModel::Save(const char *model_path, Status *status) {
   WritableFile *fd = WritableFile::New(model_path, status);
 
-  if (status->ok()) fd->WriteValue<int32_t>(kHmmModelMagicNumber, status);
+  int32_t magic_number = order_ == 2? kHmmModelCSRMagicNumber:
+                                      kHmmBigramModelMagicNumber;
+  if (status->ok()) fd->WriteValue<int32_t>(magic_number, status);
   if (status->ok()) fd->WriteValue<int32_t>(tag_num_, status);
   if (status->ok()) fd->WriteValue<int32_t>(max_term_id_, status);
   if (status->ok()) fd->WriteValue<int32_t>(emit_num_, status);
@@ -331,37 +540,29 @@ void HMMModel::Save(const char *model_path, Status *status) {
   if (status->ok()) fd->Write(tag_cost_, sizeof(float) * tag_num_, status);
   if (status->ok()) {
     fd->Write(transition_matrix_, 
-              sizeof(float) * tag_num_ * tag_num_ * tag_num_,
+              sizeof(float) * trans_matrix_size(),
               status);
   }
 
-  HMMEmitRecord emit_record;
-  Emit *emit = nullptr;
-
-  int emit_num = 0;
-  for (int term_id = 0; status->ok() && term_id <= max_term_id_; ++term_id) {
-    emit = emits_[term_id];
-    while (status->ok() && emit) {
-      emit_record.term_id = term_id;
-      emit_record.tag_id = emit->tag;
-      emit_record.cost = emit->cost;
-      fd->WriteValue<HMMEmitRecord>(emit_record, status);
-
-      emit = emit->next;
-      emit_num++;
-    }
+  if (status->ok()) {
+    fd->Write(emit_offset_, sizeof(int32_t) * (max_term_id_ + 2), status);
+  }
+  if (status->ok() && emit_num_ > 0) {
+    fd->Write(emit_data_, sizeof(Emit) * emit_num_, status);
   }
 
-  LOG_IF(status->ok(), "%d emit record writted\n", emit_num);
+  LOG_IF(status->ok(), "%d emit record writted\n", emit_num_);
 
   delete fd;
 }
 
 
-HMMModel::HMMModel(): emits_(nullptr),
+HMMModel::HMMModel(): emit_offset_(nullptr),
+                      emit_data_(nullptr),
                       max_term_id_(0),
                       emit_num_(0),
                       tag_num_(0),
+                      order_(2),
                       tag_str_(nullptr),
                       transition_matrix_(nullptr),
                       tag_cost_(nullptr) {
@@ -377,18 +578,11 @@ HMMModel::~HMMModel() {
   delete[] tag_cost_;
   tag_cost_ = nullptr;
 
-  Emit *p, *q;
-  if (emits_ != nullptr) {
-    for (int i = 0; i < max_term_id_ + 1; ++i) {
-      p = emits_[i];
-      while (p) {
-        q = p->next;
-        delete p;
-        p = q;
-      }
-    }
-  }
-  delete[] emits_;
+  delete[] emit_offset_;
+  emit_offset_ = nullptr;
+
+  delete[] emit_data_;
+  emit_data_ = nullptr;
 }
 
 }  // namespace milkcat
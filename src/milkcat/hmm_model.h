@@ -27,31 +27,55 @@
 #ifndef SRC_MILKCAT_HMM_MODEL_H_
 #define SRC_MILKCAT_HMM_MODEL_H_
 
+#include <stdint.h>
 #include <string.h>
+#include <string>
 #include <unordered_map>
+#include <vector>
 #include "utils/status.h"
 
 namespace milkcat {
 
+class ReadableFile;
+
 class HMMModel {
  public:
   struct Emit;
+  class EmitRow;
 
   static HMMModel *New(const char *model_path, Status *status);
 
   // Save the model to file specified by model_path
   void Save(const char *model_path, Status *status);
 
-  // Create the HMMModel instance from some text model file
+  // Create the HMMModel instance from some text model file. order is the
+  // order of the transitions, 2 for tag trigrams (each line of trans_model is
+  // "leftleft left tag cost") and 1 for tag bigrams ("left tag cost")
   static HMMModel *NewFromText(const char *trans_model_path, 
                                const char *emit_model_path,
                                const char *yset_model_path,
                                const char *index_path,
+                               int order,
                                Status *status);
+
+  // Create the HMMModel instance from the costs in memory. tag_cost[i] is
+  // the cost of tags[i], transition_matrix is in the same layout as
+  // trans_cost() (or the bigram one if order is 1) and emits[term_id] is the
+  // emit row of term_id
+  static HMMModel *NewFromCosts(const std::vector<std::string> &tags,
+                                const std::vector<float> &tag_cost,
+                                const std::vector<float> &transition_matrix,
+                                const std::vector<std::vector<Emit>> &emits,
+                                int order,
+                                Status *status);
   ~HMMModel();
 
   int tag_num() const { return tag_num_; }
 
+  // The order of the transitions, 2 for the trigram (TnT) model and 1 for the
+  // bigram model
+  int order() const { return order_; }
+
   // Get Tag's string by its id
   const char *tag_str(int tag_id) const {
     return tag_str_[tag_id];
@@ -67,36 +91,64 @@ class HMMModel {
     return -1;
   }
 
-  // Get the emit row (tag, cost) of a term, if no data return nullptr
-  Emit *emit(int term_id) const {
-    if (term_id > max_term_id_ || term_id < 0)
-      return nullptr;
-    else
-      return emits_[term_id];
-  }
+  // Get the emit row (tag, cost) of a term, if no data returns an empty row
+  inline EmitRow emit(int term_id) const;
 
-  // Get the transition cost from left_tag to right_tag
+  // Get the transition cost from (leftleft_tag, left_tag) to right_tag in the
+  // trigram model
   float trans_cost(int leftleft_tag, int left_tag, int right_tag) const {
     return transition_matrix_[leftleft_tag * tag_num_ * tag_num_ +
                               left_tag * tag_num_ +
                               right_tag];
   }
 
+  // Get the transition costs from (leftleft_tag, left_tag) to all right tags
+  // in the trigram model, the cost to right_tag is at index right_tag of the
+  // returned row
+  const float *trans_row(int leftleft_tag, int left_tag) const {
+    return transition_matrix_ + (leftleft_tag * tag_num_ + left_tag) * tag_num_;
+  }
+
+  // Get the transition costs from left_tag to all right tags in the bigram
+  // model
+  const float *trans_row(int left_tag) const {
+    return transition_matrix_ + left_tag * tag_num_;
+  }
+
   // Get the cost of the probability of single tag
   float tag_cost(int tag_id) const { return tag_cost_[tag_id]; }
 
  private:
   static constexpr int kTagStrLenMax = 16;
-  Emit **emits_;
+
+  // Emits are stored in CSR form: the emits of term_id are
+  // emit_data_[emit_offset_[term_id], emit_offset_[term_id + 1])
+  int32_t *emit_offset_;
+  Emit *emit_data_;
   int max_term_id_;
   int emit_num_;
   int tag_num_;
+  int order_;
   char (* tag_str_)[kTagStrLenMax];
   float *transition_matrix_;
   float *tag_cost_;
 
   HMMModel();
 
+  // Size of transition_matrix_, that is tag_num_ ^ (order_ + 1)
+  int trans_matrix_size() const {
+    int size = tag_num_;
+    for (int i = 0; i < order_; ++i) size *= tag_num_;
+    return size;
+  }
+
+  // Checks the numbers in the header of model file against file_size, so
+  // that the buffers allocated from them are not larger than the file
+  static bool CheckModelSize(const HMMModel *self,
+                             int32_t magic_number,
+                             int32_t emit_num,
+                             int64_t file_size);
+
   static void LoadTransFromText(
       HMMModel *self,
       const char *trans_model_path,
@@ -114,16 +166,47 @@ class HMMModel {
   LoadYTagFromText(HMMModel *self,
                    const char *emit_model_path,
                    Status *status);
+
+  // Read the emit records of the old linked list model format and convert
+  // them into emit_offset_ and emit_data_
+  static void LoadEmitFromRecords(HMMModel *self,
+                                  ReadableFile *fd,
+                                  Status *status);
 };
 
+// Emit has the same layout as in the model file, so that the whole emit table
+// could be read in one pass
+#pragma pack(1)
 struct HMMModel::Emit {
-  int tag;
+  int32_t tag;
   float cost;
-  Emit *next;
+};
+#pragma pack(0)
 
-  Emit(int tag, float cost, Emit *next): tag(tag), cost(cost), next(next) {}
+// A contiguous range of emits for one term
+class HMMModel::EmitRow {
+ public:
+  EmitRow(): begin_(nullptr), end_(nullptr) {}
+  EmitRow(const Emit *begin, const Emit *end): begin_(begin), end_(end) {}
+
+  const Emit *begin() const { return begin_; }
+  const Emit *end() const { return end_; }
+  int size() const { return static_cast<int>(end_ - begin_); }
+  bool empty() const { return begin_ == end_; }
+
+ private:
+  const Emit *begin_;
+  const Emit *end_;
 };
 
+inline HMMModel::EmitRow HMMModel::emit(int term_id) const {
+  if (term_id > max_term_id_ || term_id < 0)
+    return EmitRow();
+  else
+    return EmitRow(emit_data_ + emit_offset_[term_id],
+                   emit_data_ + emit_offset_[term_id + 1]);
+}
+
 }  // namespace milkcat
 
 #endif  // SRC_MILKCAT_HMM_MODEL_H_
@@ -25,8 +25,11 @@
 //
 
 #include "milkcat/hmm_part_of_speech_tagger.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm>
 #include <string>
 #include "milkcat/beam.h"
@@ -40,23 +43,25 @@ namespace milkcat {
 
 struct HMMPartOfSpeechTagger::Node {
   int tag;
-  double cost;
+  float cost;
   const HMMPartOfSpeechTagger::Node *prevoius_node;
 
-  inline void set_value(int tag, int cost, const Node *prevoius_node) {
+  inline void set_value(int tag, float cost, const Node *prevoius_node) {
     this->tag = tag;
     this->cost = cost;
     this->prevoius_node = prevoius_node;
   } 
 };
 
-CRFEmitGetter::CRFEmitGetter(): pool_top_(0),
-                                feature_extractor_(nullptr),
+CRFEmitGetter::CRFEmitGetter(): feature_extractor_(nullptr),
                                 crf_part_of_speech_tagger_(nullptr),
                                 crf_tagger_(nullptr),
-                                probabilities_(nullptr),
                                 crf_to_hmm_tag_(nullptr),
-                                crf_tag_num_(0) {
+                                crf_tag_num_(0),
+                                emit_cache_(nullptr),
+                                window_size_(0),
+                                xsize_(0),
+                                feature_list_(nullptr) {
 }
 
 CRFEmitGetter::~CRFEmitGetter() {
@@ -66,31 +71,30 @@ CRFEmitGetter::~CRFEmitGetter() {
   delete crf_part_of_speech_tagger_;
   crf_part_of_speech_tagger_ = nullptr;
 
-  delete[] probabilities_;
-  probabilities_ = nullptr;
-
   delete[] crf_to_hmm_tag_;
   crf_to_hmm_tag_ = nullptr;
 
-  for (auto &emit : emit_pool_) delete emit;
+  delete[] feature_list_;
+  feature_list_ = nullptr;
 }
 
-CRFEmitGetter *CRFEmitGetter::New(ModelFactory *model_factory, Status *status) {
+CRFEmitGetter *CRFEmitGetter::New(ModelFactory *model_factory,
+                                  const HMMModel *hmm_model,
+                                  EmitCache *emit_cache,
+                                  Status *status) {
   CRFEmitGetter *self = new CRFEmitGetter();
   self->feature_extractor_ = new PartOfSpeechFeatureExtractor();
 
   const CRFModel *crf_model = model_factory->CRFPosModel(status);
-  self->hmm_model_ = nullptr;
+  self->hmm_model_ = hmm_model;
 
   if (status->ok()) {
     self->crf_part_of_speech_tagger_ = new CRFPartOfSpeechTagger(crf_model);
     self->crf_tagger_ = self->crf_part_of_speech_tagger_->crf_tagger();
-    self->hmm_model_ = model_factory->HMMPosModel(status);
   }
 
   if (status->ok()) {
     self->crf_tag_num_ = crf_model->GetTagNumber();
-    self->probabilities_ = new double[self->crf_tag_num_];
     self->crf_to_hmm_tag_ = new int[self->crf_tag_num_];
 
     for (int i = 0; i < self->crf_tag_num_; ++i) {
@@ -99,6 +103,23 @@ CRFEmitGetter *CRFEmitGetter::New(ModelFactory *model_factory, Status *status) {
     }
   }
 
+  // The window of the cache key is the maximal row offset of %x[row,col] in
+  // unigram templates, since only unigram features are used in computing the
+  // probabilities
+  if (status->ok() && emit_cache != nullptr) {
+    self->emit_cache_ = emit_cache;
+    self->xsize_ = crf_model->xsize();
+    self->feature_list_ = new char[self->xsize_][kFeatureLengthMax];
+    for (int i = 0; i < crf_model->UnigramTemplateNum(); ++i) {
+      const char *p = crf_model->GetUnigramTemplate(i);
+      while ((p = strstr(p, "%x[")) != nullptr) {
+        p += 3;
+        int row = abs(atoi(p));
+        if (row > self->window_size_) self->window_size_ = row;
+      }
+    }
+  }
+
   if (status->ok()) {
     return self;
   } else {
@@ -107,46 +128,120 @@ CRFEmitGetter *CRFEmitGetter::New(ModelFactory *model_factory, Status *status) {
   }
 }
 
-HMMModel::Emit *CRFEmitGetter::GetEmits(TermInstance *term_instance, 
-                                        int position) {
-  feature_extractor_->set_term_instance(term_instance);
-  crf_tagger_->ProbabilityAtPosition(feature_extractor_,
-                                     position,
-                                     probabilities_);
-  
-  double max_probability = *std::max_element(probabilities_,
-                                             probabilities_ + crf_tag_num_);
-  HMMModel::Emit *emit = nullptr, *p;
-  for (int crf_tag = 0; crf_tag < crf_tag_num_; ++crf_tag) {
-    if (probabilities_[crf_tag] > 0.2 * max_probability) {
+void CRFEmitGetter::GetCacheKey(int position, std::string *key) {
+  // Each term in window is written as its feature atoms ending with '\0', and
+  // the terms out of the sentence are written as '\1'
+  key->clear();
+  int term_num = feature_extractor_->size();
+  for (int i = position - window_size_; i <= position + window_size_; ++i) {
+    if (i < 0 || i >= term_num) {
+      key->push_back('\1');
+      continue;
+    }
+
+    feature_extractor_->ExtractFeatureAt(i, feature_list_, xsize_);
+    for (int column = 0; column < xsize_; ++column) {
+      key->append(feature_list_[column]);
+      key->push_back('\0');
+    }
+  }
+}
+
+void CRFEmitGetter::AppendEmits(const float *probability) {
+  float max_probability = *std::max_element(probability,
+                                            probability + crf_tag_num_);
+  for (int crf_tag = crf_tag_num_ - 1; crf_tag >= 0; --crf_tag) {
+    if (probability[crf_tag] > 0.2 * max_probability) {
       int hmm_tag = crf_to_hmm_tag_[crf_tag];
       if (hmm_tag < 0) continue;
 
       LOG("Add emit %s cost(T|W)=%.5lf cost(T)=%.5lf\n",
           hmm_model_->tag_str(hmm_tag),
-          -log(probabilities_[crf_tag]),
+          -log(probability[crf_tag]),
           hmm_model_->tag_cost(hmm_tag));
 
-      p = AllocEmit();
-      p->tag = hmm_tag;
-      p->cost = -log(probabilities_[crf_tag]) - hmm_model_->tag_cost(hmm_tag);
-      p->next = emit;
-      emit = p;
+      HMMModel::Emit emit;
+      emit.tag = hmm_tag;
+      emit.cost = -log(probability[crf_tag]) - hmm_model_->tag_cost(hmm_tag);
+      emit_buffer_.push_back(emit);
     }
   }
+}
 
-  return emit;
+void CRFEmitGetter::GetEmits(TermInstance *term_instance,
+                             const int *positions,
+                             int position_num,
+                             HMMModel::EmitRow *emits) {
+  feature_extractor_->set_term_instance(term_instance);
+
+  // Reserve the emits of all positions first, so that the rows will not be
+  // invalidated by the reallocation of emit_buffer_
+  emit_buffer_.clear();
+  emit_buffer_.reserve(position_num * crf_tag_num_);
+  row_begin_.resize(position_num);
+  row_end_.resize(position_num);
+  if (static_cast<int>(cache_keys_.size()) < position_num) {
+    cache_keys_.resize(position_num);
+  }
+
+  // Look up the cache first, only the missed positions are computed by CRF
+  // model
+  missed_positions_.clear();
+  missed_index_.clear();
+  for (int i = 0; i < position_num; ++i) {
+    if (emit_cache_) {
+      GetCacheKey(positions[i], &cache_keys_[i]);
+      if (emit_cache_->Get(cache_keys_[i], &cached_emits_)) {
+        row_begin_[i] = emit_buffer_.size();
+        emit_buffer_.insert(emit_buffer_.end(),
+                            cached_emits_.begin(),
+                            cached_emits_.end());
+        row_end_[i] = emit_buffer_.size();
+        continue;
+      }
+    }
+
+    missed_positions_.push_back(positions[i]);
+    missed_index_.push_back(i);
+  }
+
+  int missed_num = missed_positions_.size();
+  if (missed_num != 0) {
+    if (static_cast<int>(probabilities_.size()) < missed_num * crf_tag_num_) {
+      probabilities_.resize(missed_num * crf_tag_num_);
+    }
+    crf_tagger_->ProbabilityAtPositions(feature_extractor_,
+                                        missed_positions_.data(),
+                                        missed_num,
+                                        probabilities_.data());
+  }
+
+  for (int k = 0; k < missed_num; ++k) {
+    int i = missed_index_[k];
+    row_begin_[i] = emit_buffer_.size();
+    AppendEmits(probabilities_.data() + k * crf_tag_num_);
+    row_end_[i] = emit_buffer_.size();
+
+    if (emit_cache_) {
+      emit_cache_->Put(cache_keys_[i],
+                       emit_buffer_.data() + row_begin_[i],
+                       row_end_[i] - row_begin_[i]);
+    }
+  }
+
+  for (int i = 0; i < position_num; ++i) {
+    emits[i] = HMMModel::EmitRow(emit_buffer_.data() + row_begin_[i],
+                                 emit_buffer_.data() + row_end_[i]);
+  }
 }
 
 HMMPartOfSpeechTagger::HMMPartOfSpeechTagger(): node_pool_(nullptr),
                                                 model_(nullptr),
                                                 index_(nullptr),
+                                                user_index_(nullptr),
                                                 crf_emit_getter_(nullptr),
-                                                PU_emit_(nullptr),
-                                                CD_emit_(nullptr),
-                                                NN_emit_(nullptr),
-                                                oov_emits_(nullptr),
-                                                term_instance_(nullptr) {
+                                                term_instance_(nullptr),
+                                                kernel_(GetSimdKernel()) {
   for (int i = 0; i < kMaxBeams; ++i) {
     beams_[i] = nullptr;
   }
@@ -156,15 +251,6 @@ HMMPartOfSpeechTagger::~HMMPartOfSpeechTagger() {
   delete node_pool_;
   node_pool_ = nullptr;
 
-  delete PU_emit_;
-  PU_emit_ = nullptr;
-
-  delete CD_emit_;
-  CD_emit_ = nullptr;
-
-  delete NN_emit_;
-  NN_emit_ = nullptr;
-
   delete crf_emit_getter_;
   crf_emit_getter_ = nullptr;
 
@@ -173,14 +259,6 @@ HMMPartOfSpeechTagger::~HMMPartOfSpeechTagger() {
       delete beams_[i];
     beams_[i] = nullptr;
   }
-
-  HMMModel::Emit *p = oov_emits_, *q;
-  while (p) {
-    q = p->next;
-    delete p;
-    p = q;
-  }
-  oov_emits_ = nullptr;
 }
 
 namespace {
@@ -191,20 +269,19 @@ bool HmmNodePtrCmp(HMMPartOfSpeechTagger::Node *n1,
   return n1->cost < n2->cost;
 }
 
-// New an emit node for tag specified by tag_str. If tag_str not exist in model
-// return a nullptr and status indicates an corruption error.
-HMMModel::Emit *NewEmitFromTag(const char *tag_str,
-                               const HMMModel *model,
-                               Status *status) {
+// Set emit to the tag specified by tag_str with zero cost. If tag_str not
+// exist in model status indicates an corruption error.
+void SetEmitFromTag(const char *tag_str,
+                    const HMMModel *model,
+                    HMMModel::Emit *emit,
+                    Status *status) {
   int tagid = model->tag_id(tag_str);
   if (tagid < 0) *status = Status::Corruption("Invalid HMM model.");
 
-  HMMModel::Emit *emit = nullptr;
   if (status->ok()) {
-    emit = new HMMModel::Emit(tagid, 0.0, nullptr);
+    emit->tag = tagid;
+    emit->cost = 0.0;
   }
-
-  return emit;
 }
 
 }  // namespace
@@ -213,60 +290,75 @@ void HMMPartOfSpeechTagger::InitEmit(HMMPartOfSpeechTagger *self,
                                      Status *status) {
 
   if (status->ok()) 
-    self->PU_emit_ = NewEmitFromTag("PU", self->model_, status);
+    SetEmitFromTag("PU", self->model_, &self->PU_emit_, status);
   if (status->ok()) 
-    self->CD_emit_ = NewEmitFromTag("CD", self->model_, status);
+    SetEmitFromTag("CD", self->model_, &self->CD_emit_, status);
   if (status->ok()) 
-    self->NN_emit_ = NewEmitFromTag("NN", self->model_, status);
+    SetEmitFromTag("NN", self->model_, &self->NN_emit_, status);
 
   // Create the default emits
-  HMMModel::Emit *emit = nullptr, *p;
-  if (status->ok()) {
-    p = NewEmitFromTag("NN", self->model_, status);
-    p->next = emit;
-    emit = p;
-  }
-  if (status->ok()) {
-    p = NewEmitFromTag("VV", self->model_, status);
-    p->next = emit;
-    emit = p;
-  }
-  if (status->ok()) {
-    p = NewEmitFromTag("VA", self->model_, status);
-    p->next = emit;
-    emit = p;
-  }
-  if (status->ok()) {
-    p = NewEmitFromTag("AD", self->model_, status);
-    p->next = emit;
-    self->oov_emits_ = p;   
+  const char *oov_tags[kOOVEmitNum] = {"NR", "VA", "VV", "NN"};
+  for (int i = 0; i < kOOVEmitNum && status->ok(); ++i) {
+    SetEmitFromTag(oov_tags[i], self->model_, &self->oov_emits_[i], status);
   }
+}
+
+void HMMPartOfSpeechTagger::InitUserEmit(HMMPartOfSpeechTagger *self,
+                                         ModelFactory *model_factory,
+                                         Status *status) {
+  const std::vector<std::string> *user_tags = nullptr;
+  if (status->ok()) self->user_index_ = model_factory->UserIndex(status);
+  if (status->ok()) user_tags = model_factory->UserTag(status);
+
+  // The tags not in model are ignored, these words are treated as OOV words
   if (status->ok()) {
-    p = NewEmitFromTag("NR", self->model_, status);
-    p->next = emit;
-    self->oov_emits_ = p;   
+    self->user_emits_.resize(user_tags->size());
+    for (size_t i = 0; i < user_tags->size(); ++i) {
+      const char *tag_str = user_tags->at(i).c_str();
+      HMMModel::Emit *emit = &self->user_emits_[i];
+      emit->tag = *tag_str? self->model_->tag_id(tag_str): -1;
+      emit->cost = 0.0;
+      LOG_IF(*tag_str && emit->tag < 0, "Invalid user tag %s\n", tag_str);
+    }
   }
 }
 
 HMMPartOfSpeechTagger *HMMPartOfSpeechTagger::New(
     ModelFactory *model_factory,
     bool use_crf,
+    bool first_order,
+    int beam_size,
     Status *status) {
   HMMPartOfSpeechTagger *self = new HMMPartOfSpeechTagger();
-  self->node_pool_ = new NodePool<Node>(); 
 
-  for (int i = 0; i < kMaxBeams; ++i) {
-    self->beams_[i] = new Beam<Node>(kBeamSize,
-                                     self->node_pool_,
-                                     i,
-                                     HmmNodePtrCmp);
+  if (first_order) {
+    self->model_ = model_factory->HMMBigramPosModel(status);
+  } else {
+    self->model_ = model_factory->HMMPosModel(status);
   }
 
-  self->model_ = model_factory->HMMPosModel(status);
+  // Only the second order model is decoded with beams
+  if (status->ok() && self->model_->order() == 2) {
+    self->node_pool_ = new NodePool<Node>(); 
+    for (int i = 0; i < kMaxBeams; ++i) {
+      self->beams_[i] = new Beam<Node>(beam_size,
+                                       self->node_pool_,
+                                       i,
+                                       HmmNodePtrCmp);
+    }
+  }
 
   if (status->ok()) InitEmit(self, status);
-  if (status->ok() && use_crf) 
-    self->crf_emit_getter_ = CRFEmitGetter::New(model_factory, status);
+  if (status->ok() && model_factory->HasUserDictionary()) {
+    InitUserEmit(self, model_factory, status);
+  }
+  if (status->ok() && use_crf) {
+    self->crf_emit_getter_ = CRFEmitGetter::New(
+        model_factory,
+        self->model_,
+        first_order? nullptr: model_factory->OOVEmitCache(),
+        status);
+  }
   if (status->ok()) {
     self->BOS_tagid_ = self->model_->tag_id("BOS");
     if (self->BOS_tagid_ < 0) 
@@ -280,6 +372,7 @@ HMMPartOfSpeechTagger *HMMPartOfSpeechTagger::New(
   }
 
   if (status->ok()) self->index_ = model_factory->Index(status);
+  if (status->ok()) self->ReserveBuffers(beam_size, kOOVEmitNum);
 
   if (status->ok()) {
     return self;
@@ -289,40 +382,74 @@ HMMPartOfSpeechTagger *HMMPartOfSpeechTagger::New(
   }
 }
 
-HMMModel::Emit *HMMPartOfSpeechTagger::GetEmitAtPosition(int position) {
+HMMModel::EmitRow HMMPartOfSpeechTagger::GetEmitAtPosition(int position) {
   int term_id;
-  HMMModel::Emit *emit;
+  HMMModel::EmitRow emit;
 
   term_id = term_instance_->term_id_at(position);
   if (term_id == TermInstance::kTermIdNone) {
-    term_id = index_->Search(term_instance_->term_text_at(position));
+    const char *term_text = term_instance_->term_text_at(position);
+    term_id = index_->Search(term_text);
+    if (term_id < 0 && user_index_) term_id = user_index_->Search(term_text);
+  }
+
+  // User words with a part-of-speech tag get their emit directly
+  if (term_id >= kUserTermIdStart) {
+    int user_term_id = term_id - kUserTermIdStart;
+    if (user_term_id < static_cast<int>(user_emits_.size()) &&
+        user_emits_[user_term_id].tag >= 0) {
+      const HMMModel::Emit *user_emit = &user_emits_[user_term_id];
+      return HMMModel::EmitRow(user_emit, user_emit + 1);
+    }
   }
 
   emit = model_->emit(term_id);
-  if (emit == nullptr) {
+  if (emit.empty()) {
     int term_type = term_instance_->term_type_at(position);
     switch (term_type) {
       case TermInstance::kPunction:
       case TermInstance::kSymbol:
       case TermInstance::kOther:
-        emit = PU_emit_;
+        emit = HMMModel::EmitRow(&PU_emit_, &PU_emit_ + 1);
         break;
       case TermInstance::kNumber:
-        emit = CD_emit_;
+        emit = HMMModel::EmitRow(&CD_emit_, &CD_emit_ + 1);
         break;
       case TermInstance::kEnglishWord:
-        emit = NN_emit_;
+        emit = HMMModel::EmitRow(&NN_emit_, &NN_emit_ + 1);
         break;
     }
   }
 
-  if (emit == nullptr && crf_emit_getter_) {
-      emit = crf_emit_getter_->GetEmits(term_instance_, position);
+  return emit;
+}
+
+void HMMPartOfSpeechTagger::GetEmits() {
+  emits_.resize(term_instance_->size());
+  oov_positions_.clear();
+  for (int i = 0; i < term_instance_->size(); ++i) {
+    emits_[i] = GetEmitAtPosition(i);
+    if (emits_[i].empty()) oov_positions_.push_back(i);
   }
 
-  if (emit == nullptr) emit = oov_emits_;
+  // Get the emits of all OOV words from CRF model at once, since the features
+  // of the sentence could be shared
+  if (crf_emit_getter_ && oov_positions_.size() != 0) {
+    oov_position_emits_.resize(oov_positions_.size());
+    crf_emit_getter_->GetEmits(term_instance_,
+                               oov_positions_.data(),
+                               oov_positions_.size(),
+                               oov_position_emits_.data());
+    for (size_t i = 0; i < oov_positions_.size(); ++i) {
+      emits_[oov_positions_[i]] = oov_position_emits_[i];
+    }
+  }
 
-  return emit;
+  for (int i = 0; i < term_instance_->size(); ++i) {
+    if (emits_[i].empty()) {
+      emits_[i] = HMMModel::EmitRow(oov_emits_, oov_emits_ + kOOVEmitNum);
+    }
+  }
 }
 
 inline void HMMPartOfSpeechTagger::AddBOSNodeToBeam() {
@@ -345,6 +472,7 @@ inline void HMMPartOfSpeechTagger::GetBestPOSTagFromBeam(
 
   while (node->tag != BOS_tagid_) {
     part_of_speech_tag_instance->set_value_at(position,
+                                              node->tag,
                                               model_->tag_str(node->tag));
     position--;
     node = node->prevoius_node;
@@ -358,26 +486,115 @@ void HMMPartOfSpeechTagger::Tag(
     TermInstance *term_instance) {
   term_instance_ = term_instance;
 
-  AddBOSNodeToBeam();
+  GetEmits();
+  if (model_->order() == 1) {
+    FirstOrderViterbi(part_of_speech_tag_instance);
+  } else {
+    AddBOSNodeToBeam();
+
+    // Viterbi algorithm
+    for (int i = 0; i < term_instance->size(); ++i)
+      BuildBeam(i);
 
-  // Viterbi algorithm
-  for (int i = 0; i < term_instance->size(); ++i)
-    BuildBeam(i);
+    // Find the best result
+    GetBestPOSTagFromBeam(part_of_speech_tag_instance);
 
-  // Find the best result
-  GetBestPOSTagFromBeam(part_of_speech_tag_instance);
+    node_pool_->ReleaseAll();
+  }
+
+  if (crf_emit_getter_) crf_emit_getter_->ReleaseAllEmits();
+}
 
-  node_pool_->ReleaseAll();
+void HMMPartOfSpeechTagger::ReserveBuffers(int context_num, int emit_num) {
+  if (static_cast<int>(context_cost_.size()) < context_num) {
+    context_cost_.resize(context_num);
+    trans_rows_.resize(context_num);
+  }
+  if (static_cast<int>(emit_tag_.size()) < emit_num) {
+    emit_tag_.resize(emit_num);
+    emit_cost_.resize(emit_num);
+    emit_context_.resize(emit_num);
+  }
+}
+
+void HMMPartOfSpeechTagger::FirstOrderViterbi(
+    PartOfSpeechTagInstance *part_of_speech_tag_instance) {
+  int term_num = term_instance_->size();
+  part_of_speech_tag_instance->set_size(term_num);
+  if (term_num == 0) return;
+
+  lattice_offset_.resize(term_num + 1);
+  int lattice_size = 0;
+  for (int i = 0; i < term_num; ++i) {
+    lattice_offset_[i] = lattice_size;
+    lattice_size += emits_[i].size();
+  }
+  lattice_offset_[term_num] = lattice_size;
+  if (static_cast<int>(lattice_cost_.size()) < lattice_size) {
+    lattice_cost_.resize(lattice_size);
+    lattice_previous_.resize(lattice_size);
+  }
+
+  // Each emit of previous position is a context, and the only context of the
+  // first position is BOS
+  for (int position = 0; position < term_num; ++position) {
+    HMMModel::EmitRow emit_row = emits_[position];
+    int emit_num = emit_row.size();
+    int context_num;
+    if (position == 0) {
+      context_num = 1;
+      ReserveBuffers(context_num, emit_num);
+      context_cost_[0] = 0.0f;
+      trans_rows_[0] = model_->trans_row(BOS_tagid_);
+    } else {
+      HMMModel::EmitRow previous_row = emits_[position - 1];
+      const float *previous_cost = lattice_cost_.data() +
+                                   lattice_offset_[position - 1];
+      context_num = previous_row.size();
+      ReserveBuffers(context_num, emit_num);
+      for (int i = 0; i < context_num; ++i) {
+        context_cost_[i] = previous_cost[i];
+        trans_rows_[i] = model_->trans_row(previous_row.begin()[i].tag);
+      }
+    }
+
+    for (int j = 0; j < emit_num; ++j) {
+      emit_tag_[j] = emit_row.begin()[j].tag;
+    }
+
+    float *cost = lattice_cost_.data() + lattice_offset_[position];
+    int *previous = lattice_previous_.data() + lattice_offset_[position];
+    kernel_->min_plus_trans(cost,
+                            previous,
+                            context_cost_.data(),
+                            trans_rows_.data(),
+                            context_num,
+                            emit_tag_.data(),
+                            emit_num);
+    for (int j = 0; j < emit_num; ++j) {
+      cost[j] += emit_row.begin()[j].cost;
+    }
+  }
+
+  // Find the best emit of last position and trace back
+  int position = term_num - 1;
+  const float *last_cost = lattice_cost_.data() + lattice_offset_[position];
+  int best = std::min_element(last_cost,
+                              last_cost + emits_[position].size()) - last_cost;
+  for (; position >= 0; --position) {
+    int tag = emits_[position].begin()[best].tag;
+    part_of_speech_tag_instance->set_value_at(position,
+                                              tag,
+                                              model_->tag_str(tag));
+    best = lattice_previous_[lattice_offset_[position] + best];
+  }
 }
 
 void HMMPartOfSpeechTagger::BuildBeam(int position) {
   // Beam has two BOS node at 0 and 1
   int beam_position = position + 2;
 
-  HMMModel::Emit *emit = GetEmitAtPosition(position);
-
-  const Node *leftleft_node, *left_node;
-  int leftleft_tag, left_tag;
+  HMMModel::EmitRow emit_row = emits_[position];
 
   Beam<Node> *previous_beam = beams_[beam_position - 1];
   Beam<Node> *beam = beams_[beam_position];
@@ -385,51 +602,46 @@ void HMMPartOfSpeechTagger::BuildBeam(int position) {
   previous_beam->Shrink();
   beam->Clear();
 
-  double min_cost;
-  const Node *min_left_node;
-  while (emit) {
-    min_cost = 1e38;
-    min_left_node = nullptr;
-    for (int i = 0; i < previous_beam->size(); ++i) {
-      left_node = previous_beam->node_at(i);
-      leftleft_node = left_node->prevoius_node;
-
-      leftleft_tag = leftleft_node->tag;
-      left_tag = left_node->tag;
-
-      // If current word has emit information or current word is punction or 
-      // symbol
-
-      double trans_cost = model_->trans_cost(leftleft_tag, 
-                                             left_tag, 
-                                             emit->tag);
-      double emit_cost = emit->cost;
-      double cost = left_node->cost + trans_cost + emit_cost;
-      if (cost < min_cost) {
-        min_cost = cost;
-        min_left_node = left_node;
-      }
+  // Each node in previous beam is a (leftleft, left) context, get the best
+  // context of all emits at once
+  int context_num = previous_beam->size();
+  for (int i = 0; i < context_num; ++i) {
+    const Node *left_node = previous_beam->node_at(i);
+    context_cost_[i] = left_node->cost;
+    trans_rows_[i] = model_->trans_row(left_node->prevoius_node->tag,
+                                       left_node->tag);
+  }
 
-      LOG("%s %s %s %s "
-          "total_cost = %lf cost = %lf trans_cost = %lf emit_cost = %lf\n",
-          term_instance_->term_text_at(position),
-          model_->tag_str(leftleft_tag), 
-          model_->tag_str(left_tag),
-          model_->tag_str(emit->tag),
-          cost,
-          trans_cost + emit_cost,
-          trans_cost,
-          emit_cost);
-    }
+  int emit_num = emit_row.size();
+  ReserveBuffers(0, emit_num);
+  for (int j = 0; j < emit_num; ++j) {
+    emit_tag_[j] = emit_row.begin()[j].tag;
+  }
+  kernel_->min_plus_trans(emit_cost_.data(),
+                          emit_context_.data(),
+                          context_cost_.data(),
+                          trans_rows_.data(),
+                          context_num,
+                          emit_tag_.data(),
+                          emit_num);
+
+  for (int j = 0; j < emit_num; ++j) {
+    const HMMModel::Emit *emit = emit_row.begin() + j;
+    const Node *left_node = previous_beam->node_at(emit_context_[j]);
+    float cost = emit_cost_[j] + emit->cost;
+
+    LOG("%s %s %s %s total_cost = %f emit_cost = %f\n",
+        term_instance_->term_text_at(position),
+        model_->tag_str(left_node->prevoius_node->tag),
+        model_->tag_str(left_node->tag),
+        model_->tag_str(emit->tag),
+        cost,
+        emit->cost);
 
     Node *node = node_pool_->Alloc();
-    node->set_value(emit->tag, min_cost, min_left_node);
+    node->set_value(emit->tag, cost, left_node);
     beam->Add(node); 
-
-    emit = emit->next;
   }
-
-  if (crf_emit_getter_) crf_emit_getter_->ReleaseAllEmits();
 }
 
 }  // namespace milkcat
@@ -28,19 +28,25 @@
 // see also:
 //     TnT -- A Statistical Part-of-Speech Tagger
 //     http://aclweb.org/anthology//A/A00/A00-1031.pdf
+// or the first order Hidden Markov Model, which is decoded by exact Viterbi
+// without beams
 // 
 // Use CRF model to get emit probabilities of OOV words
 
 #ifndef SRC_MILKCAT_HMM_PART_OF_SPEECH_TAGGER_H_
 #define SRC_MILKCAT_HMM_PART_OF_SPEECH_TAGGER_H_
 
+#include <string>
+#include <vector>
 #include "milkcat/beam.h"
 #include "milkcat/crf_part_of_speech_tagger.h"
 #include "milkcat/darts.h"
+#include "milkcat/emit_cache.h"
 #include "milkcat/hmm_model.h"
 #include "milkcat/libmilkcat.h"
 #include "milkcat/milkcat_config.h"
 #include "milkcat/part_of_speech_tagger.h"
+#include "milkcat/simd_kernel.h"
 #include "milkcat/trie_tree.h"
 #include "utils/status.h"
 #include "utils/utils.h"
@@ -53,20 +59,39 @@ class Configuration;
 
 class CRFEmitGetter {
  public:
-  static CRFEmitGetter *New(ModelFactory *model_factory, Status *status);
+  // Create the CRFEmitGetter that gets emits in the tag set of hmm_model. If
+  // emit_cache is not nullptr, the emits are looked up in emit_cache before
+  // computing by CRF model, and the computed emits are put into it
+  static CRFEmitGetter *New(ModelFactory *model_factory,
+                            const HMMModel *hmm_model,
+                            EmitCache *emit_cache,
+                            Status *status);
   ~CRFEmitGetter();
 
-  // Get the emit link list of term specified by position in term_instance
-  // using CRF model. The emit nodes alloced by this function should release by
-  // calling CRFEmitGetter::ReleaseAllEmits()
-  HMMModel::Emit *GetEmits(TermInstance *term_instance, int position);
+  // Get the emit rows of terms specified by positions in term_instance using
+  // CRF model, the emit row of positions[i] is written into emits[i]. All
+  // positions are computed in one pass over the term_instance. The emits
+  // pointed by the rows are valid until the next call of GetEmits or
+  // CRFEmitGetter::ReleaseAllEmits()
+  void GetEmits(TermInstance *term_instance,
+                const int *positions,
+                int position_num,
+                HMMModel::EmitRow *emits);
+
+  // Get the emit row of term specified by position in term_instance using
+  // CRF model. The emits pointed by the row are valid until the next call of
+  // GetEmits or CRFEmitGetter::ReleaseAllEmits()
+  HMMModel::EmitRow GetEmits(TermInstance *term_instance, int position) {
+    HMMModel::EmitRow emit;
+    GetEmits(term_instance, &position, 1, &emit);
+    return emit;
+  }
 
-  // Release all emit nodes alloced by GetEmits
-  void ReleaseAllEmits() { pool_top_ = 0; }
+  // Release all emits alloced by GetEmits
+  void ReleaseAllEmits() { emit_buffer_.clear(); }
 
  private:
-  std::vector<HMMModel::Emit *> emit_pool_;
-  int pool_top_;
+  std::vector<HMMModel::Emit> emit_buffer_;
   PartOfSpeechFeatureExtractor *feature_extractor_;
 
   CRFPartOfSpeechTagger *crf_part_of_speech_tagger_;
@@ -74,22 +99,34 @@ class CRFEmitGetter {
 
   const HMMModel *hmm_model_;
 
-  double *probabilities_;
+  std::vector<float> probabilities_;
   int *crf_to_hmm_tag_;
   int crf_tag_num_;
 
+  // The probabilities of a term depend only on the CRF feature atoms of the
+  // terms in [position - window_size_, position + window_size_], they are
+  // used as the key of emit_cache_
+  EmitCache *emit_cache_;
+  int window_size_;
+  int xsize_;
+  char (*feature_list_)[kFeatureLengthMax];
+
+  // Buffers of GetEmits
+  std::vector<std::string> cache_keys_;
+  std::vector<HMMModel::Emit> cached_emits_;
+  std::vector<int> missed_positions_;
+  std::vector<int> missed_index_;
+  std::vector<int> row_begin_;
+  std::vector<int> row_end_;
+
   CRFEmitGetter();
 
-  HMMModel::Emit *AllocEmit() {
-    if (pool_top_ < emit_pool_.size()) {
-      return emit_pool_[pool_top_++];
-    } else {
-      HMMModel::Emit *emit = new HMMModel::Emit(0, 0.0, nullptr);
-      pool_top_++;
-      emit_pool_.push_back(emit);
-      return emit;
-    }
-  }
+  // Get the key of emit_cache_ for the term at position
+  void GetCacheKey(int position, std::string *key);
+
+  // Append the emits of a term into emit_buffer_ from its probabilities of
+  // CRF tags
+  void AppendEmits(const float *probability);
 };
 
 class HMMPartOfSpeechTagger: public PartOfSpeechTagger {
@@ -98,39 +135,86 @@ class HMMPartOfSpeechTagger: public PartOfSpeechTagger {
 
   // Beam size, two position for BOS node
   static const int kMaxBeams = kTokenMax + 2;
-  static const int kBeamSize = 3;
+  static const int kDefaultBeamSize = 3;
 
   ~HMMPartOfSpeechTagger();
   void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
            TermInstance *term_instance);
 
+  // Create the tagger with the second order HMM model, or the first order
+  // model if first_order is true. If use_crf is true, the emits of OOV words
+  // are computed by CRF model. beam_size is the number of nodes kept in each
+  // position when decoding the second order model
   static HMMPartOfSpeechTagger *New(ModelFactory *model_factory,
                                     bool use_crf,
+                                    bool first_order,
+                                    int beam_size,
                                     Status *status);
 
+  int tag_num() const override { return model_->tag_num(); }
+  const char *tag_str(int tag_id) const override {
+    return model_->tag_str(tag_id);
+  }
+
  private:
   Beam<Node> *beams_[kMaxBeams];
   NodePool<Node> *node_pool_;
 
   const HMMModel *model_;
   const TrieTree *index_;
+  const TrieTree *user_index_;
   CRFEmitGetter *crf_emit_getter_;
 
-  HMMModel::Emit *PU_emit_;
-  HMMModel::Emit *CD_emit_;
-  HMMModel::Emit *NN_emit_;
+  HMMModel::Emit PU_emit_;
+  HMMModel::Emit CD_emit_;
+  HMMModel::Emit NN_emit_;
 
   // Possible emits for OOV words
-  HMMModel::Emit *oov_emits_;
+  static const int kOOVEmitNum = 4;
+  HMMModel::Emit oov_emits_[kOOVEmitNum];
+
+  // Emits of user words indexed by term_id minus kUserTermIdStart, the tag is
+  // -1 if the user word has no part-of-speech tag in user dictionary
+  std::vector<HMMModel::Emit> user_emits_;
 
   int BOS_tagid_;
   int NN_tagid_;
 
   TermInstance *term_instance_;
 
-  // Initialize the emit nodes in this class such as PU_emit_ or oov_emits_
+  const SimdKernel *kernel_;
+
+  // Buffers of BuildBeam and FirstOrderViterbi: the cost and transition row
+  // of each node in the previous beam (or emit in the previous position), and
+  // the tag, best cost and previous node of each emit
+  std::vector<float> context_cost_;
+  std::vector<const float *> trans_rows_;
+  std::vector<int> emit_tag_;
+  std::vector<float> emit_cost_;
+  std::vector<int> emit_context_;
+
+  // Emits of each term in term_instance_ and the positions of terms which
+  // have no emit in model
+  std::vector<HMMModel::EmitRow> emits_;
+  std::vector<int> oov_positions_;
+  std::vector<HMMModel::EmitRow> oov_position_emits_;
+
+  // Lattice of the first order decoding. The emits of position i are
+  // [lattice_offset_[i], lattice_offset_[i + 1]) in lattice_cost_ (the best
+  // cost of the path ending with the emit) and lattice_previous_ (the index
+  // of previous emit in its position of the best path)
+  std::vector<int> lattice_offset_;
+  std::vector<float> lattice_cost_;
+  std::vector<int> lattice_previous_;
+
+  // Initialize the emits in this class such as PU_emit_ or oov_emits_
   static void InitEmit(HMMPartOfSpeechTagger *self, Status *status);
 
+  // Initialize user_emits_ from the tags in user dictionary
+  static void InitUserEmit(HMMPartOfSpeechTagger *self,
+                           ModelFactory *model_factory,
+                           Status *status);
+
   HMMPartOfSpeechTagger();
 
   // Build the beam
@@ -141,7 +225,19 @@ class HMMPartOfSpeechTagger: public PartOfSpeechTagger {
   void GetBestPOSTagFromBeam(
       PartOfSpeechTagInstance *part_of_speech_tag_instance);
 
-  HMMModel::Emit *GetEmitAtPosition(int position);
+  // Get the emit row of term at position from model or the type of term.
+  // Returns an empty row if the term is an OOV word
+  HMMModel::EmitRow GetEmitAtPosition(int position);
+
+  // Get the emits of all terms in term_instance_ into emits_
+  void GetEmits();
+
+  // Tags term_instance_ with the first order model
+  void FirstOrderViterbi(PartOfSpeechTagInstance *part_of_speech_tag_instance);
+
+  // Ensure the buffers of the contexts and the emits have at least
+  // context_num and emit_num elements
+  void ReserveBuffers(int context_num, int emit_num);
 
   DISALLOW_COPY_AND_ASSIGN(HMMPartOfSpeechTagger);
 };
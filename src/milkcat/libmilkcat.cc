@@ -26,6 +26,7 @@
 //
 
 #include "milkcat/libmilkcat.h"
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <string>
@@ -33,12 +34,16 @@
 #include <vector>
 #include "milkcat/bigram_segmenter.h"
 #include "milkcat/crf_part_of_speech_tagger.h"
+#include "milkcat/crf_segmenter.h"
 #include "milkcat/crf_tagger.h"
+#include "milkcat/greedy_part_of_speech_tagger.h"
 #include "milkcat/hmm_part_of_speech_tagger.h"
+#include "milkcat/max_match_segmenter.h"
 #include "milkcat/milkcat.h"
 #include "milkcat/mixed_segmenter.h"
 #include "milkcat/out_of_vocabulary_word_recognition.h"
 #include "milkcat/part_of_speech_tag_instance.h"
+#include "milkcat/perceptron_segmenter.h"
 #include "milkcat/tokenizer.h"
 #include "milkcat/term_instance.h"
 #include "milkcat/token_instance.h"
@@ -59,22 +64,48 @@ Tokenization *TokenizerFactory(int analyzer_type) {
 }
 
 Segmenter *SegmenterFactory(ModelFactory *factory,
-                            int analyzer_type,
+                            const milkcat_config_t *config,
                             Status *status) {
-  int segmenter_type = analyzer_type & kSegmenterMask;
+  MixedSegmenter *mixed_segmenter;
+  BigramSegmenter *bigram_segmenter;
+  int segmenter_type = config->analyzer_type & kSegmenterMask;
+  int beam_size = config->segmenter_beam_size;
 
   switch (segmenter_type) {
     case SEGMENTER_BIGRAM:
-      return BigramSegmenter::New(factory, true, status);
-
     case SEGMENTER_UNIGRAM:
-      return BigramSegmenter::New(factory, false, status);
+      bigram_segmenter = BigramSegmenter::New(
+          factory,
+          segmenter_type == SEGMENTER_BIGRAM,
+          beam_size,
+          status);
+      if (bigram_segmenter && config->use_non_cjk_bypass)
+        bigram_segmenter->set_bypass_non_cjk(true);
+      return bigram_segmenter;
 
     case SEGMENTER_CRF:
       return CRFSegmenter::New(factory, status);
 
     case SEGMENTER_MIXED:
-      return MixedSegmenter::New(factory, status);
+    case SEGMENTER_MIXED_PERCEPTRON:
+      mixed_segmenter = MixedSegmenter::New(
+          factory,
+          beam_size,
+          segmenter_type == SEGMENTER_MIXED_PERCEPTRON,
+          status);
+      if (mixed_segmenter && config->use_oov_confidence_gate) {
+        mixed_segmenter->SetOOVConfidenceGate(
+            config->oov_confidence_threshold);
+      }
+      if (mixed_segmenter && config->use_non_cjk_bypass)
+        mixed_segmenter->SetBypassNonCJK(true);
+      return mixed_segmenter;
+
+    case SEGMENTER_MAXMATCH:
+      return MaxMatchSegmenter::New(factory, status);
+
+    case SEGMENTER_PERCEPTRON:
+      return PerceptronSegmenter::New(factory, status);
 
     default:
       *status = Status::NotImplemented("Invalid segmenter type");
@@ -83,10 +114,12 @@ Segmenter *SegmenterFactory(ModelFactory *factory,
 }
 
 PartOfSpeechTagger *PartOfSpeechTaggerFactory(ModelFactory *factory,
-                                              int analyzer_type,
+                                              const milkcat_config_t *config,
                                               Status *status) {
   const CRFModel *crf_pos_model;
-  int tagger_type = analyzer_type & kPartOfSpeechTaggerMask;
+  CRFPartOfSpeechTagger *crf_pos_tagger;
+  int tagger_type = config->analyzer_type & kPartOfSpeechTaggerMask;
+  int beam_size = config->part_of_speech_beam_size;
 
   LOG("Tagger type: %x\n", tagger_type);
 
@@ -100,16 +133,55 @@ PartOfSpeechTagger *PartOfSpeechTaggerFactory(ModelFactory *factory,
         return nullptr;
       }
 
+    case POSTAGGER_CRF_PRUNED:
+      if (status->ok()) crf_pos_model = factory->CRFPosModel(status);
+
+      if (status->ok()) {
+        crf_pos_tagger = new CRFPartOfSpeechTagger(crf_pos_model);
+        crf_pos_tagger->crf_tagger()->set_pruning(
+            CRFTagger::kDefaultPruneTopK,
+            CRFTagger::kDefaultPruneDelta);
+        return crf_pos_tagger;
+      } else {
+        return nullptr;
+      }
+
     case POSTAGGER_HMM:
       if (status->ok()) {
-        return HMMPartOfSpeechTagger::New(factory, false, status);
+        return HMMPartOfSpeechTagger::New(factory,
+                                          false,
+                                          false,
+                                          beam_size,
+                                          status);
       } else {
         return nullptr;
       }
 
     case POSTAGGER_MIXED:
       if (status->ok()) {
-        return HMMPartOfSpeechTagger::New(factory, true, status);
+        return HMMPartOfSpeechTagger::New(factory,
+                                          true,
+                                          false,
+                                          beam_size,
+                                          status);
+      } else {
+        return nullptr;
+      }
+
+    case POSTAGGER_BIGRAM_HMM:
+      if (status->ok()) {
+        return HMMPartOfSpeechTagger::New(factory,
+                                          false,
+                                          true,
+                                          beam_size,
+                                          status);
+      } else {
+        return nullptr;
+      }
+
+    case POSTAGGER_GREEDY:
+      if (status->ok()) {
+        return GreedyPartOfSpeechTagger::New(factory, status);
       } else {
         return nullptr;
       }
@@ -136,11 +208,21 @@ ModelFactory::ModelFactory(const char *model_dir_path):
     user_index_(nullptr),
     unigram_cost_(nullptr),
     user_cost_(nullptr),
+    user_tag_(nullptr),
     bigram_cost_(nullptr),
     seg_model_(nullptr),
+    perceptron_seg_model_(nullptr),
     crf_pos_model_(nullptr),
     hmm_pos_model_(nullptr),
-    oov_property_(nullptr) {
+    hmm_bigram_pos_model_(nullptr),
+    maxent_pos_model_(nullptr),
+    oov_property_(nullptr),
+    oov_emit_cache_(nullptr),
+    oov_emit_cache_taken_(false),
+    oov_segment_cache_(nullptr),
+    oov_segment_cache_taken_(false),
+    new_word_collector_(nullptr),
+    new_word_collector_taken_(false) {
 }
 
 ModelFactory::~ModelFactory() {
@@ -156,20 +238,135 @@ ModelFactory::~ModelFactory() {
   delete user_cost_;
   user_cost_ = nullptr;
 
+  delete user_tag_;
+  user_tag_ = nullptr;
+
   delete bigram_cost_;
   bigram_cost_ = nullptr;
 
   delete seg_model_;
   seg_model_ = nullptr;
 
+  delete perceptron_seg_model_;
+  perceptron_seg_model_ = nullptr;
+
   delete crf_pos_model_;
   crf_pos_model_ = nullptr;
 
   delete hmm_pos_model_;
   hmm_pos_model_ = nullptr;
 
+  delete hmm_bigram_pos_model_;
+  hmm_bigram_pos_model_ = nullptr;
+
+  delete maxent_pos_model_;
+  maxent_pos_model_ = nullptr;
+
   delete oov_property_;
   oov_property_ = nullptr;
+
+  delete oov_emit_cache_;
+  oov_emit_cache_ = nullptr;
+
+  delete oov_segment_cache_;
+  oov_segment_cache_ = nullptr;
+
+  delete new_word_collector_;
+  new_word_collector_ = nullptr;
+}
+
+void ModelFactory::SetOOVEmitCacheCapacity(int capacity, Status *status) {
+  mutex.lock();
+  if (oov_emit_cache_taken_) {
+    *status = Status::RuntimeError(
+        "OOV emit cache could not be changed after an analyzer is created");
+  } else {
+    delete oov_emit_cache_;
+    oov_emit_cache_ = capacity > 0? new EmitCache(capacity): nullptr;
+  }
+  mutex.unlock();
+}
+
+EmitCache *ModelFactory::OOVEmitCache() {
+  mutex.lock();
+  oov_emit_cache_taken_ = true;
+  EmitCache *cache = oov_emit_cache_;
+  mutex.unlock();
+  return cache;
+}
+
+void ModelFactory::OOVEmitCacheStatistics(int64_t *hit_num,
+                                          int64_t *miss_num) {
+  mutex.lock();
+  *hit_num = oov_emit_cache_? oov_emit_cache_->hit_num(): 0;
+  *miss_num = oov_emit_cache_? oov_emit_cache_->miss_num(): 0;
+  mutex.unlock();
+}
+
+void ModelFactory::SetOOVSegmentCache(int capacity,
+                                      int context_size,
+                                      Status *status) {
+  mutex.lock();
+  if (oov_segment_cache_taken_) {
+    *status = Status::RuntimeError(
+        "OOV segment cache could not be changed after an analyzer is created");
+  } else {
+    delete oov_segment_cache_;
+    oov_segment_cache_ = capacity > 0?
+        new SegmentCache(capacity, context_size):
+        nullptr;
+  }
+  mutex.unlock();
+}
+
+SegmentCache *ModelFactory::OOVSegmentCache() {
+  mutex.lock();
+  oov_segment_cache_taken_ = true;
+  SegmentCache *cache = oov_segment_cache_;
+  mutex.unlock();
+  return cache;
+}
+
+void ModelFactory::OOVSegmentCacheStatistics(int64_t *hit_num,
+                                             int64_t *miss_num) {
+  mutex.lock();
+  *hit_num = oov_segment_cache_? oov_segment_cache_->hit_num(): 0;
+  *miss_num = oov_segment_cache_? oov_segment_cache_->miss_num(): 0;
+  mutex.unlock();
+}
+
+void ModelFactory::SetNewWordCollectorCapacity(int capacity,
+                                               Status *status) {
+  mutex.lock();
+  if (new_word_collector_taken_) {
+    *status = Status::RuntimeError(
+        "new word collector could not be changed after an analyzer is "
+        "created");
+  } else {
+    delete new_word_collector_;
+    new_word_collector_ = capacity > 0?
+        new NewWordCollector(capacity):
+        nullptr;
+  }
+  mutex.unlock();
+}
+
+NewWordCollector *ModelFactory::new_word_collector() {
+  mutex.lock();
+  new_word_collector_taken_ = true;
+  NewWordCollector *collector = new_word_collector_;
+  mutex.unlock();
+  return collector;
+}
+
+void ModelFactory::ExportNewWords(const char *path, Status *status) {
+  mutex.lock();
+  if (new_word_collector_ == nullptr) {
+    *status = Status::RuntimeError("new word collector is not enabled");
+  } else {
+    new_word_collector_->Export(path, status);
+  }
+  mutex.unlock();
 }
 
 const TrieTree *ModelFactory::Index(Status *status) {
@@ -182,13 +379,28 @@ const TrieTree *ModelFactory::Index(Status *status) {
   return unigram_index_;
 }
 
+// Returns true if token is a finite decimal number and stores it into value.
+// Spellings such as "INF", "NAN" or "0x1" are not costs, they are tags
+static bool ParseUserCost(const char *token, float *value) {
+  if (*token == '\0') return false;
+  for (const char *p = token; *p != '\0'; ++p) {
+    if (strchr("0123456789+-.eE", *p) == nullptr) return false;
+  }
+
+  char *end;
+  *value = strtof(token, &end);
+  return end != token && *end == '\0' && std::isfinite(*value);
+}
+
 void ModelFactory::LoadUserDictionary(Status *status) {
-  char line[1024], word[1024];
+  char line[1024], word[1024], tag[1024];
   std::string errmsg;
   ReadableFile *fd;
   float default_cost = kDefaultCost, cost;
   std::vector<float> user_costs;
+  std::vector<std::string> user_tags;
   std::map<std::string, int> term_ids;
+  int line_number = 0;
 
   if (user_dictionary_path_ == "") {
     *status = Status::RuntimeError("No user dictionary.");
@@ -199,22 +411,48 @@ void ModelFactory::LoadUserDictionary(Status *status) {
                                            status);
   while (status->ok() && !fd->Eof()) {
     fd->ReadLine(line, sizeof(line), status);
+    line_number++;
     if (status->ok()) {
       char *p = strchr(line, ' ');
 
-      // Checks if the entry has a cost
+      // Each entry is "word [cost] [tag]", checks if the entry has a cost or
+      // a part-of-speech tag. The column after word is a cost only when it is
+      // a finite decimal number, otherwise it is the tag
+      cost = default_cost;
+      tag[0] = '\0';
       if (p != nullptr) {
         strlcpy(word, line, p - line + 1);
         trim(word);
         trim(p);
-        cost = static_cast<float>(atof(p));
+
+        char *tag_begin = strchr(p, ' ');
+        if (tag_begin != nullptr) *tag_begin = '\0';
+        float value;
+        if (ParseUserCost(p, &value)) {
+          cost = value;
+          p = tag_begin == nullptr? p + strlen(p): tag_begin + 1;
+        } else if (tag_begin != nullptr) {
+          *tag_begin = ' ';
+        }
+        trim(p);
+        strlcpy(tag, p, sizeof(tag));
       } else {
         strlcpy(word, line, sizeof(word));
         trim(word);
-        cost = default_cost;
       }
-      term_ids.emplace(word, kUserTermIdStart + term_ids.size());
-      user_costs.push_back(cost);
+
+      // A word should appear only once, since the term ids, costs and tags
+      // are kept in the same order
+      int term_id = kUserTermIdStart + term_ids.size();
+      if (term_ids.emplace(word, term_id).second) {
+        user_costs.push_back(cost);
+        user_tags.push_back(tag);
+      } else {
+        errmsg = std::string("Duplicated word '") + word +
+                 "' in user dictionary " + user_dictionary_path_ +
+                 " line " + std::to_string(line_number) + ".";
+        *status = Status::Corruption(errmsg.c_str());
+      }
     }
   }
 
@@ -226,11 +464,12 @@ void ModelFactory::LoadUserDictionary(Status *status) {
   }
 
 
-  // Build the index and the cost array from user dictionary
+  // Build the index, the cost array and the tag array from user dictionary
   if (status->ok()) user_index_ = DoubleArrayTrieTree::NewFromMap(term_ids);
   if (status->ok())
     user_cost_ = StaticArray<float>::NewFromArray(user_costs.data(),
                                                   user_costs.size());
+  if (status->ok()) user_tag_ = new std::vector<std::string>(user_tags);
 
   delete fd;
 }
@@ -253,6 +492,15 @@ const StaticArray<float> *ModelFactory::UserCost(Status *status) {
   return user_cost_;
 }
 
+const std::vector<std::string> *ModelFactory::UserTag(Status *status) {
+  mutex.lock();
+  if (user_tag_ == nullptr) {
+    LoadUserDictionary(status);
+  }
+  mutex.unlock();
+  return user_tag_;
+}
+
 const StaticArray<float> *ModelFactory::UnigramCost(Status *status) {
   mutex.lock();
   if (unigram_cost_ == NULL) {
@@ -285,6 +533,16 @@ const CRFModel *ModelFactory::CRFSegModel(Status *status) {
   return seg_model_;
 }
 
+const PerceptronModel *ModelFactory::PerceptronSegModel(Status *status) {
+  mutex.lock();
+  if (perceptron_seg_model_ == nullptr) {
+    std::string model_path = model_dir_path_ + PERCEPTRON_SEGMENTER_MODEL;
+    perceptron_seg_model_ = PerceptronModel::New(model_path.c_str(), status);
+  }
+  mutex.unlock();
+  return perceptron_seg_model_;
+}
+
 const CRFModel *ModelFactory::CRFPosModel(Status *status) {
   mutex.lock();
   if (crf_pos_model_ == NULL) {
@@ -305,11 +563,38 @@ const HMMModel *ModelFactory::HMMPosModel(Status *status) {
   return hmm_pos_model_;
 }
 
-const TrieTree *ModelFactory::OOVProperty(Status *status) {
+const HMMModel *ModelFactory::HMMBigramPosModel(Status *status) {
+  mutex.lock();
+  if (hmm_bigram_pos_model_ == NULL) {
+    std::string model_path = model_dir_path_ + HMM_BIGRAM_PART_OF_SPEECH_MODEL;
+    hmm_bigram_pos_model_ = HMMModel::New(model_path.c_str(), status);
+    if (status->ok() && hmm_bigram_pos_model_->order() != 1) {
+      *status = Status::Corruption(model_path.c_str());
+      delete hmm_bigram_pos_model_;
+      hmm_bigram_pos_model_ = nullptr;
+    }
+  }
+  mutex.unlock();
+  return hmm_bigram_pos_model_;
+}
+
+const MaxentModel *ModelFactory::MaxentPosModel(Status *status) {
+  mutex.lock();
+  if (maxent_pos_model_ == NULL) {
+    std::string model_path = model_dir_path_ + MAXENT_PART_OF_SPEECH_MODEL;
+    maxent_pos_model_ = MaxentModel::New(model_path.c_str(), status);
+  }
+  mutex.unlock();
+  return maxent_pos_model_;
+}
+
+const CharacterProperty *ModelFactory::OOVProperty(Status *status) {
   mutex.lock();
   if (oov_property_ == NULL) {
     std::string model_path = model_dir_path_ + OOV_PROPERTY;
-    oov_property_ = DoubleArrayTrieTree::New(model_path.c_str(), status);
+    const TrieTree *index = DoubleArrayTrieTree::New(model_path.c_str(),
+                                                     status);
+    if (status->ok()) oov_property_ = CharacterProperty::New(index);
   }
   mutex.unlock();
   return oov_property_;
@@ -386,23 +671,79 @@ milkcat_model_t *milkcat_model_new(const char *model_path) {
   return model;
 }
 
+namespace {
+
+// Threshold of the OOV confidence gate in MC_PROFILE_FAST, the spans whose
+// best alternative is e^2 times less likely than the best path are skipped.
+// It is tuned with the bigram segmenter beam size of 2 or more, a beam of 1
+// keeps only the greedy path, so the margin is taken against a different
+// best path and the same threshold skips other spans
+constexpr double kFastProfileOOVThreshold = 2.0;
+
+// Bigram segmenter beam size of MC_PROFILE_FAST, the smallest beam that the
+// threshold above is tuned with
+constexpr int kFastProfileSegmenterBeamSize = 2;
+
+}  // namespace
+
+void milkcat_config_init(milkcat_config_t *config, int profile) {
+  config->analyzer_type = DEFAULT_ANALYZER;
+  config->segmenter_beam_size = milkcat::BigramSegmenter::kDefaultBeamSize;
+  config->part_of_speech_beam_size =
+      milkcat::HMMPartOfSpeechTagger::kDefaultBeamSize;
+  config->use_oov_confidence_gate = 0;
+  config->oov_confidence_threshold = 0.0;
+  config->use_non_cjk_bypass = 0;
+
+  switch (profile) {
+    case MC_PROFILE_FAST:
+      config->analyzer_type = TOKENIZER_NORMAL |
+                              SEGMENTER_MIXED |
+                              POSTAGGER_HMM;
+      config->segmenter_beam_size = kFastProfileSegmenterBeamSize;
+      config->part_of_speech_beam_size = 1;
+      config->use_oov_confidence_gate = 1;
+      config->oov_confidence_threshold = kFastProfileOOVThreshold;
+      break;
+
+    case MC_PROFILE_PRECISE:
+      config->segmenter_beam_size = 8;
+      config->part_of_speech_beam_size = 8;
+      break;
+  }
+}
+
 milkcat_t *milkcat_new(milkcat_model_t *model, int analyzer_type) {
+  milkcat_config_t config;
+  milkcat_config_init(&config, MC_PROFILE_DEFAULT);
+  config.analyzer_type = analyzer_type;
+
+  return milkcat_new_with_config(model, &config);
+}
+
+milkcat_t *milkcat_new_with_config(milkcat_model_t *model,
+                                   const milkcat_config_t *config) {
   milkcat::global_status = milkcat::Status::OK();
 
   milkcat_t *analyzer = new milkcat_t;
   memset(analyzer, 0, sizeof(milkcat_t));
 
   analyzer->model = model;
+  analyzer->analyzer_type = config->analyzer_type;
+
+  if (config->segmenter_beam_size < 1 || config->part_of_speech_beam_size < 1)
+    milkcat::global_status = milkcat::Status::RuntimeError(
+        "beam size should be greater than 0");
 
   if (milkcat::global_status.ok())
     analyzer->segmenter = milkcat::SegmenterFactory(
         analyzer->model->model_factory,
-        analyzer_type,
+        config,
         &milkcat::global_status);
   if (milkcat::global_status.ok())
     analyzer->part_of_speech_tagger = milkcat::PartOfSpeechTaggerFactory(
         analyzer->model->model_factory,
-        analyzer_type,
+        config,
         &milkcat::global_status);
 
   if (!milkcat::global_status.ok()) {
@@ -440,6 +781,49 @@ void milkcat_model_set_userdict(milkcat_model_t *model, const char *path) {
   model->model_factory->SetUserDictionary(path);
 }
 
+int milkcat_model_set_oov_emit_cache(milkcat_model_t *model, int capacity) {
+  milkcat::global_status = milkcat::Status::OK();
+  model->model_factory->SetOOVEmitCacheCapacity(capacity,
+                                                &milkcat::global_status);
+  return milkcat::global_status.ok()? MC_OK: MC_NONE;
+}
+
+void milkcat_model_oov_emit_cache_statistics(milkcat_model_t *model,
+                                             int64_t *hit_num,
+                                             int64_t *miss_num) {
+  model->model_factory->OOVEmitCacheStatistics(hit_num, miss_num);
+}
+
+int milkcat_model_set_oov_segment_cache(milkcat_model_t *model,
+                                        int capacity,
+                                        int context_size) {
+  milkcat::global_status = milkcat::Status::OK();
+  model->model_factory->SetOOVSegmentCache(capacity,
+                                           context_size,
+                                           &milkcat::global_status);
+  return milkcat::global_status.ok()? MC_OK: MC_NONE;
+}
+
+void milkcat_model_oov_segment_cache_statistics(milkcat_model_t *model,
+                                                int64_t *hit_num,
+                                                int64_t *miss_num) {
+  model->model_factory->OOVSegmentCacheStatistics(hit_num, miss_num);
+}
+
+int milkcat_model_set_new_word_collector(milkcat_model_t *model,
+                                         int capacity) {
+  milkcat::global_status = milkcat::Status::OK();
+  model->model_factory->SetNewWordCollectorCapacity(capacity,
+                                                    &milkcat::global_status);
+  return milkcat::global_status.ok()? MC_OK: MC_NONE;
+}
+
+int milkcat_model_export_new_words(milkcat_model_t *model, const char *path) {
+  milkcat::global_status = milkcat::Status::OK();
+  model->model_factory->ExportNewWords(path, &milkcat::global_status);
+  return milkcat::global_status.ok()? MC_OK: MC_NONE;
+}
+
 void milkcat_analyze(milkcat_t *analyzer, 
                      milkcat_cursor_t *cursor,
                      const char *text) {
@@ -469,6 +853,22 @@ int milkcat_cursor_get_next(milkcat_cursor_t *cursor,
   return MC_OK;
 }
 
+int milkcat_cursor_term_id(milkcat_cursor_t *cursor) {
+  milkcat::Cursor *internal_cursor = cursor->internal_cursor;
+  if (internal_cursor->analyzer() == nullptr || !internal_cursor->has_word())
+    return -1;
+
+  return internal_cursor->term_id();
+}
+
+int milkcat_cursor_tag_id(milkcat_cursor_t *cursor) {
+  milkcat::Cursor *internal_cursor = cursor->internal_cursor;
+  if (internal_cursor->analyzer() == nullptr || !internal_cursor->has_word())
+    return -1;
+
+  return internal_cursor->tag_id();
+}
+
 milkcat_cursor_t *milkcat_cursor_new() {
   milkcat_cursor_t *cursor = new milkcat_cursor_t;
   cursor->internal_cursor = new milkcat::Cursor();
@@ -484,6 +884,82 @@ void milkcat_cursor_destroy(milkcat_cursor_t *cursor) {
   delete cursor;
 }
 
+namespace {
+
+// Get the MixedSegmenter of analyzer, if analyzer doesn't use SEGMENTER_MIXED
+// or SEGMENTER_MIXED_PERCEPTRON returns nullptr and sets the global_status
+milkcat::MixedSegmenter *GetMixedSegmenter(milkcat_t *analyzer) {
+  int segmenter_type = analyzer->analyzer_type & milkcat::kSegmenterMask;
+  if (segmenter_type != SEGMENTER_MIXED &&
+      segmenter_type != SEGMENTER_MIXED_PERCEPTRON) {
+    milkcat::global_status = milkcat::Status::NotImplemented(
+        "OOV confidence gate only works with SEGMENTER_MIXED");
+    return nullptr;
+  }
+
+  return static_cast<milkcat::MixedSegmenter *>(analyzer->segmenter);
+}
+
+// Get the CRFTagger of analyzer, if analyzer doesn't use POSTAGGER_CRF or
+// POSTAGGER_CRF_PRUNED returns nullptr and sets the global_status
+milkcat::CRFTagger *GetCRFTagger(milkcat_t *analyzer) {
+  int tagger_type = analyzer->analyzer_type &
+                    milkcat::kPartOfSpeechTaggerMask;
+  if (tagger_type != POSTAGGER_CRF && tagger_type != POSTAGGER_CRF_PRUNED) {
+    milkcat::global_status = milkcat::Status::NotImplemented(
+        "CRF score cache only works with POSTAGGER_CRF");
+    return nullptr;
+  }
+
+  milkcat::CRFPartOfSpeechTagger *tagger =
+      static_cast<milkcat::CRFPartOfSpeechTagger *>(
+          analyzer->part_of_speech_tagger);
+  return tagger->crf_tagger();
+}
+
+}  // namespace
+
+void milkcat_set_oov_confidence_gate(milkcat_t *analyzer, double threshold) {
+  milkcat::MixedSegmenter *segmenter = GetMixedSegmenter(analyzer);
+  if (segmenter) segmenter->SetOOVConfidenceGate(threshold);
+}
+
+void milkcat_clear_oov_confidence_gate(milkcat_t *analyzer) {
+  milkcat::MixedSegmenter *segmenter = GetMixedSegmenter(analyzer);
+  if (segmenter) segmenter->ClearOOVConfidenceGate();
+}
+
+void milkcat_oov_gate_statistics(milkcat_t *analyzer,
+                                 int64_t *span_num,
+                                 int64_t *skipped_span_num) {
+  milkcat::MixedSegmenter *segmenter = GetMixedSegmenter(analyzer);
+  *span_num = segmenter? segmenter->oov_span_num(): 0;
+  *skipped_span_num = segmenter? segmenter->oov_skipped_span_num(): 0;
+}
+
+void milkcat_set_crf_score_cache(milkcat_t *analyzer, int capacity) {
+  milkcat::CRFTagger *crf_tagger = GetCRFTagger(analyzer);
+  if (crf_tagger) crf_tagger->set_score_cache_capacity(capacity);
+}
+
+void milkcat_crf_score_cache_statistics(milkcat_t *analyzer,
+                                        int64_t *hit_num,
+                                        int64_t *miss_num) {
+  milkcat::CRFTagger *crf_tagger = GetCRFTagger(analyzer);
+  *hit_num = crf_tagger? crf_tagger->score_cache_hit_num(): 0;
+  *miss_num = crf_tagger? crf_tagger->score_cache_miss_num(): 0;
+}
+
+int milkcat_tag_num(milkcat_t *analyzer) {
+  milkcat::PartOfSpeechTagger *tagger = analyzer->part_of_speech_tagger;
+  return tagger? tagger->tag_num(): 0;
+}
+
+const char *milkcat_tag_str(milkcat_t *analyzer, int tag_id) {
+  if (tag_id < 0 || tag_id >= milkcat_tag_num(analyzer)) return nullptr;
+  return analyzer->part_of_speech_tagger->tag_str(tag_id);
+}
+
 const char *milkcat_last_error() {
   return milkcat::global_status.what();
 }
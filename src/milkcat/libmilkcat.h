@@ -40,13 +40,19 @@
 #include "utils/readable_file.h"
 #include "milkcat/hmm_model.h"
 #include "milkcat/crf_model.h"
+#include "milkcat/character_property.h"
+#include "milkcat/emit_cache.h"
 #include "milkcat/trie_tree.h"
+#include "milkcat/new_word_collector.h"
+#include "milkcat/perceptron_model.h"
+#include "milkcat/segment_cache.h"
 #include "milkcat/static_array.h"
 #include "milkcat/static_hashtable.h"
 #include "milkcat/milkcat.h"
 #include "milkcat/segmenter.h"
 #include "milkcat/part_of_speech_tagger.h"
 #include "milkcat/tokenizer.h"
+#include "neko/maxent_classifier.h"
 #include "milkcat/milkcat_config.h"
 #include "milkcat/term_instance.h"
 #include "milkcat/part_of_speech_tag_instance.h"
@@ -68,6 +74,7 @@ struct milkcat_cursor_t {
 
 struct milkcat_t {
   milkcat_model_t *model;
+  int analyzer_type;
   milkcat::Segmenter *segmenter;
   milkcat::PartOfSpeechTagger *part_of_speech_tagger;
 };
@@ -79,8 +86,11 @@ constexpr const char *UNIGRAM_INDEX = "unigram.idx";
 constexpr const char *UNIGRAM_DATA = "unigram.bin";
 constexpr const char *BIGRAM_DATA = "bigram.bin";
 constexpr const char *HMM_PART_OF_SPEECH_MODEL = "ctb_pos.hmm";
+constexpr const char *HMM_BIGRAM_PART_OF_SPEECH_MODEL = "ctb_pos_bigram.hmm";
 constexpr const char *CRF_PART_OF_SPEECH_MODEL = "ctb_pos.crf";
+constexpr const char *MAXENT_PART_OF_SPEECH_MODEL = "ctb_pos.maxent";
 constexpr const char *CRF_SEGMENTER_MODEL = "ctb_seg.crf";
+constexpr const char *PERCEPTRON_SEGMENTER_MODEL = "ctb_seg.perceptron";
 constexpr const char *DEFAULT_TAG = "default_tag.cfg";
 constexpr const char *OOV_PROPERTY = "oov_property.idx";
 
@@ -106,23 +116,76 @@ class ModelFactory {
 
   bool HasUserDictionary() const { return user_dictionary_path_.size() != 0; }
 
+  // Set the capacity of the cache of out-of-vocabulary emits used by HMM
+  // part-of-speech taggers, 0 to disable it. The cache could not be changed
+  // after it is taken by a tagger, on this case status != Status::OK()
+  void SetOOVEmitCacheCapacity(int capacity, Status *status);
+
+  // Get the cache of out-of-vocabulary emits for a tagger, returns nullptr if
+  // disabled. After that the cache is kept until the factory is destroyed
+  EmitCache *OOVEmitCache();
+
+  // Get the number of hits and misses of the cache of out-of-vocabulary
+  // emits, both of them are 0 if it is disabled
+  void OOVEmitCacheStatistics(int64_t *hit_num, int64_t *miss_num);
+
+  // Set the capacity and the context size of the cache of out-of-vocabulary
+  // spans segmented by CRF segmenter in SEGMENTER_MIXED, capacity 0 to
+  // disable it. The cache could not be changed after it is taken by a
+  // segmenter, on this case status != Status::OK()
+  void SetOOVSegmentCache(int capacity, int context_size, Status *status);
+
+  // Get the cache of out-of-vocabulary spans for a segmenter, returns nullptr
+  // if disabled. After that the cache is kept until the factory is destroyed
+  SegmentCache *OOVSegmentCache();
+
+  // Get the number of hits and misses of the cache of out-of-vocabulary
+  // spans, both of them are 0 if it is disabled
+  void OOVSegmentCacheStatistics(int64_t *hit_num, int64_t *miss_num);
+
+  // Set the capacity of the collector of new words recognized in
+  // SEGMENTER_MIXED, 0 to disable it. The collector could not be changed
+  // after it is taken by a segmenter, on this case status != Status::OK()
+  void SetNewWordCollectorCapacity(int capacity, Status *status);
+
+  // Get the collector of new words for a segmenter, returns nullptr if
+  // disabled. After that the collector is kept until the factory is destroyed
+  NewWordCollector *new_word_collector();
+
+  // Export the new words collected into path, on failed or the collector is
+  // disabled, status != Status::OK()
+  void ExportNewWords(const char *path, Status *status);
+
   const TrieTree *UserIndex(Status *status);
   const StaticArray<float> *UserCost(Status *status);
 
+  // Get the part-of-speech tags of user words indexed by term_id minus
+  // kUserTermIdStart, the tag is empty if it is not given in user dictionary
+  const std::vector<std::string> *UserTag(Status *status);
+
   const StaticArray<float> *UnigramCost(Status *status);
   const StaticHashTable<int64_t, float> *BigramCost(Status *status);
 
   // Get the CRF word segmenter model
   const CRFModel *CRFSegModel(Status *status);
 
+  // Get the averaged perceptron word segmenter model
+  const PerceptronModel *PerceptronSegModel(Status *status);
+
   // Get the CRF word part-of-speech model
   const CRFModel *CRFPosModel(Status *status);
 
   // Get the HMM word part-of-speech model
   const HMMModel *HMMPosModel(Status *status);
 
+  // Get the first order HMM word part-of-speech model
+  const HMMModel *HMMBigramPosModel(Status *status);
+
+  // Get the maximum entropy part-of-speech model of the greedy tagger
+  const MaxentModel *MaxentPosModel(Status *status);
+
   // Get the character's property in out-of-vocabulary word recognition
-  const TrieTree *OOVProperty(Status *status);
+  const CharacterProperty *OOVProperty(Status *status);
 
  private:
   std::string model_dir_path_;
@@ -133,11 +196,21 @@ class ModelFactory {
   const TrieTree *user_index_;
   const StaticArray<float> *unigram_cost_;
   const StaticArray<float> *user_cost_;
+  const std::vector<std::string> *user_tag_;
   const StaticHashTable<int64_t, float> *bigram_cost_;
   const CRFModel *seg_model_;
+  const PerceptronModel *perceptron_seg_model_;
   const CRFModel *crf_pos_model_;
   const HMMModel *hmm_pos_model_;
-  const TrieTree *oov_property_;
+  const HMMModel *hmm_bigram_pos_model_;
+  const MaxentModel *maxent_pos_model_;
+  const CharacterProperty *oov_property_;
+  EmitCache *oov_emit_cache_;
+  bool oov_emit_cache_taken_;
+  SegmentCache *oov_segment_cache_;
+  bool oov_segment_cache_taken_;
+  NewWordCollector *new_word_collector_;
+  bool new_word_collector_taken_;
 
   // Load and set the user dictionary data specified by path
   void LoadUserDictionary(Status *status);
@@ -146,16 +219,17 @@ class ModelFactory {
 // A factory function to create tokenizers
 Tokenization *TokenizerFactory(int tokenizer_id);
 
-// A factory function to create segmenters. On success, return the instance of
+// A factory function to create segmenters from the analyzer type and the
+// beam size and OOV gate in config. On success, return the instance of
 // Segmenter, on failed, set status != Status::OK()
 Segmenter *SegmenterFactory(ModelFactory *factory,
-                           int segmenter_id,
-                           Status *status);
+                            const milkcat_config_t *config,
+                            Status *status);
 
 // A factory function to create part-of-speech taggers. On success, return the
 // instance of part-of-speech tagger, on failed, set status != Status::OK()
 PartOfSpeechTagger *PartOfSpeechTaggerFactory(ModelFactory *factory,
-                                              int part_of_speech_tagger_id,
+                                              const milkcat_config_t *config,
                                               Status *status);
 
 
@@ -189,10 +263,26 @@ class Cursor {
   const int word_type() const {
     return term_instance_->term_type_at(current_position_);
   }
+  int term_id() const {
+    int term_id = term_instance_->term_id_at(current_position_);
+    return term_id >= 0? term_id: TermInstance::kTermIdOutOfVocabulary;
+  }
+  int tag_id() const {
+    if (analyzer_->part_of_speech_tagger != NULL)
+      return part_of_speech_tag_instance_->tag_id_at(current_position_);
+    else
+      return -1;
+  }
 
   // If reaches the end of text
   bool end() const { return end_; }
 
+  // If the cursor is at a word, that is MoveToNext() is called after Scan()
+  // and the end of text is not reached
+  bool has_word() const {
+    return !end_ && current_position_ < sentence_length_;
+  }
+
   milkcat_t *analyzer() const { return analyzer_; }
   void set_analyzer(milkcat_t *analyzer) {
     analyzer_ = analyzer;
@@ -0,0 +1,201 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// max_match_segmenter.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/max_match_segmenter.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "milkcat/bigram_segmenter.h"
+#include "milkcat/libmilkcat.h"
+#include "milkcat/term_instance.h"
+#include "milkcat/token_instance.h"
+#include "milkcat/trie_tree.h"
+
+namespace milkcat {
+
+MaxMatchSegmenter::MaxMatchSegmenter(): index_(nullptr),
+                                        user_index_(nullptr),
+                                        unigram_cost_(nullptr),
+                                        user_cost_(nullptr) {
+}
+
+MaxMatchSegmenter *MaxMatchSegmenter::New(ModelFactory *model_factory,
+                                          Status *status) {
+  MaxMatchSegmenter *self = new MaxMatchSegmenter();
+
+  self->index_ = model_factory->Index(status);
+  if (status->ok() && model_factory->HasUserDictionary()) {
+    self->user_index_ = model_factory->UserIndex(status);
+    if (status->ok()) self->user_cost_ = model_factory->UserCost(status);
+  }
+  if (status->ok()) self->unigram_cost_ = model_factory->UnigramCost(status);
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+void MaxMatchSegmenter::MatchTerms(TokenInstance *token_instance) {
+  int token_num = token_instance->size();
+  forward_end_.assign(token_num + 1, -1);
+  forward_term_id_.resize(token_num + 1);
+  backward_begin_.assign(token_num + 1, -1);
+  backward_term_id_.resize(token_num + 1);
+
+  for (int begin = 0; begin < token_num; ++begin) {
+    size_t system_node = 0, user_node = 0;
+    bool system_flag = true, user_flag = user_index_ != nullptr;
+    for (int end = begin + 1; end <= token_num; ++end) {
+      const char *token_str = token_instance->token_text_at(end - 1);
+      int term_id = TrieTree::kNone;
+      if (system_flag) {
+        term_id = index_->Traverse(token_str, &system_node);
+        if (term_id == TrieTree::kNone) system_flag = false;
+      }
+      if (user_flag) {
+        int user_term_id = user_index_->Traverse(token_str, &user_node);
+        if (user_term_id == TrieTree::kNone) user_flag = false;
+
+        // Use term id in user dictionary iff term-id in system dictionary
+        // not exist, the same as BigramSegmenter
+        if (term_id < 0) term_id = user_term_id;
+      }
+
+      if (term_id >= 0) {
+        forward_end_[begin] = end;
+        forward_term_id_[begin] = term_id;
+
+        // begin is ascending, so the first one is the longest
+        if (backward_begin_[end] < 0) {
+          backward_begin_[end] = begin;
+          backward_term_id_[end] = term_id;
+        }
+      }
+
+      if (system_flag == false && user_flag == false) break;
+    }
+  }
+}
+
+int MaxMatchSegmenter::TermIdAt(int begin, int end) const {
+  if (forward_end_[begin] == end) {
+    return forward_term_id_[begin];
+  } else if (backward_begin_[end] == begin) {
+    return backward_term_id_[end];
+  } else {
+    return TrieTree::kNone;
+  }
+}
+
+double MaxMatchSegmenter::TermCost(int term_id) const {
+  if (term_id < 0) {
+    return BigramSegmenter::kOOVCost;
+  } else if (term_id >= kUserTermIdStart) {
+    return user_cost_->get(term_id - kUserTermIdStart);
+  } else {
+    return unigram_cost_->get(term_id);
+  }
+}
+
+bool MaxMatchSegmenter::IsBetter(const std::vector<int> &bounds,
+                                 const std::vector<int> &other_bounds) const {
+  if (bounds.size() != other_bounds.size()) {
+    return bounds.size() < other_bounds.size();
+  }
+
+  int term_num = bounds.size() - 1;
+  int single_num = 0, other_single_num = 0;
+  for (int i = 0; i < term_num; ++i) {
+    if (bounds[i + 1] - bounds[i] == 1) single_num++;
+    if (other_bounds[i + 1] - other_bounds[i] == 1) other_single_num++;
+  }
+  if (single_num != other_single_num) return single_num < other_single_num;
+
+  // The tie-break on unigram costs
+  double cost = 0, other_cost = 0;
+  for (int i = 0; i < term_num; ++i) {
+    cost += TermCost(TermIdAt(bounds[i], bounds[i + 1]));
+    other_cost += TermCost(TermIdAt(other_bounds[i], other_bounds[i + 1]));
+  }
+  return cost < other_cost;
+}
+
+void MaxMatchSegmenter::Segment(TermInstance *term_instance,
+                                TokenInstance *token_instance) {
+  int token_num = token_instance->size();
+  MatchTerms(token_instance);
+
+  // Forward maximum matching
+  forward_bounds_.clear();
+  for (int i = 0; i < token_num; ) {
+    forward_bounds_.push_back(i);
+    i = forward_end_[i] > 0? forward_end_[i]: i + 1;
+  }
+  forward_bounds_.push_back(token_num);
+
+  // Backward maximum matching
+  backward_bounds_.clear();
+  for (int i = token_num; i > 0; ) {
+    backward_bounds_.push_back(i);
+    i = backward_begin_[i] >= 0? backward_begin_[i]: i - 1;
+  }
+  backward_bounds_.push_back(0);
+  std::reverse(backward_bounds_.begin(), backward_bounds_.end());
+
+  // Prefers the backward result on tie, it is usually better for Chinese
+  const std::vector<int> &bounds = IsBetter(forward_bounds_,
+                                            backward_bounds_)?
+                                   forward_bounds_:
+                                   backward_bounds_;
+
+  std::string buffer;
+  int term_num = bounds.size() - 1;
+  for (int i = 0; i < term_num; ++i) {
+    int begin = bounds[i], end = bounds[i + 1];
+    buffer.clear();
+    for (int j = begin; j < end; ++j) {
+      buffer.append(token_instance->token_text_at(j));
+    }
+
+    int term_id = TermIdAt(begin, end);
+    int term_type = end - begin > 1?
+        TermInstance::kChineseWord:
+        TokenTypeToTermType(token_instance->token_type_at(begin));
+    term_instance->set_value_at(i,
+                                buffer.c_str(),
+                                end - begin,
+                                term_type,
+                                term_id >= 0?
+                                    term_id:
+                                    TermInstance::kTermIdOutOfVocabulary);
+  }
+  term_instance->set_size(term_num);
+}
+
+}  // namespace milkcat
@@ -0,0 +1,102 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// max_match_segmenter.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_MAX_MATCH_SEGMENTER_H_
+#define SRC_MILKCAT_MAX_MATCH_SEGMENTER_H_
+
+#include <vector>
+#include "milkcat/segmenter.h"
+#include "milkcat/static_array.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+class TrieTree;
+class TokenInstance;
+class TermInstance;
+class ModelFactory;
+
+// MaxMatchSegmenter segments by the bidirectional maximum matching over the
+// system and user dictionary. It finds the longest term from each position
+// (forward) and the longest term ending at each position (backward) in one
+// traversal of the index from each position. The result with less terms, and
+// then less single token terms, is used. Only on the tie of both the unigram
+// costs of terms are compared. It is much faster than BigramSegmenter but
+// less accurate, the tokens not in dictionary are always single terms
+class MaxMatchSegmenter: public Segmenter {
+ public:
+  // Create the segmenter from a model factory. On failed, return nullptr and
+  // set status a failed value
+  static MaxMatchSegmenter *New(ModelFactory *model_factory, Status *status);
+
+  // Segment a token instance into term instance
+  void Segment(TermInstance *term_instance,
+               TokenInstance *token_instance) override;
+
+ private:
+  const TrieTree *index_;
+  const TrieTree *user_index_;
+  const StaticArray<float> *unigram_cost_;
+  const StaticArray<float> *user_cost_;
+
+  // The longest term from position i is [i, forward_end_[i]) with term-id
+  // forward_term_id_[i], and the longest term ending at position i is
+  // [backward_begin_[i], i) with term-id backward_term_id_[i]. The ends are
+  // -1 if there is no term
+  std::vector<int> forward_end_;
+  std::vector<int> forward_term_id_;
+  std::vector<int> backward_begin_;
+  std::vector<int> backward_term_id_;
+
+  // The terms of forward and backward result, as the begin positions
+  // with the end of sentence at last
+  std::vector<int> forward_bounds_;
+  std::vector<int> backward_bounds_;
+
+  MaxMatchSegmenter();
+
+  // Finds the terms from each position of token_instance
+  void MatchTerms(TokenInstance *token_instance);
+
+  // Returns true if the result of bounds is better than the one of
+  // other_bounds, see the comment of class
+  bool IsBetter(const std::vector<int> &bounds,
+                const std::vector<int> &other_bounds) const;
+
+  // The term-id of term [begin, end) in forward or backward result, returns
+  // a negative value if it is a single token not in dictionary
+  int TermIdAt(int begin, int end) const;
+
+  // The unigram cost of term-id, kOOVCost of BigramSegmenter for the
+  // negative one
+  double TermCost(int term_id) const;
+
+  DISALLOW_COPY_AND_ASSIGN(MaxMatchSegmenter);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_MAX_MATCH_SEGMENTER_H_
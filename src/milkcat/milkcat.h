@@ -30,6 +30,7 @@
 #define SRC_MILKCAT_MILKCAT_H_
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef _WIN32
 #ifdef MILKCAT_EXPORTS
@@ -57,9 +58,35 @@ enum {
   SEGMENTER_BIGRAM = 0x00000030,
   SEGMENTER_MIXED = 0x00000040,
 
+  // Bidirectional maximum matching over the dictionary, no beams and no OOV
+  // recognition, much faster than SEGMENTER_BIGRAM but less accurate
+  SEGMENTER_MAXMATCH = 0x00000060,
+
+  // Character tagging by averaged perceptron (model file ctb_seg.perceptron,
+  // trained by mctools perceptron-train), faster than SEGMENTER_CRF but
+  // less accurate
+  SEGMENTER_PERCEPTRON = 0x00000070,
+
+  // SEGMENTER_MIXED with the OOV words recognized by the averaged perceptron
+  // segmenter instead of the CRF one
+  SEGMENTER_MIXED_PERCEPTRON = 0x00000080,
+
   POSTAGGER_HMM = 0x00001000,
   POSTAGGER_CRF = 0x00002000,
-  POSTAGGER_MIXED = 0x00003000
+  POSTAGGER_MIXED = 0x00003000,
+
+  // CRF tagger with the tags pruned by unigram cost before the transition
+  // step, faster than POSTAGGER_CRF but may lose some accuracy
+  POSTAGGER_CRF_PRUNED = 0x00004000,
+
+  // HMM tagger with tag bigram transitions (model file ctb_pos_bigram.hmm),
+  // faster than POSTAGGER_HMM but may lose some accuracy
+  POSTAGGER_BIGRAM_HMM = 0x00005000,
+
+  // Greedy left-to-right tagger with one maximum entropy classification per
+  // word (model file ctb_pos.maxent), much faster than POSTAGGER_HMM and
+  // POSTAGGER_CRF but less accurate
+  POSTAGGER_GREEDY = 0x00006000
 };
 
 enum {
@@ -70,7 +97,11 @@ enum {
   CRF_ANALYZER = TOKENIZER_NORMAL | SEGMENTER_CRF | POSTAGGER_CRF,
 
   BIGRAM_SEGMENTER = TOKENIZER_NORMAL | SEGMENTER_BIGRAM,
-  UNIGRAM_SEGMENTER = TOKENIZER_NORMAL | SEGMENTER_BIGRAM
+  UNIGRAM_SEGMENTER = TOKENIZER_NORMAL | SEGMENTER_BIGRAM,
+
+  MAXMATCH_SEGMENTER = TOKENIZER_NORMAL | SEGMENTER_MAXMATCH,
+
+  PERCEPTRON_SEGMENTER = TOKENIZER_NORMAL | SEGMENTER_PERCEPTRON
 };
 
 // Word types
@@ -91,9 +122,56 @@ typedef struct {
   int word_type;
 } milkcat_item_t;
 
+// Speed/accuracy profiles of milkcat_config_init
+#define MC_PROFILE_DEFAULT 0
+#define MC_PROFILE_FAST 1
+#define MC_PROFILE_PRECISE 2
+
+// Configuration of an analyzer, it should be initialized by
+// milkcat_config_init before changing the fields
+typedef struct {
+  // Type of the analyzer, such as DEFAULT_ANALYZER. The POSTAGGER_* part
+  // chooses the part-of-speech tagging mode
+  int analyzer_type;
+
+  // Number of nodes kept in each position by the bigram segmenter (also the
+  // one in SEGMENTER_MIXED) and the second order HMM part-of-speech tagger.
+  // Larger beams are more accurate but slower
+  int segmenter_beam_size;
+  int part_of_speech_beam_size;
+
+  // If not zero, enable the OOV confidence gate of SEGMENTER_MIXED with
+  // oov_confidence_threshold, see milkcat_set_oov_confidence_gate
+  int use_oov_confidence_gate;
+  double oov_confidence_threshold;
+
+  // If not zero, the bigram segmenter (also the one in SEGMENTER_MIXED)
+  // stores the tokens other than Chinese characters whose neighbors are not
+  // Chinese characters either as words without decoding, which is faster on
+  // the text with long spans of English. But the words in user dictionary
+  // made of several such tokens, like "C++" or "U.S.", are no longer matched.
+  // It is 0 in all profiles
+  int use_non_cjk_bypass;
+} milkcat_config_t;
+
+// Initialize config with one of the MC_PROFILE_* profiles:
+//   MC_PROFILE_DEFAULT: DEFAULT_ANALYZER with beam size 3, the same as
+//                       milkcat_new(model, DEFAULT_ANALYZER)
+//   MC_PROFILE_FAST: segmenter beam size 2 with the OOV confidence gate
+//                    enabled, part-of-speech beam size 1 and HMM tagger
+//                    without CRF emits, for bulk jobs
+//   MC_PROFILE_PRECISE: DEFAULT_ANALYZER with beam size 8, for the jobs
+//                       where accuracy matters more than speed
+EXPORT_API void milkcat_config_init(milkcat_config_t *config, int profile);
+
 
 EXPORT_API milkcat_t *milkcat_new(milkcat_model_t *model, int analyzer_type);
 
+// Create the analyzer from config. On failed, return NULL and the error
+// message could be get by milkcat_last_error
+EXPORT_API milkcat_t *milkcat_new_with_config(milkcat_model_t *model,
+                                              const milkcat_config_t *config);
+
 // Delete the MilkCat Process Instance and release its resources
 EXPORT_API void milkcat_destroy(milkcat_t *m);
 
@@ -111,6 +189,18 @@ EXPORT_API void milkcat_cursor_destroy(milkcat_cursor_t *cursor);
 EXPORT_API int milkcat_cursor_get_next(milkcat_cursor_t *c,
                                        milkcat_item_t *next_item);
 
+// Get the id in the dictionary of the word last got by milkcat_cursor_get_next,
+// the words in user dictionary start from 0x40000000. Returns -1 if the word
+// is not in the dictionary, the segmenter doesn't use the dictionary
+// (SEGMENTER_CRF) or no word is got from the cursor
+EXPORT_API int milkcat_cursor_term_id(milkcat_cursor_t *c);
+
+// Get the id of the part-of-speech tag of the word last got by
+// milkcat_cursor_get_next in the tag set of analyzer, see milkcat_tag_num and
+// milkcat_tag_str. Returns -1 if the analyzer has no tagger or no word is got
+// from the cursor
+EXPORT_API int milkcat_cursor_tag_id(milkcat_cursor_t *c);
+
 EXPORT_API milkcat_model_t *milkcat_model_new(const char *model_path);
 
 EXPORT_API void milkcat_model_destroy(milkcat_model_t *model);
@@ -118,6 +208,104 @@ EXPORT_API void milkcat_model_destroy(milkcat_model_t *model);
 EXPORT_API void milkcat_model_set_userdict(milkcat_model_t *model,
                                            const char *path);
 
+// Cache the emits of out-of-vocabulary words computed by the CRF model in HMM
+// part-of-speech taggers created from model, so that the repeated words with
+// the same context are not computed again. The cache holds about capacity
+// entries and is shared by the analyzers of model, set capacity to 0 to
+// disable it. It should be called before any analyzer with a HMM part-of-
+// speech tagger is created from model, after that the cache is kept as it is
+// until model is destroyed. Returns MC_OK on success, otherwise returns
+// MC_NONE and the error could be got by milkcat_last_error
+EXPORT_API int milkcat_model_set_oov_emit_cache(milkcat_model_t *model,
+                                                int capacity);
+
+// Get the number of hits and misses of the cache set by
+// milkcat_model_set_oov_emit_cache, both of them are 0 if it is disabled
+EXPORT_API void milkcat_model_oov_emit_cache_statistics(
+    milkcat_model_t *model,
+    int64_t *hit_num,
+    int64_t *miss_num);
+
+// Cache the terms of out-of-vocabulary spans segmented by the CRF segmenter
+// in SEGMENTER_MIXED, so that the repeated spans with the same context, such
+// as person names in a document, are not segmented again. The key of a span
+// is its tokens and context_size tokens on each side of it. If context_size
+// is -1, it is the context size of CRF segmenter model and the result is
+// exactly the same as without cache, a smaller one gives more hits while the
+// result may differ slightly. The cache holds about capacity entries and is
+// shared by the analyzers of model, set capacity to 0 to disable it. It should
+// be called before any analyzer with SEGMENTER_MIXED is created from model,
+// after that the cache is kept as it is until model is destroyed. Returns
+// MC_OK on success, otherwise returns MC_NONE and the error could be got by
+// milkcat_last_error
+EXPORT_API int milkcat_model_set_oov_segment_cache(milkcat_model_t *model,
+                                                   int capacity,
+                                                   int context_size);
+
+// Get the number of hits and misses of the cache set by
+// milkcat_model_set_oov_segment_cache, both of them are 0 if it is disabled
+EXPORT_API void milkcat_model_oov_segment_cache_statistics(
+    milkcat_model_t *model,
+    int64_t *hit_num,
+    int64_t *miss_num);
+
+// Collect the statistics of new words recognized by SEGMENTER_MIXED in the
+// analyzers created from model, their frequencies and adjacent entropies, for
+// the new word discovery of neko. It holds at most capacity words (no more
+// than 2^20) and is shared by the analyzers of model, set capacity to 0 to
+// disable it. It should be called before any analyzer with SEGMENTER_MIXED is
+// created from model, after that the collector is kept as it is until model
+// is destroyed. Returns MC_OK on success, otherwise returns MC_NONE and the
+// error could be got by milkcat_last_error
+EXPORT_API int milkcat_model_set_new_word_collector(milkcat_model_t *model,
+                                                    int capacity);
+
+// Export the statistics of new words collected from model into path, which
+// could be read by neko with -c option. Returns MC_OK on success, otherwise
+// returns MC_NONE and the error could be got by milkcat_last_error
+EXPORT_API int milkcat_model_export_new_words(milkcat_model_t *model,
+                                              const char *path);
+
+// Skip the CRF out-of-vocabulary word recognition of SEGMENTER_MIXED on the
+// spans that bigram segmenter is confident about, that is the spans whose
+// cost margin is greater than threshold. The margin is the cost of the best
+// alternative minus the cost of the best path over the span, where the
+// alternatives are the other paths of bigram segmenter ending within the span
+// and the path taking each character of the span as an unknown one (cost 20
+// per character). So a larger threshold skips fewer spans. It is disabled by
+// default
+EXPORT_API void milkcat_set_oov_confidence_gate(milkcat_t *m,
+                                                double threshold);
+
+// Disable the confidence gate set by milkcat_set_oov_confidence_gate
+EXPORT_API void milkcat_clear_oov_confidence_gate(milkcat_t *m);
+
+// Get the number of spans checked by out-of-vocabulary word recognition and
+// the number of them skipped by the confidence gate
+EXPORT_API void milkcat_oov_gate_statistics(milkcat_t *m,
+                                            int64_t *span_num,
+                                            int64_t *skipped_span_num);
+
+// Enable the cache of the CRF unigram score rows in POSTAGGER_CRF and
+// POSTAGGER_CRF_PRUNED with about capacity entries, 0 disables it. A term
+// whose context window is in the cache gets its tag scores in one lookup.
+// Each analyzer has its own cache, the tags are the same without it
+EXPORT_API void milkcat_set_crf_score_cache(milkcat_t *m, int capacity);
+
+// Get the number of lookups in the CRF score cache that hit and that missed
+EXPORT_API void milkcat_crf_score_cache_statistics(milkcat_t *m,
+                                                   int64_t *hit_num,
+                                                   int64_t *miss_num);
+
+// Get the number of part-of-speech tags in the tag set of analyzer, the tag
+// ids got by milkcat_cursor_tag_id are in [0, milkcat_tag_num). Returns 0 if
+// the analyzer has no tagger
+EXPORT_API int milkcat_tag_num(milkcat_t *m);
+
+// Get the string of tag_id in the tag set of analyzer, or NULL if tag_id is
+// out of range. The string is valid as long as the analyzer
+EXPORT_API const char *milkcat_tag_str(milkcat_t *m, int tag_id);
+
 // Get the error message if an error occurred
 EXPORT_API const char *milkcat_last_error();
 
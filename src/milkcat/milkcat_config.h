@@ -42,6 +42,9 @@ const double kDefaultCost = 16.0;
 
 
 const int kHmmModelMagicNumber = 0x3322;
+const int kHmmModelCSRMagicNumber = 0x3323;
+const int kHmmBigramModelMagicNumber = 0x3324;
+const int kPerceptronModelMagicNumber = 0x3325;
 
 }  // namespace milkcat
 
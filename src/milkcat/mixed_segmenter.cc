@@ -38,14 +38,20 @@ MixedSegmenter::MixedSegmenter():
     oov_recognizer_(nullptr) {
 }
 
-MixedSegmenter *MixedSegmenter::New(ModelFactory *model_factory, 
+MixedSegmenter *MixedSegmenter::New(ModelFactory *model_factory,
+                                    int beam_size,
+                                    bool use_perceptron,
                                     Status *status) {
   MixedSegmenter *self = new MixedSegmenter();
-  self->bigram_ = BigramSegmenter::New(model_factory, true, status);
+  self->bigram_ = BigramSegmenter::New(model_factory,
+                                       true,
+                                       beam_size,
+                                       status);
 
   if (status->ok()) {
     self->oov_recognizer_ = OutOfVocabularyWordRecognition::New(model_factory,
-                                                                status);    
+                                                                use_perceptron,
+                                                                status);
   }
   if (status->ok()) self->bigram_result_ = new TermInstance();
 
@@ -74,4 +80,24 @@ void MixedSegmenter::Segment(TermInstance *term_instance,
   oov_recognizer_->Process(term_instance, bigram_result_, token_instance);
 }
 
+void MixedSegmenter::SetOOVConfidenceGate(double threshold) {
+  oov_recognizer_->set_confidence_gate(bigram_, threshold);
+}
+
+void MixedSegmenter::ClearOOVConfidenceGate() {
+  oov_recognizer_->clear_confidence_gate();
+}
+
+void MixedSegmenter::SetBypassNonCJK(bool bypass) {
+  bigram_->set_bypass_non_cjk(bypass);
+}
+
+int64_t MixedSegmenter::oov_span_num() const {
+  return oov_recognizer_->span_num();
+}
+
+int64_t MixedSegmenter::oov_skipped_span_num() const {
+  return oov_recognizer_->skipped_span_num();
+}
+
 }  // namespace milkcat
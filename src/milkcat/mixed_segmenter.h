@@ -27,6 +27,7 @@
 #ifndef SRC_MILKCAT_MIXED_SEGMENTER_H_
 #define SRC_MILKCAT_MIXED_SEGMENTER_H_
 
+#include <stdint.h>
 #include "utils/utils.h"
 #include "milkcat/segmenter.h"
 #include "milkcat/trie_tree.h"
@@ -42,16 +43,39 @@ class TermInstance;
 class TokenInstance;
 class ModelFactory;
 
-// Mixed Bigram segmenter and CRF Segmenter of OOV recognition
+// Mixed Bigram segmenter and CRF (or perceptron) Segmenter of OOV recognition
 class MixedSegmenter: public Segmenter {
  public:
   ~MixedSegmenter();
 
-  static MixedSegmenter *New(ModelFactory *model_factory, Status *status);
+  // Create the mixed segmenter, beam_size is the beam size of its bigram
+  // segmenter. The OOV words are recognized by PerceptronSegmenter if
+  // use_perceptron is true, otherwise by CRFSegmenter
+  static MixedSegmenter *New(ModelFactory *model_factory,
+                             int beam_size,
+                             bool use_perceptron,
+                             Status *status);
 
   // Segment a token instance into term instance
   void Segment(TermInstance *term_instance, TokenInstance *token_instance);
 
+  // Skips the CRF OOV recognition on the spans whose cost margin in bigram
+  // segmentation is greater than threshold. See also
+  // OutOfVocabularyWordRecognition::set_confidence_gate()
+  void SetOOVConfidenceGate(double threshold);
+
+  // Always runs the CRF OOV recognition, it is the default behavior
+  void ClearOOVConfidenceGate();
+
+  // Stores the non-CJK tokens without decoding in bigram segmenter, see
+  // BigramSegmenter::set_bypass_non_cjk()
+  void SetBypassNonCJK(bool bypass);
+
+  // The number of spans checked by OOV recognition and the number of spans
+  // skipped by confidence gate
+  int64_t oov_span_num() const;
+  int64_t oov_skipped_span_num() const;
+
  private:
   TermInstance *bigram_result_;
   BigramSegmenter *bigram_;
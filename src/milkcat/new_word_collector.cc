@@ -0,0 +1,193 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// new_word_collector.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/new_word_collector.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+#include "milkcat/term_instance.h"
+#include "utils/writable_file.h"
+
+namespace milkcat {
+
+namespace {
+
+// The neighbour of words which are not Chinese words, the same as neko
+constexpr const char *kNotCjk = "-NOT-CJK-";
+
+// FNV-1a hash of text, it is never 0
+uint64_t HashText(const char *text) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char *p = text; *p; ++p) {
+    hash ^= static_cast<uint8_t>(*p);
+    hash *= 1099511628211ULL;
+  }
+  return hash? hash: 1;
+}
+
+// Calculates the entropy of the counts in buckets
+double BucketEntropy(const std::atomic<uint32_t> *buckets, int bucket_num) {
+  double total_count = 0;
+  for (int i = 0; i < bucket_num; ++i) total_count += buckets[i];
+  if (total_count == 0) return 0;
+
+  double entropy = 0;
+  for (int i = 0; i < bucket_num; ++i) {
+    uint32_t count = buckets[i];
+    if (count == 0) continue;
+    double probability = count / total_count;
+    entropy += -probability * log(probability);
+  }
+  return entropy;
+}
+
+}  // namespace
+
+NewWordCollector::NewWordCollector(int capacity): slots_(nullptr),
+                                                  slot_num_(1),
+                                                  term_num_(0) {
+  capacity = std::min(capacity, static_cast<int>(kMaxCapacity));
+  while (slot_num_ < capacity) slot_num_ *= 2;
+  slots_ = new Slot[slot_num_]();
+
+  // The sketch has 8 counters per word in each row
+  sketch_width_ = slot_num_ * 8;
+  sketch_ = std::vector<std::atomic<uint32_t>>(kSketchDepth * sketch_width_);
+}
+
+NewWordCollector::~NewWordCollector() {
+  delete[] slots_;
+  slots_ = nullptr;
+}
+
+uint32_t NewWordCollector::Count(uint64_t hash) const {
+  // The rows use hash1 + row * hash2 as their hash function
+  uint32_t hash1 = hash;
+  uint32_t hash2 = (hash >> 32) | 1;
+  uint32_t count = UINT32_MAX;
+  for (int row = 0; row < kSketchDepth; ++row) {
+    int column = (hash1 + row * hash2) & (sketch_width_ - 1);
+    count = std::min(count, sketch_[row * sketch_width_ + column].load(
+        std::memory_order_relaxed));
+  }
+  return count;
+}
+
+NewWordCollector::Slot *NewWordCollector::FindOrInsert(const char *word,
+                                                       uint64_t hash) {
+  for (int probe = 0; probe < kMaxProbe; ++probe) {
+    Slot *slot = slots_ + ((hash + probe) & (slot_num_ - 1));
+    uint64_t slot_hash = slot->hash.load(std::memory_order_acquire);
+    if (slot_hash == 0) {
+      if (slot->hash.compare_exchange_strong(slot_hash, hash)) {
+        strlcpy(slot->word, word, sizeof(slot->word));
+        slot->ready.store(true, std::memory_order_release);
+        return slot;
+      }
+    }
+
+    // slot_hash is the hash in slot now. If the word is being written by
+    // another thread, wait for it, otherwise the same word may be inserted
+    // into another slot
+    if (slot_hash == hash) {
+      while (slot->ready.load(std::memory_order_acquire) == false) {
+        std::this_thread::yield();
+      }
+      if (strcmp(slot->word, word) == 0) return slot;
+    }
+  }
+
+  return nullptr;
+}
+
+void NewWordCollector::Collect(const TermInstance *term_instance,
+                               int begin,
+                               int end) {
+  for (int i = begin; i < end; ++i) {
+    if (term_instance->token_number_at(i) <= 1 ||
+        term_instance->term_type_at(i) != TermInstance::kChineseWord) {
+      continue;
+    }
+
+    const char *word = term_instance->term_text_at(i);
+    uint64_t hash = HashText(word);
+    uint32_t hash1 = hash;
+    uint32_t hash2 = (hash >> 32) | 1;
+    for (int row = 0; row < kSketchDepth; ++row) {
+      int column = (hash1 + row * hash2) & (sketch_width_ - 1);
+      sketch_[row * sketch_width_ + column].fetch_add(
+          1,
+          std::memory_order_relaxed);
+    }
+
+    Slot *slot = FindOrInsert(word, hash);
+    if (slot == nullptr) continue;
+
+    // Count the neighbours like neko, the sentence boundary is not counted
+    for (int j = i - 1; j <= i + 1; j += 2) {
+      if (j < 0 || j >= term_instance->size()) continue;
+      const char *neighbour =
+          term_instance->term_type_at(j) == TermInstance::kChineseWord?
+          term_instance->term_text_at(j):
+          kNotCjk;
+      int bucket = HashText(neighbour) % kAdjacentBucketNum;
+      std::atomic<uint32_t> *buckets = j < i? slot->left: slot->right;
+      buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+}
+
+void NewWordCollector::Export(const char *path, Status *status) const {
+  char line[1024];
+  WritableFile *fd = WritableFile::New(path, status);
+  if (status->ok()) {
+    snprintf(line, sizeof(line), "%lld", static_cast<long long>(term_num()));
+    fd->WriteLine(line, status);
+  }
+
+  for (int i = 0; i < slot_num_ && status->ok(); ++i) {
+    const Slot *slot = slots_ + i;
+    if (slot->ready.load(std::memory_order_acquire) == false) continue;
+
+    // The adjacent entropy is the minimal one of left and right, the same as
+    // neko
+    double left_entropy = BucketEntropy(slot->left, kAdjacentBucketNum);
+    double right_entropy = BucketEntropy(slot->right, kAdjacentBucketNum);
+    snprintf(line,
+             sizeof(line),
+             "%s %u %.3f",
+             slot->word,
+             Count(slot->hash.load(std::memory_order_relaxed)),
+             std::min(left_entropy, right_entropy));
+    fd->WriteLine(line, status);
+  }
+
+  delete fd;
+}
+
+}  // namespace milkcat
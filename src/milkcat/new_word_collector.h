@@ -0,0 +1,110 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// new_word_collector.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_NEW_WORD_COLLECTOR_H_
+#define SRC_MILKCAT_NEW_WORD_COLLECTOR_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include "milkcat/milkcat_config.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+class TermInstance;
+
+// NewWordCollector collects the statistics of the new words recognized by
+// OutOfVocabularyWordRecognition while analyzing, so that neko could rank the
+// new words without its own passes over the corpus. The frequencies of words
+// are kept in a count-min sketch. The words themselves are kept in a fixed
+// size hash table, each of them has an adjacency sketch, the counts of its
+// left and right neighbours hashed into kAdjacentBucketNum buckets, which
+// estimates its adjacent entropy. All the updates are lock-free atomic
+// operations, so it could be shared by the analyzers of different threads.
+// The words that could not find a slot in table are only counted in the
+// count-min sketch
+class NewWordCollector {
+ public:
+  static const int kSketchDepth = 4;
+  static const int kAdjacentBucketNum = 32;
+  static const int kMaxProbe = 8;
+  static const int kMaxCapacity = 1 << 20;
+
+  // Create the collector holding at most capacity (rounded up to power of 2
+  // and clamped to kMaxCapacity) words
+  explicit NewWordCollector(int capacity);
+  ~NewWordCollector();
+
+  // Collect the new words in term_instance at positions [begin, end), the
+  // terms of more than one token are new words and their neighbours are the
+  // terms in term_instance around them
+  void Collect(const TermInstance *term_instance, int begin, int end);
+
+  // Count the terms of analyzed text, it is the total count of words
+  void AddTermNum(int term_num) {
+    term_num_.fetch_add(term_num, std::memory_order_relaxed);
+  }
+
+  // Export the new words into path. The first line is the total count of
+  // words, and each following line is a word, its frequency and its adjacent
+  // entropy separated by space
+  void Export(const char *path, Status *status) const;
+
+  int capacity() const { return slot_num_; }
+  int64_t term_num() const { return term_num_; }
+
+ private:
+  struct Slot {
+    // The hash of word, 0 for the empty slot. ready is set after word is
+    // written
+    std::atomic<uint64_t> hash;
+    std::atomic<bool> ready;
+    char word[kTermLengthMax];
+    std::atomic<uint32_t> left[kAdjacentBucketNum];
+    std::atomic<uint32_t> right[kAdjacentBucketNum];
+  };
+
+  Slot *slots_;
+  int slot_num_;
+  std::vector<std::atomic<uint32_t>> sketch_;
+  int sketch_width_;
+  std::atomic<int64_t> term_num_;
+
+  // Get the slot of word with hash, insert it if it does not exist. If the
+  // slot with the same hash is being written by another thread, waits until
+  // it is ready. Returns nullptr if there is no slot for it
+  Slot *FindOrInsert(const char *word, uint64_t hash);
+
+  // The frequency of word with hash in count-min sketch
+  uint32_t Count(uint64_t hash) const;
+
+  DISALLOW_COPY_AND_ASSIGN(NewWordCollector);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_NEW_WORD_COLLECTOR_H_
@@ -28,9 +28,13 @@
 #include "milkcat/out_of_vocabulary_word_recognition.h"
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <string>
+#include "milkcat/bigram_segmenter.h"
 #include "milkcat/crf_segmenter.h"
 #include "milkcat/darts.h"
 #include "milkcat/libmilkcat.h"
+#include "milkcat/perceptron_segmenter.h"
 #include "milkcat/token_instance.h"
 #include "utils/utils.h"
 
@@ -38,13 +42,21 @@ namespace milkcat {
 
 OutOfVocabularyWordRecognition *OutOfVocabularyWordRecognition::New(
     ModelFactory *model_factory,
+    bool use_perceptron,
     Status *status) {
   OutOfVocabularyWordRecognition *self = new OutOfVocabularyWordRecognition();
-  self->crf_segmenter_ = CRFSegmenter::New(model_factory, status);
+  self->use_perceptron_ = use_perceptron;
+  if (use_perceptron) {
+    self->oov_segmenter_ = PerceptronSegmenter::New(model_factory, status);
+  } else {
+    self->oov_segmenter_ = CRFSegmenter::New(model_factory, status);
+  }
 
   if (status->ok()) {
     self->term_instance_ = new TermInstance();
     self->oov_property_ = model_factory->OOVProperty(status);
+    self->segment_cache_ = model_factory->OOVSegmentCache();
+    self->new_word_collector_ = model_factory->new_word_collector();
   }
 
   if (status->ok()) {
@@ -56,8 +68,8 @@ OutOfVocabularyWordRecognition *OutOfVocabularyWordRecognition::New(
 }
 
 OutOfVocabularyWordRecognition::~OutOfVocabularyWordRecognition() {
-  delete crf_segmenter_;
-  crf_segmenter_ = NULL;
+  delete oov_segmenter_;
+  oov_segmenter_ = NULL;
 
   delete term_instance_;
   term_instance_ = NULL;
@@ -65,7 +77,15 @@ OutOfVocabularyWordRecognition::~OutOfVocabularyWordRecognition() {
 
 OutOfVocabularyWordRecognition::OutOfVocabularyWordRecognition():
     term_instance_(NULL),
-    crf_segmenter_(NULL) {
+    oov_segmenter_(NULL),
+    use_perceptron_(false),
+    use_confidence_gate_(false),
+    bigram_segmenter_(NULL),
+    gate_threshold_(0.0),
+    span_num_(0),
+    skipped_span_num_(0),
+    segment_cache_(nullptr),
+    new_word_collector_(nullptr) {
 }
 
 void OutOfVocabularyWordRecognition::Process(TermInstance *term_instance,
@@ -81,11 +101,17 @@ void OutOfVocabularyWordRecognition::Process(TermInstance *term_instance,
   bool oov_flag = false,
        next_oov_flag = false;
 
-  for (size_t i = 0; i < in_term_instance->size(); ++i) {
+  // Collects the ranges to recognize first, then they are decoded by the OOV
+  // segmenter in one pass
+  range_term_begin_.clear();
+  range_term_end_.clear();
+  range_begin_.clear();
+  range_end_.clear();
+  int term_num = in_term_instance->size();
+  for (int i = 0; i < term_num; ++i) {
     term_token_number = in_term_instance->token_number_at(i);
     current_token_type = in_token_instance->token_type_at(current_token);
     term_str = in_term_instance->term_text_at(i);
-    // printf("%d\n", ner_term_number);
 
     if (term_token_number > 1) {
       if (next_oov_flag == true) {
@@ -98,7 +124,7 @@ void OutOfVocabularyWordRecognition::Process(TermInstance *term_instance,
       oov_flag = false;
       next_oov_flag = false;
     } else {
-      int oov_property = oov_property_->Search(term_str);
+      int oov_property = oov_property_->Get(term_str);
       if (oov_property == kOOVBeginOfWord) {
         next_oov_flag = true;
         oov_flag = true;
@@ -113,47 +139,204 @@ void OutOfVocabularyWordRecognition::Process(TermInstance *term_instance,
 
     if (oov_flag) {
       ner_term_number++;
-
     } else {
-      // Recognize token from ner_begin_token to current_token
-      if (ner_term_number > 1) {
-        RecognizeRange(in_token_instance, ner_begin_token, current_token);
+      // Range of tokens from ner_begin_token to current_token
+      AddRange(i - ner_term_number, i, ner_begin_token, current_token);
+      ner_begin_token = current_token + term_token_number;
+      ner_term_number = 0;
+    }
 
-        for (size_t j = 0; j < term_instance_->size(); ++j) {
+    current_token += term_token_number;
+  }
+
+  // Remained tokens
+  AddRange(term_num - ner_term_number,
+           term_num,
+           ner_begin_token,
+           current_token);
+
+  RecognizeRanges(in_token_instance);
+
+  // Replaces the terms of each range with the recognized ones and keeps the
+  // others
+  int range_num = range_begin_.size();
+  int range = 0;
+  int i = 0;
+  std::string term_text;
+  range_output_begin_.resize(range_num);
+  range_output_end_.resize(range_num);
+  while (i < term_num) {
+    if (range < range_num && i == range_term_begin_[range]) {
+      range_output_begin_[range] = current_term;
+      int miss = range_miss_[range];
+      if (miss >= 0) {
+        int j = miss == 0? 0: miss_term_ends_[miss - 1];
+        for (; j < miss_term_ends_[miss]; ++j) {
           CopyTermValue(term_instance, current_term, term_instance_, j);
           current_term++;
         }
-      } else if (ner_term_number == 1) {
-        CopyTermValue(term_instance, current_term, in_term_instance, i - 1);
-        current_term++;
+      } else {
+        int token = range_begin_[range];
+        for (int j = cached_term_begin_[range];
+             j < cached_term_begin_[range + 1];
+             ++j) {
+          const SegmentCache::Term &term = cached_terms_[j];
+          term_text.clear();
+          for (int k = 0; k < term.token_number; ++k) {
+            term_text.append(in_token_instance->token_text_at(token++));
+          }
+          term_instance->set_value_at(current_term,
+                                      term_text.c_str(),
+                                      term.token_number,
+                                      term.term_type);
+          current_term++;
+        }
       }
-
+      range_output_end_[range] = current_term;
+      i = range_term_end_[range];
+      range++;
+    } else {
       CopyTermValue(term_instance, current_term, in_term_instance, i);
-      ner_begin_token = current_token + term_token_number;
       current_term++;
-      ner_term_number = 0;
+      i++;
     }
+  }
 
-    current_token += term_token_number;
+  term_instance->set_size(current_term);
+
+  if (new_word_collector_) {
+    new_word_collector_->AddTermNum(current_term);
+    for (int range = 0; range < range_num; ++range) {
+      new_word_collector_->Collect(term_instance,
+                                   range_output_begin_[range],
+                                   range_output_end_[range]);
+    }
   }
+}
 
-  // Recognize remained tokens
-  if (ner_term_number > 1) {
-    RecognizeRange(in_token_instance, ner_begin_token, current_token);
-    for (size_t j = 0; j < term_instance_->size(); ++j) {
-      CopyTermValue(term_instance, current_term, term_instance_, j);
-      current_term++;
+void OutOfVocabularyWordRecognition::AddRange(int term_begin,
+                                              int term_end,
+                                              int begin,
+                                              int end) {
+  // Only one term or the span is skipped, keep the original terms
+  if (term_end - term_begin <= 1 || SkipRange(term_begin, term_end)) return;
+
+  range_term_begin_.push_back(term_begin);
+  range_term_end_.push_back(term_end);
+  range_begin_.push_back(begin);
+  range_end_.push_back(end);
+}
+
+void OutOfVocabularyWordRecognition::RecognizeRanges(
+    TokenInstance *token_instance) {
+  int range_num = range_begin_.size();
+  range_keys_.resize(range_num);
+  range_miss_.resize(range_num);
+  cached_terms_.clear();
+  cached_term_begin_.resize(range_num + 1);
+  miss_begin_.clear();
+  miss_end_.clear();
+  for (int i = 0; i < range_num; ++i) {
+    cached_term_begin_[i] = cached_terms_.size();
+    if (segment_cache_) {
+      GetCacheKey(token_instance, range_begin_[i], range_end_[i],
+                  &range_keys_[i]);
+      if (segment_cache_->Get(range_keys_[i], &range_terms_)) {
+        cached_terms_.insert(cached_terms_.end(),
+                             range_terms_.begin(),
+                             range_terms_.end());
+        range_miss_[i] = -1;
+        continue;
+      }
     }
-    ner_begin_token = current_token + term_token_number;
-  } else if (ner_term_number == 1) {
-    CopyTermValue(term_instance,
-                  current_term,
-                  in_term_instance,
-                  in_term_instance->size() - 1);
-    current_term++;
+
+    range_miss_[i] = miss_begin_.size();
+    miss_begin_.push_back(range_begin_[i]);
+    miss_end_.push_back(range_end_[i]);
   }
+  cached_term_begin_[range_num] = cached_terms_.size();
 
-  term_instance->set_size(current_term);
+  int miss_num = miss_begin_.size();
+  if (miss_num == 0) return;
+  miss_term_ends_.resize(miss_num);
+  oov_segmenter_->SegmentRanges(term_instance_,
+                                token_instance,
+                                miss_begin_.data(),
+                                miss_end_.data(),
+                                miss_num,
+                                miss_term_ends_.data());
+
+  if (segment_cache_ == nullptr) return;
+  for (int i = 0; i < range_num; ++i) {
+    int miss = range_miss_[i];
+    if (miss < 0) continue;
+
+    range_terms_.clear();
+    int j = miss == 0? 0: miss_term_ends_[miss - 1];
+    for (; j < miss_term_ends_[miss]; ++j) {
+      SegmentCache::Term term;
+      term.token_number = term_instance_->token_number_at(j);
+      term.term_type = term_instance_->term_type_at(j);
+      range_terms_.push_back(term);
+    }
+    segment_cache_->Put(range_keys_[i],
+                        range_terms_.data(),
+                        range_terms_.size());
+  }
+}
+
+void OutOfVocabularyWordRecognition::GetCacheKey(
+    TokenInstance *token_instance,
+    int begin,
+    int end,
+    std::string *key) {
+  int context_size = segment_cache_->context_size();
+  int right_context_size = context_size;
+  if (context_size < 0) {
+    // The features at end are used by the arc to the end tag too
+    context_size = oov_segmenter_->context_size();
+    right_context_size = context_size + 1;
+  }
+  int left = std::max(0, begin - context_size);
+  int right = std::min(static_cast<int>(token_instance->size()),
+                       end + right_context_size);
+
+  // The numbers of context tokens make the range unambiguous and tell if
+  // the context is cut by the bound of sentence. The cache is shared by the
+  // analyzers of a model, so the key has the kind of OOV segmenter too
+  int key_header[3] = {use_perceptron_, begin - left, right - end};
+  key->assign(reinterpret_cast<const char *>(key_header),
+              sizeof(key_header));
+  for (int i = left; i < right; ++i) {
+    key->push_back(token_instance->token_type_at(i));
+    key->append(token_instance->token_text_at(i));
+    key->push_back('\0');
+  }
+}
+
+bool OutOfVocabularyWordRecognition::SkipRange(int begin, int end) {
+  span_num_++;
+  if (use_confidence_gate_ == false) return false;
+
+  // The alternatives of the best path over the span are the other paths
+  // ending within it and the path taking each token of it as an unknown
+  // token, which costs kOOVCost per token in bigram segmenter. The terms in
+  // span are single tokens
+  double span_cost = 0.0;
+  double margin = BigramSegmenter::kMaxTermMargin;
+  for (int i = begin; i < end; ++i) {
+    span_cost += bigram_segmenter_->RecentTermCost(i);
+    margin = std::min(margin, bigram_segmenter_->RecentTermMargin(i));
+  }
+  double oov_cost = BigramSegmenter::kOOVCost * (end - begin);
+  margin = std::min(margin, oov_cost - span_cost);
+  LOG("OOV span [%d, %d) margin = %lf\n", begin, end, margin);
+  if (margin > gate_threshold_) {
+    skipped_span_num_++;
+    return true;
+  } else {
+    return false;
+  }
 }
 
 void OutOfVocabularyWordRecognition::CopyTermValue(
@@ -170,11 +353,4 @@ void OutOfVocabularyWordRecognition::CopyTermValue(
       src_term_instance->term_id_at(src_position));
 }
 
-void OutOfVocabularyWordRecognition::RecognizeRange(
-    TokenInstance *token_instance,
-    int begin,
-    int end) {
-  crf_segmenter_->SegmentRange(term_instance_, token_instance, begin, end);
-}
-
 }  // namespace milkcat
@@ -30,38 +30,131 @@
 #define SRC_MILKCAT_OUT_OF_VOCABULARY_WORD_RECOGNITION_H_
 
 #include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
 #include "utils/utils.h"
+#include "milkcat/character_property.h"
 #include "milkcat/darts.h"
-#include "milkcat/crf_segmenter.h"
+#include "milkcat/new_word_collector.h"
 #include "milkcat/part_of_speech_tag_instance.h"
+#include "milkcat/segment_cache.h"
+#include "milkcat/segmenter.h"
 #include "milkcat/crf_model.h"
 #include "milkcat/trie_tree.h"
 #include "milkcat/token_instance.h"
 
 namespace milkcat {
 
+class BigramSegmenter;
 class ModelFactory;
 
 class OutOfVocabularyWordRecognition {
  public:
+  // Create the recognizer, the spans are segmented by PerceptronSegmenter if
+  // use_perceptron is true, otherwise by CRFSegmenter
   static OutOfVocabularyWordRecognition *New(ModelFactory *model_factory,
+                                             bool use_perceptron,
                                              Status *status);
   ~OutOfVocabularyWordRecognition();
   void Process(TermInstance *term_instance,
                TermInstance *in_term_instance,
                TokenInstance *in_token_instance);
 
+  // Enables the confidence gate. in_term_instance of Process() should be the
+  // recent result of bigram_segmenter. A span of single character terms is
+  // passed to OOV segmenter only when its margin is not greater than
+  // threshold. Otherwise the terms from bigram segmenter are kept. The margin
+  // is the cost of the best alternative minus the cost of the best path over
+  // the span. The alternatives are the other paths of bigram_segmenter
+  // ending within the span (RecentTermMargin) and the path taking each token
+  // of the span as an unknown token, whose cost is kOOVCost per token
+  void set_confidence_gate(const BigramSegmenter *bigram_segmenter,
+                           double threshold) {
+    bigram_segmenter_ = bigram_segmenter;
+    gate_threshold_ = threshold;
+    use_confidence_gate_ = true;
+  }
+
+  // Disables the confidence gate, every span goes to OOV segmenter
+  void clear_confidence_gate() {
+    bigram_segmenter_ = nullptr;
+    use_confidence_gate_ = false;
+  }
+
+  // The number of spans of single character terms processed and the number
+  // of spans skipped by the confidence gate
+  int64_t span_num() const { return span_num_; }
+  int64_t skipped_span_num() const { return skipped_span_num_; }
+
   static const int kOOVBeginOfWord = 1;
   static const int kOOVFilteredWord = 2;
 
  private:
   TermInstance *term_instance_;
-  CRFSegmenter *crf_segmenter_;
-  const TrieTree *oov_property_;
+  RangeSegmenter *oov_segmenter_;
+  bool use_perceptron_;
+  const CharacterProperty *oov_property_;
+
+  // The confidence gate
+  bool use_confidence_gate_;
+  const BigramSegmenter *bigram_segmenter_;
+  double gate_threshold_;
+  int64_t span_num_;
+  int64_t skipped_span_num_;
+
+  // The ranges to recognize in Process. Range i is the terms
+  // [range_term_begin_[i], range_term_end_[i]) of the input and the tokens
+  // [range_begin_[i], range_end_[i])
+  std::vector<int> range_term_begin_;
+  std::vector<int> range_term_end_;
+  std::vector<int> range_begin_;
+  std::vector<int> range_end_;
+
+  // The cache of recognized ranges, nullptr if disabled. If range i is found
+  // in the cache, range_miss_[i] is -1 and its terms are
+  // [cached_term_begin_[i], cached_term_begin_[i + 1]) of cached_terms_.
+  // Otherwise range_miss_[i] is its index in the missed ranges
+  // [miss_begin_[j], miss_end_[j]), which are passed to OOV segmenter, and
+  // its recognized terms in term_instance_ end at miss_term_ends_[j]
+  SegmentCache *segment_cache_;
+  std::vector<std::string> range_keys_;
+  std::vector<int> range_miss_;
+  std::vector<SegmentCache::Term> cached_terms_;
+  std::vector<int> cached_term_begin_;
+  std::vector<SegmentCache::Term> range_terms_;
+  std::vector<int> miss_begin_;
+  std::vector<int> miss_end_;
+  std::vector<int> miss_term_ends_;
+
+  // The terms of range i in the output of Process are [range_output_begin_[i],
+  // range_output_end_[i]), they are collected by new_word_collector_ if it is
+  // not nullptr
+  NewWordCollector *new_word_collector_;
+  std::vector<int> range_output_begin_;
+  std::vector<int> range_output_end_;
 
   OutOfVocabularyWordRecognition();
 
-  void RecognizeRange(TokenInstance *token_instance, int begin, int end);
+  // Returns true if the span of terms [begin, end) in the result of bigram
+  // segmenter is confident enough to skip the OOV segmenter
+  bool SkipRange(int begin, int end);
+
+  // Adds the span of terms [term_begin, term_end), which is the tokens
+  // [begin, end), to the ranges to recognize if it has more than one term
+  // and it is not skipped by the confidence gate
+  void AddRange(int term_begin, int term_end, int begin, int end);
+
+  // Looks up the ranges in segment_cache_ and segments the missed ones by OOV
+  // segmenter, then puts them into the cache
+  void RecognizeRanges(TokenInstance *token_instance);
+
+  // Gets the key of tokens [begin, end) in segment_cache_, which is the
+  // tokens within the context size of segment_cache_ around the range
+  void GetCacheKey(TokenInstance *token_instance,
+                   int begin,
+                   int end,
+                   std::string *key);
 
   void CopyTermValue(TermInstance *dest_term_instance,
                      int dest_postion,
@@ -30,11 +30,13 @@
 namespace milkcat {
 
 PartOfSpeechTagInstance::PartOfSpeechTagInstance() {
-  instance_data_ = new InstanceData(1, 1, kTokenMax);
+  instance_data_ = new InstanceData(0, 2, kTokenMax);
+  tag_strs_ = new const char *[kTokenMax];
 }
 
 PartOfSpeechTagInstance::~PartOfSpeechTagInstance() {
   delete instance_data_;
+  delete[] tag_strs_;
 }
 
 }  // namespace milkcat
@@ -40,11 +40,17 @@ class PartOfSpeechTagInstance {
   PartOfSpeechTagInstance();
   ~PartOfSpeechTagInstance();
 
-  static const int kPOSTagS = 0;
-  static const int kOutOfVocabularyI = 0;
+  static const int kTagIdI = 0;
+  static const int kOutOfVocabularyI = 1;
 
   const char *part_of_speech_tag_at(int position) const {
-    return instance_data_->string_at(position, kPOSTagS);
+    assert(position < size());
+    return tag_strs_[position];
+  }
+
+  // Get the id of tag at position in the tag set of the tagger
+  int tag_id_at(int position) const {
+    return instance_data_->integer_at(position, kTagIdI);
   }
 
   // return true if it is a out-of-vocabulary word or it doesnt't have tag
@@ -59,14 +65,20 @@ class PartOfSpeechTagInstance {
   // Get the size of this instance
   int size() const { return instance_data_->size(); }
 
-  // Set the value at position
-  void set_value_at(int position, const char *tag, bool is_oov = true) {
-    instance_data_->set_string_at(position, kPOSTagS, tag);
+  // Set the value at position. tag is the string of tag_id owned by the
+  // model of tagger, it is not copied
+  void set_value_at(int position,
+                    int tag_id,
+                    const char *tag,
+                    bool is_oov = true) {
+    tag_strs_[position] = tag;
+    instance_data_->set_integer_at(position, kTagIdI, tag_id);
     instance_data_->set_integer_at(position, kOutOfVocabularyI, is_oov);
   }
 
  private:
   InstanceData *instance_data_;
+  const char **tag_strs_;
 
   DISALLOW_COPY_AND_ASSIGN(PartOfSpeechTagInstance);
 };
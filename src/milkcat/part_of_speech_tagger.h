@@ -40,6 +40,11 @@ class PartOfSpeechTagger {
   // Tag the TermInstance and put the result to PartOfSpeechTagInstance
   virtual void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
                    TermInstance *term_instance) = 0;
+
+  // The tag set of tagger, the tag-ids in PartOfSpeechTagInstance are in
+  // [0, tag_num())
+  virtual int tag_num() const = 0;
+  virtual const char *tag_str(int tag_id) const = 0;
 };
 
 inline PartOfSpeechTagger::~PartOfSpeechTagger() {}
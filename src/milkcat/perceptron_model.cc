@@ -0,0 +1,294 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_model.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/perceptron_model.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "utils/readable_file.h"
+#include "utils/writable_file.h"
+#include "milkcat/milkcat_config.h"
+#include "milkcat/token_instance.h"
+
+namespace milkcat {
+
+namespace {
+
+// Score of the tags not reachable in Viterbi algorithm
+constexpr float kUnreachable = -1e30f;
+
+// If the transition from left tag to right tag is valid, B and M are
+// followed by M or E, E and S are followed by B or S
+bool ValidTransition(int left, int right) {
+  bool left_in_word = left == PerceptronModel::kB ||
+                      left == PerceptronModel::kM;
+  bool right_in_word = right == PerceptronModel::kM ||
+                       right == PerceptronModel::kE;
+  return left_in_word == right_in_word;
+}
+
+// Hash the feature_id-th feature of token ids a and b into a bucket, it is
+// the finalizer of MurmurHash3
+int FeatureBucket(int feature_id, int a, int b, int bucket_bits) {
+  uint64_t key = (static_cast<uint64_t>(feature_id) << 56) ^
+                 (static_cast<uint64_t>(a) << 28) ^
+                 static_cast<uint64_t>(b);
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return static_cast<int>(key >> (64 - bucket_bits));
+}
+
+}  // namespace
+
+PerceptronModel::PerceptronModel(): index_data_(nullptr),
+                                    bucket_bits_(0),
+                                    bucket_num_(0),
+                                    weights_(nullptr) {
+  for (int i = 0; i < kTagNum * kTagNum; ++i) transitions_[i] = 0.0f;
+}
+
+PerceptronModel::~PerceptronModel() {
+  delete[] weights_;
+  weights_ = nullptr;
+
+  delete[] index_data_;
+  index_data_ = nullptr;
+}
+
+PerceptronModel *PerceptronModel::NewEmpty(
+    const std::vector<std::string> &characters,
+    int bucket_bits) {
+  PerceptronModel *self = new PerceptronModel();
+
+  // Keys of double array should be sorted and unique
+  std::vector<std::string> sorted_characters = characters;
+  std::sort(sorted_characters.begin(), sorted_characters.end());
+  sorted_characters.erase(std::unique(sorted_characters.begin(),
+                                      sorted_characters.end()),
+                          sorted_characters.end());
+
+  std::vector<const char *> keys;
+  std::vector<int> ids;
+  for (const std::string &character : sorted_characters) {
+    keys.push_back(character.c_str());
+    ids.push_back(kCharacterIdStart + ids.size());
+  }
+  self->double_array_.build(keys.size(), keys.data(), nullptr, ids.data());
+
+  self->bucket_bits_ = bucket_bits;
+  self->bucket_num_ = 1 << bucket_bits;
+  self->weights_ = new float[self->weight_num()];
+  for (int i = 0; i < self->weight_num(); ++i) self->weights_[i] = 0.0f;
+
+  return self;
+}
+
+PerceptronModel *PerceptronModel::New(const char *model_path,
+                                      Status *status) {
+  ReadableFile *fd = ReadableFile::New(model_path, status);
+  PerceptronModel *self = new PerceptronModel();
+
+  if (status->ok()) {
+    int32_t magic_number = 0;
+    fd->ReadValue<int32_t>(&magic_number, status);
+    if (magic_number != kPerceptronModelMagicNumber) {
+      *status = Status::Corruption(model_path);
+    }
+  }
+
+  if (status->ok()) fd->ReadValue<int32_t>(&self->bucket_bits_, status);
+  if (status->ok() && (self->bucket_bits_ <= 0 || self->bucket_bits_ > 30)) {
+    *status = Status::Corruption(model_path);
+  }
+
+  int32_t index_size = 0;
+  if (status->ok()) fd->ReadValue<int32_t>(&index_size, status);
+  if (status->ok() && index_size <= 0) *status = Status::Corruption(model_path);
+  if (status->ok()) {
+    self->index_data_ = new char[index_size];
+    fd->Read(self->index_data_, index_size, status);
+    if (status->ok()) self->double_array_.set_array(self->index_data_);
+  }
+
+  if (status->ok()) {
+    fd->Read(self->transitions_, sizeof(self->transitions_), status);
+  }
+
+  if (status->ok()) {
+    self->bucket_num_ = 1 << self->bucket_bits_;
+    self->weights_ = new float[self->weight_num()];
+    fd->Read(self->weights_, sizeof(float) * self->weight_num(), status);
+  }
+
+  delete fd;
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+// Perceptron model file struct
+//
+// int32_t magic_number = kPerceptronModelMagicNumber
+// int32_t bucket_bits
+// int32_t index_size
+// char[index_size] index
+// float[kTagNum * kTagNum] transitions
+// float[(1 << bucket_bits) * kTagNum] weights
+void PerceptronModel::Save(const char *model_path, Status *status) const {
+  WritableFile *fd = WritableFile::New(model_path, status);
+
+  if (status->ok()) {
+    fd->WriteValue<int32_t>(kPerceptronModelMagicNumber, status);
+  }
+  if (status->ok()) fd->WriteValue<int32_t>(bucket_bits_, status);
+  if (status->ok()) {
+    fd->WriteValue<int32_t>(
+        static_cast<int32_t>(double_array_.total_size()),
+        status);
+  }
+  if (status->ok()) fd->Write(double_array_.array(),
+                              double_array_.total_size(),
+                              status);
+  if (status->ok()) fd->Write(transitions_, sizeof(transitions_), status);
+  if (status->ok()) fd->Write(weights_, sizeof(float) * weight_num(), status);
+
+  delete fd;
+}
+
+int PerceptronModel::token_id(const char *token_text, int token_type) const {
+  if (token_type != TokenInstance::kChineseChar) {
+    return kTokenTypeIdStart + token_type;
+  }
+
+  int id = double_array_.exactMatchSearch<int>(token_text);
+  return id >= 0? id: kUnknownId;
+}
+
+void PerceptronModel::FeatureBuckets(const int *ids,
+                                     int size,
+                                     int position,
+                                     int *buckets) const {
+  int c[2 * kContextSize + 1];
+  for (int i = -kContextSize; i <= kContextSize; ++i) {
+    int p = position + i;
+    c[i + kContextSize] = p >= 0 && p < size? ids[p]: kPaddingId;
+  }
+
+  // Unigrams C-2, C-1, C0, C1, C2
+  for (int i = 0; i < 2 * kContextSize + 1; ++i) {
+    buckets[i] = FeatureBucket(i, c[i], kPaddingId, bucket_bits_);
+  }
+
+  // Bigrams C-2C-1, C-1C0, C0C1, C1C2 and C-1C1
+  for (int i = 0; i < 2 * kContextSize; ++i) {
+    buckets[2 * kContextSize + 1 + i] = FeatureBucket(2 * kContextSize + 1 + i,
+                                                      c[i],
+                                                      c[i + 1],
+                                                      bucket_bits_);
+  }
+  buckets[kFeatureNum - 1] = FeatureBucket(kFeatureNum - 1,
+                                           c[kContextSize - 1],
+                                           c[kContextSize + 1],
+                                           bucket_bits_);
+}
+
+void PerceptronModel::Decode(const int *ids,
+                             int size,
+                             int begin,
+                             int end,
+                             std::vector<float> *scores,
+                             std::vector<int> *backs,
+                             int *tags) const {
+  int length = end - begin;
+  if (length <= 0) return;
+  scores->resize(length * kTagNum);
+  backs->resize(length * kTagNum);
+
+  int buckets[kFeatureNum];
+  float emits[kTagNum];
+  for (int i = 0; i < length; ++i) {
+    FeatureBuckets(ids, size, begin + i, buckets);
+    for (int tag = 0; tag < kTagNum; ++tag) emits[tag] = 0.0f;
+    for (int feature = 0; feature < kFeatureNum; ++feature) {
+      const float *row = weights_ + buckets[feature] * kTagNum;
+      for (int tag = 0; tag < kTagNum; ++tag) emits[tag] += row[tag];
+    }
+
+    float *score = scores->data() + i * kTagNum;
+    int *back = backs->data() + i * kTagNum;
+    for (int tag = 0; tag < kTagNum; ++tag) {
+      score[tag] = kUnreachable;
+      back[tag] = kS;
+
+      if (i == 0) {
+        // The token before begin is taken as S
+        if (ValidTransition(kS, tag)) {
+          score[tag] = transitions_[kS * kTagNum + tag] + emits[tag];
+        }
+        continue;
+      }
+
+      const float *left_score = score - kTagNum;
+      for (int left = 0; left < kTagNum; ++left) {
+        if (!ValidTransition(left, tag) || left_score[left] == kUnreachable) {
+          continue;
+        }
+        float s = left_score[left] + transitions_[left * kTagNum + tag];
+        if (s > score[tag]) {
+          score[tag] = s;
+          back[tag] = left;
+        }
+      }
+      if (score[tag] != kUnreachable) score[tag] += emits[tag];
+    }
+  }
+
+  // The token after end is taken as S too
+  const float *last_score = scores->data() + (length - 1) * kTagNum;
+  int best_tag = kS;
+  float best_score = kUnreachable;
+  for (int tag = 0; tag < kTagNum; ++tag) {
+    if (!ValidTransition(tag, kS) || last_score[tag] == kUnreachable) continue;
+    float s = last_score[tag] + transitions_[tag * kTagNum + kS];
+    if (s > best_score) {
+      best_score = s;
+      best_tag = tag;
+    }
+  }
+
+  for (int i = length - 1; i >= 0; --i) {
+    tags[i] = best_tag;
+    best_tag = (*backs)[i * kTagNum + best_tag];
+  }
+}
+
+}  // namespace milkcat
@@ -0,0 +1,132 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_model.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_PERCEPTRON_MODEL_H_
+#define SRC_MILKCAT_PERCEPTRON_MODEL_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "utils/utils.h"
+#include "utils/status.h"
+#include "milkcat/darts.h"
+
+namespace milkcat {
+
+// The model of averaged perceptron segmenter. Each token of a sentence is
+// mapped to an integer id, its features are the ids of tokens around it and
+// the weights of a feature are found in a hashed table of bucket_num() rows,
+// one weight for each of the B, M, E, S tags
+class PerceptronModel {
+ public:
+  enum {
+    kB = 0,
+    kM = 1,
+    kE = 2,
+    kS = 3
+  };
+  static const int kTagNum = 4;
+
+  // Number of features of a token: the unigrams C-2 ... C2 and the bigrams
+  // C-2C-1, C-1C0, C0C1, C1C2 and C-1C1 of the token ids
+  static const int kFeatureNum = 10;
+
+  // Features only look at the tokens within kContextSize of a token
+  static const int kContextSize = 2;
+
+  // Ids of the tokens. The positions out of sentence are kPaddingId, the
+  // tokens other than Chinese characters are kTokenTypeIdStart plus their
+  // token type and the Chinese characters not in the model are kUnknownId
+  static const int kPaddingId = 0;
+  static const int kTokenTypeIdStart = 1;
+  static const int kUnknownId = 16;
+  static const int kCharacterIdStart = 17;
+
+  static const int kDefaultBucketBits = 20;
+
+  // Load the model from model_path. On success, return the instance and
+  // status = Status::OK(). On failed, return nullptr and status !=
+  // Status::OK()
+  static PerceptronModel *New(const char *model_path, Status *status);
+
+  // Create a model with all weights zero, it has the Chinese characters in
+  // characters and 2 ^ bucket_bits buckets of feature weights
+  static PerceptronModel *NewEmpty(const std::vector<std::string> &characters,
+                                   int bucket_bits);
+
+  ~PerceptronModel();
+
+  // Save the model data into file
+  void Save(const char *model_path, Status *status) const;
+
+  // Get the id of a token from its text and token type
+  int token_id(const char *token_text, int token_type) const;
+
+  // Get the buckets of the kFeatureNum features of position from the token
+  // ids[0, size) into buckets
+  void FeatureBuckets(const int *ids,
+                      int size,
+                      int position,
+                      int *buckets) const;
+
+  // Decode the tags of tokens [begin, end) of ids[0, size) with the highest
+  // score into tags, the tokens before begin and after end are taken as S.
+  // scores and backs are the buffers of Viterbi algorithm
+  void Decode(const int *ids,
+              int size,
+              int begin,
+              int end,
+              std::vector<float> *scores,
+              std::vector<int> *backs,
+              int *tags) const;
+
+  int bucket_num() const { return bucket_num_; }
+
+  // Weights of the features, the weight of tag in bucket is at index
+  // bucket * kTagNum + tag
+  float *weights() { return weights_; }
+  int weight_num() const { return bucket_num_ * kTagNum; }
+
+  // Weights of the tag transitions, the weight from left to right is at
+  // index left * kTagNum + right
+  float *transitions() { return transitions_; }
+
+ private:
+  Darts::DoubleArray double_array_;
+  char *index_data_;
+  int bucket_bits_;
+  int bucket_num_;
+  float *weights_;
+  float transitions_[kTagNum * kTagNum];
+
+  PerceptronModel();
+
+  DISALLOW_COPY_AND_ASSIGN(PerceptronModel);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_PERCEPTRON_MODEL_H_
@@ -0,0 +1,142 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_segmenter.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/perceptron_segmenter.h"
+#include "milkcat/libmilkcat.h"
+#include "milkcat/term_instance.h"
+#include "milkcat/token_instance.h"
+
+namespace milkcat {
+
+PerceptronSegmenter::PerceptronSegmenter(): model_(nullptr) {
+}
+
+PerceptronSegmenter::~PerceptronSegmenter() {
+  model_ = nullptr;
+}
+
+PerceptronSegmenter *PerceptronSegmenter::New(ModelFactory *model_factory,
+                                              Status *status) {
+  PerceptronSegmenter *self = new PerceptronSegmenter();
+  self->model_ = model_factory->PerceptronSegModel(status);
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return nullptr;
+  }
+}
+
+void PerceptronSegmenter::GetTokenIds(TokenInstance *token_instance) {
+  int size = token_instance->size();
+  ids_.resize(size);
+  for (int i = 0; i < size; ++i) {
+    ids_[i] = model_->token_id(token_instance->token_text_at(i),
+                               token_instance->token_type_at(i));
+  }
+}
+
+void PerceptronSegmenter::Segment(TermInstance *term_instance,
+                                  TokenInstance *token_instance) {
+  GetTokenIds(token_instance);
+  int term_num = SegmentRange(term_instance,
+                              token_instance,
+                              0,
+                              token_instance->size(),
+                              0);
+  term_instance->set_size(term_num);
+}
+
+void PerceptronSegmenter::SegmentRanges(TermInstance *term_instance,
+                                        TokenInstance *token_instance,
+                                        const int *begins,
+                                        const int *ends,
+                                        int range_num,
+                                        int *term_ends) {
+  GetTokenIds(token_instance);
+
+  int term_end = 0;
+  for (int i = 0; i < range_num; ++i) {
+    term_end = SegmentRange(term_instance,
+                            token_instance,
+                            begins[i],
+                            ends[i],
+                            term_end);
+    term_ends[i] = term_end;
+  }
+  term_instance->set_size(term_end);
+}
+
+int PerceptronSegmenter::SegmentRange(TermInstance *term_instance,
+                                      TokenInstance *token_instance,
+                                      int begin,
+                                      int end,
+                                      int term_begin) {
+  int length = end - begin;
+  if (length <= 0) return term_begin;
+
+  tags_.resize(length);
+  model_->Decode(ids_.data(),
+                 ids_.size(),
+                 begin,
+                 end,
+                 &scores_,
+                 &backs_,
+                 tags_.data());
+
+  // A term ends at tag E or S, Decode ensures the last tag is one of them
+  int term_count = term_begin;
+  int token_count = 0;
+  buffer_.clear();
+  for (int i = 0; i < length; ++i) {
+    token_count++;
+    buffer_.append(token_instance->token_text_at(begin + i));
+
+    int tag = tags_[i];
+    if (tag == PerceptronModel::kS || tag == PerceptronModel::kE) {
+      int term_type;
+      if (token_count == 1) {
+        term_type = TokenTypeToTermType(
+            token_instance->token_type_at(begin + i));
+      } else {
+        term_type = TermInstance::kChineseWord;
+      }
+
+      term_instance->set_value_at(term_count,
+                                  buffer_.c_str(),
+                                  token_count,
+                                  term_type);
+      term_count++;
+      token_count = 0;
+      buffer_.clear();
+    }
+  }
+
+  return term_count;
+}
+
+}  // namespace milkcat
@@ -0,0 +1,95 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// perceptron_segmenter.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_PERCEPTRON_SEGMENTER_H_
+#define SRC_MILKCAT_PERCEPTRON_SEGMENTER_H_
+
+#include <string>
+#include <vector>
+#include "utils/utils.h"
+#include "utils/status.h"
+#include "milkcat/perceptron_model.h"
+#include "milkcat/segmenter.h"
+
+namespace milkcat {
+
+class ModelFactory;
+class TermInstance;
+class TokenInstance;
+
+// Character-based segmenter of averaged perceptron model, it tags the tokens
+// with B, M, E, S tags from the integer features of PerceptronModel. It is
+// much faster than CRFSegmenter with a little loss of accuracy
+class PerceptronSegmenter: public RangeSegmenter {
+ public:
+  static PerceptronSegmenter *New(ModelFactory *model_factory,
+                                  Status *status);
+  ~PerceptronSegmenter();
+
+  // Segment a token instance into term instance
+  void Segment(TermInstance *term_instance, TokenInstance *token_instance);
+
+  // Segment ranges of token_instance, see RangeSegmenter::SegmentRanges
+  void SegmentRanges(TermInstance *term_instance,
+                     TokenInstance *token_instance,
+                     const int *begins,
+                     const int *ends,
+                     int range_num,
+                     int *term_ends);
+
+  int context_size() const { return PerceptronModel::kContextSize; }
+
+ private:
+  const PerceptronModel *model_;
+
+  // Token ids of current sentence, the tags of current range and the
+  // buffers of decoding
+  std::vector<int> ids_;
+  std::vector<int> tags_;
+  std::vector<float> scores_;
+  std::vector<int> backs_;
+  std::string buffer_;
+
+  PerceptronSegmenter();
+
+  // Get the token ids of token_instance into ids_
+  void GetTokenIds(TokenInstance *token_instance);
+
+  // Decode the tags of range [begin, end) of token_instance and stores its
+  // terms into term_instance from position term_begin. Returns the end
+  // position of the terms, which is also the size of term_instance
+  int SegmentRange(TermInstance *term_instance,
+                   TokenInstance *token_instance,
+                   int begin,
+                   int end,
+                   int term_begin);
+
+  DISALLOW_COPY_AND_ASSIGN(PerceptronSegmenter);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_PERCEPTRON_SEGMENTER_H_
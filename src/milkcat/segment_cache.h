@@ -0,0 +1,68 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// segment_cache.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_SEGMENT_CACHE_H_
+#define SRC_MILKCAT_SEGMENT_CACHE_H_
+
+#include "milkcat/sharded_lru_cache.h"
+#include "utils/utils.h"
+
+namespace milkcat {
+
+// A term in the span of SegmentCache, the term text is the concatenation of
+// its tokens
+struct SegmentCacheTerm {
+  int token_number;
+  int term_type;
+};
+
+// SegmentCache is a bounded cache of the terms of the out-of-vocabulary spans
+// segmented by CRF segmenter. The key is the token text of a span together
+// with its context window, so that a hit returns exactly the terms the CRF
+// segmenter would give
+class SegmentCache: public ShardedLRUCache<SegmentCacheTerm> {
+ public:
+  typedef SegmentCacheTerm Term;
+
+  // Create the cache holding about capacity entries in total. The key of a
+  // span has context_size tokens on each side, -1 for the context size of
+  // the CRF segmenter
+  SegmentCache(int capacity, int context_size):
+      ShardedLRUCache<SegmentCacheTerm>(capacity),
+      context_size_(context_size) {
+  }
+
+  int context_size() const { return context_size_; }
+
+ private:
+  int context_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SegmentCache);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_SEGMENT_CACHE_H_
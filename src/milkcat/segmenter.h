@@ -44,6 +44,26 @@ class Segmenter {
 
 inline Segmenter::~Segmenter() {}
 
+// The base class for the segmenters which could segment the ranges of a token
+// instance, they recognize the out-of-vocabulary words in MixedSegmenter
+class RangeSegmenter: public Segmenter {
+ public:
+  // Segment range_num ranges [begins[i], ends[i]) of token_instance with the
+  // bounds of each range as the bounds of terms. The terms of all ranges are
+  // stored into term_instance one range after another, the terms of range i
+  // are [term_ends[i - 1], term_ends[i]) with term_ends[-1] = 0
+  virtual void SegmentRanges(TermInstance *term_instance,
+                             TokenInstance *token_instance,
+                             const int *begins,
+                             const int *ends,
+                             int range_num,
+                             int *term_ends) = 0;
+
+  // The terms of a range only depend on the tokens within context_size() of
+  // it
+  virtual int context_size() const = 0;
+};
+
 }  // namespace milkcat
 
 #endif  // SRC_MILKCAT_SEGMENTER_H_
@@ -0,0 +1,130 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// sharded_lru_cache.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_SHARDED_LRU_CACHE_H_
+#define SRC_MILKCAT_SHARDED_LRU_CACHE_H_
+
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "utils/utils.h"
+
+namespace milkcat {
+
+// ShardedLRUCache is a bounded cache from a string key to an array of Item.
+// It is thread safe and could be shared by the analyzers of different
+// threads. The entries are split into shards by the hash of key, each shard
+// is an LRU list with its own lock
+template <class Item>
+class ShardedLRUCache {
+ public:
+  static const int kShardNum = 16;
+
+  // Create the cache holding about capacity entries in total
+  explicit ShardedLRUCache(int capacity): hit_num_(0), miss_num_(0) {
+    shard_capacity_ = (capacity + kShardNum - 1) / kShardNum;
+    if (shard_capacity_ < 1) shard_capacity_ = 1;
+  }
+
+  // Copy the items of key into items and returns true if key is in the cache,
+  // otherwise returns false
+  bool Get(const std::string &key, std::vector<Item> *items) {
+    Shard *shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    auto it = shard->index.find(key);
+    if (it == shard->index.end()) {
+      miss_num_++;
+      return false;
+    }
+
+    // Move the entry to the front of LRU list
+    shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+    *items = it->second->items;
+    hit_num_++;
+    return true;
+  }
+
+  // Put the item_num items of key into the cache, the least recently used
+  // entry in the shard of key is removed if the shard is full
+  void Put(const std::string &key, const Item *items, int item_num) {
+    Shard *shard = GetShard(key);
+    std::lock_guard<std::mutex> lock(shard->mutex);
+
+    // Another thread may have put the same key after our Get
+    if (shard->index.find(key) != shard->index.end()) return;
+
+    if (static_cast<int>(shard->entries.size()) >= shard_capacity_) {
+      shard->index.erase(shard->entries.back().key);
+      shard->entries.pop_back();
+    }
+
+    shard->entries.emplace_front();
+    Entry &entry = shard->entries.front();
+    entry.key = key;
+    entry.items.assign(items, items + item_num);
+    shard->index.emplace(key, shard->entries.begin());
+  }
+
+  int capacity() const { return shard_capacity_ * kShardNum; }
+
+  // Number of calls of Get that found the key and that did not
+  int64_t hit_num() const { return hit_num_; }
+  int64_t miss_num() const { return miss_num_; }
+
+ private:
+  struct Entry {
+    std::string key;
+    std::vector<Item> items;
+  };
+
+  struct Shard {
+    std::mutex mutex;
+    std::list<Entry> entries;
+    std::unordered_map<std::string,
+                       typename std::list<Entry>::iterator> index;
+  };
+
+  Shard shards_[kShardNum];
+  int shard_capacity_;
+  std::atomic<int64_t> hit_num_;
+  std::atomic<int64_t> miss_num_;
+
+  Shard *GetShard(const std::string &key) {
+    return shards_ + std::hash<std::string>()(key) % kShardNum;
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(ShardedLRUCache);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_SHARDED_LRU_CACHE_H_
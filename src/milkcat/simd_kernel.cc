@@ -0,0 +1,699 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// simd_kernel.cc --- Created at 2026-10-19
+//
+
+#include "milkcat/simd_kernel.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MILKCAT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace milkcat {
+
+namespace {
+
+// The initial value of maximum in max-plus, the same as CRFTagger used
+constexpr float kMinCost = -1e37f;
+
+// Constants of the Cephes expf. exp(x) = 2^n * exp(r), where n =
+// floor(x * log2(e) + 0.5) and r = x - n * ln(2) is computed with ln(2) split
+// into kExpC1 + kExpC2 for precision. exp(r) is approximated by polynomial.
+constexpr float kExpMax = 88.3f;
+constexpr float kExpMin = -87.3f;
+constexpr float kExpLog2e = 1.44269504088896341f;
+constexpr float kExpC1 = 0.693359375f;
+constexpr float kExpC2 = -2.12194440e-4f;
+constexpr float kExpP0 = 1.9875691500e-4f;
+constexpr float kExpP1 = 1.3981999507e-3f;
+constexpr float kExpP2 = 8.3334519073e-3f;
+constexpr float kExpP3 = 4.1665795894e-2f;
+constexpr float kExpP4 = 1.6666665459e-1f;
+constexpr float kExpP5 = 5.0000001201e-1f;
+
+// Scalar add_rows on tags in [begin, end). It is also used to process the
+// tail tags of the vectorized kernels
+inline void AddRowsRange(float *cost,
+                         const float *cost_data,
+                         const int *offsets,
+                         int offset_num,
+                         int begin,
+                         int end) {
+  for (int tag = begin; tag < end; ++tag) {
+    float tag_cost = cost[tag];
+    for (int i = 0; i < offset_num; ++i) {
+      tag_cost += cost_data[offsets[i] + tag];
+    }
+    cost[tag] = tag_cost;
+  }
+}
+
+// Scalar max_plus_arc on right tags in [begin, end)
+inline void MaxPlusArcRange(float *cost,
+                            int *left_tag,
+                            const float *left_cost,
+                            const float *cost_data,
+                            const int *offsets,
+                            int offset_num,
+                            int tag_num,
+                            int begin,
+                            int end) {
+  for (int right = begin; right < end; ++right) {
+    float best_cost = kMinCost;
+    int best_left = 0;
+    for (int left = 0; left < tag_num; ++left) {
+      const float *row = cost_data + left * tag_num + right;
+      float arc_cost = left_cost[left];
+      for (int i = 0; i < offset_num; ++i) {
+        arc_cost += row[offsets[i]];
+      }
+      if (arc_cost > best_cost) {
+        best_cost = arc_cost;
+        best_left = left;
+      }
+    }
+    cost[right] = best_cost;
+    left_tag[right] = best_left;
+  }
+}
+
+// Scalar exp on elements in [begin, end)
+inline void ExpRange(float *y, const float *x, float bias, int begin, int end) {
+  for (int i = begin; i < end; ++i) {
+    float v = x[i] + bias;
+    if (v > kExpMax) v = kExpMax;
+    if (v < kExpMin) v = kExpMin;
+
+    // exponent = floor(fx), truncating and then fixing the negative values
+    float fx = v * kExpLog2e + 0.5f;
+    float exponent = static_cast<float>(static_cast<int32_t>(fx));
+    if (exponent > fx) exponent = exponent - 1.0f;
+
+    v = v - exponent * kExpC1;
+    v = v - exponent * kExpC2;
+    float z = v * v;
+    float p = kExpP0;
+    p = p * v + kExpP1;
+    p = p * v + kExpP2;
+    p = p * v + kExpP3;
+    p = p * v + kExpP4;
+    p = p * v + kExpP5;
+    p = p * z + v + 1.0f;
+
+    int32_t bits = (static_cast<int32_t>(exponent) + 127) << 23;
+    float pow2n;
+    memcpy(&pow2n, &bits, sizeof(pow2n));
+    y[i] = p * pow2n;
+  }
+}
+
+// Scalar min_plus_trans on candidates in [begin, end)
+inline void MinPlusTransRange(float *cost,
+                              int *context,
+                              const float *context_cost,
+                              const float *const *trans_rows,
+                              int context_num,
+                              const int *tags,
+                              int begin,
+                              int end) {
+  for (int j = begin; j < end; ++j) {
+    int tag = tags[j];
+    float best_cost = context_cost[0] + trans_rows[0][tag];
+    int best_context = 0;
+    for (int i = 1; i < context_num; ++i) {
+      float arc_cost = context_cost[i] + trans_rows[i][tag];
+      if (arc_cost < best_cost) {
+        best_cost = arc_cost;
+        best_context = i;
+      }
+    }
+    cost[j] = best_cost;
+    context[j] = best_context;
+  }
+}
+
+void AddRowsScalar(float *cost,
+                   const float *cost_data,
+                   const int *offsets,
+                   int offset_num,
+                   int tag_num) {
+  AddRowsRange(cost, cost_data, offsets, offset_num, 0, tag_num);
+}
+
+void MaxPlusArcScalar(float *cost,
+                      int *left_tag,
+                      const float *left_cost,
+                      const float *cost_data,
+                      const int *offsets,
+                      int offset_num,
+                      int tag_num) {
+  MaxPlusArcRange(cost,
+                  left_tag,
+                  left_cost,
+                  cost_data,
+                  offsets,
+                  offset_num,
+                  tag_num,
+                  0,
+                  tag_num);
+}
+
+void ExpScalar(float *y, const float *x, float bias, int n) {
+  ExpRange(y, x, bias, 0, n);
+}
+
+void LaneMaxPlusArcScalar(float *cost,
+                          int *left_tag,
+                          const float *left_cost,
+                          const float *cost_data,
+                          const int *offsets,
+                          int offset_num,
+                          int tag_num) {
+  for (int right = 0; right < tag_num; ++right) {
+    for (int lane = 0; lane < kSimdLaneNum; ++lane) {
+      float best_cost = kMinCost;
+      int best_left = 0;
+      for (int left = 0; left < tag_num; ++left) {
+        float arc_cost = left_cost[left * kSimdLaneNum + lane];
+        for (int i = 0; i < offset_num; ++i) {
+          int offset = offsets[i * kSimdLaneNum + lane];
+          if (offset >= 0) {
+            arc_cost += cost_data[offset + left * tag_num + right];
+          }
+        }
+        if (arc_cost > best_cost) {
+          best_cost = arc_cost;
+          best_left = left;
+        }
+      }
+      cost[right * kSimdLaneNum + lane] = best_cost;
+      left_tag[right * kSimdLaneNum + lane] = best_left;
+    }
+  }
+}
+
+void MinPlusTransScalar(float *cost,
+                        int *context,
+                        const float *context_cost,
+                        const float *const *trans_rows,
+                        int context_num,
+                        const int *tags,
+                        int tag_num) {
+  MinPlusTransRange(cost,
+                    context,
+                    context_cost,
+                    trans_rows,
+                    context_num,
+                    tags,
+                    0,
+                    tag_num);
+}
+
+#ifdef MILKCAT_X86_SIMD
+
+__attribute__((target("sse2")))
+void AddRowsSSE(float *cost,
+                const float *cost_data,
+                const int *offsets,
+                int offset_num,
+                int tag_num) {
+  int tag = 0;
+  for (; tag + 4 <= tag_num; tag += 4) {
+    __m128 tag_cost = _mm_loadu_ps(cost + tag);
+    for (int i = 0; i < offset_num; ++i) {
+      tag_cost = _mm_add_ps(tag_cost,
+                            _mm_loadu_ps(cost_data + offsets[i] + tag));
+    }
+    _mm_storeu_ps(cost + tag, tag_cost);
+  }
+  AddRowsRange(cost, cost_data, offsets, offset_num, tag, tag_num);
+}
+
+__attribute__((target("sse2")))
+void MaxPlusArcSSE(float *cost,
+                   int *left_tag,
+                   const float *left_cost,
+                   const float *cost_data,
+                   const int *offsets,
+                   int offset_num,
+                   int tag_num) {
+  int right = 0;
+  for (; right + 4 <= tag_num; right += 4) {
+    __m128 best_cost = _mm_set1_ps(kMinCost);
+    __m128 best_left = _mm_castsi128_ps(_mm_setzero_si128());
+    for (int left = 0; left < tag_num; ++left) {
+      const float *row = cost_data + left * tag_num + right;
+      __m128 arc_cost = _mm_set1_ps(left_cost[left]);
+      for (int i = 0; i < offset_num; ++i) {
+        arc_cost = _mm_add_ps(arc_cost, _mm_loadu_ps(row + offsets[i]));
+      }
+
+      // SSE2 has no blend instruction, select by the and-andnot-or mask
+      __m128 greater = _mm_cmpgt_ps(arc_cost, best_cost);
+      __m128 left_vec = _mm_castsi128_ps(_mm_set1_epi32(left));
+      best_cost = _mm_or_ps(_mm_and_ps(greater, arc_cost),
+                            _mm_andnot_ps(greater, best_cost));
+      best_left = _mm_or_ps(_mm_and_ps(greater, left_vec),
+                            _mm_andnot_ps(greater, best_left));
+    }
+    _mm_storeu_ps(cost + right, best_cost);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(left_tag + right),
+                     _mm_castps_si128(best_left));
+  }
+  MaxPlusArcRange(cost,
+                  left_tag,
+                  left_cost,
+                  cost_data,
+                  offsets,
+                  offset_num,
+                  tag_num,
+                  right,
+                  tag_num);
+}
+
+__attribute__((target("sse2")))
+void ExpSSE(float *y, const float *x, float bias, int n) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_add_ps(_mm_loadu_ps(x + i), _mm_set1_ps(bias));
+    v = _mm_min_ps(v, _mm_set1_ps(kExpMax));
+    v = _mm_max_ps(v, _mm_set1_ps(kExpMin));
+
+    __m128 fx = _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(kExpLog2e)),
+                           _mm_set1_ps(0.5f));
+    __m128 exponent = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    __m128 greater = _mm_cmpgt_ps(exponent, fx);
+    exponent = _mm_sub_ps(exponent, _mm_and_ps(greater, one));
+
+    v = _mm_sub_ps(v, _mm_mul_ps(exponent, _mm_set1_ps(kExpC1)));
+    v = _mm_sub_ps(v, _mm_mul_ps(exponent, _mm_set1_ps(kExpC2)));
+    __m128 z = _mm_mul_ps(v, v);
+    __m128 p = _mm_set1_ps(kExpP0);
+    p = _mm_add_ps(_mm_mul_ps(p, v), _mm_set1_ps(kExpP1));
+    p = _mm_add_ps(_mm_mul_ps(p, v), _mm_set1_ps(kExpP2));
+    p = _mm_add_ps(_mm_mul_ps(p, v), _mm_set1_ps(kExpP3));
+    p = _mm_add_ps(_mm_mul_ps(p, v), _mm_set1_ps(kExpP4));
+    p = _mm_add_ps(_mm_mul_ps(p, v), _mm_set1_ps(kExpP5));
+    p = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, z), v), one);
+
+    __m128i bits = _mm_slli_epi32(
+        _mm_add_epi32(_mm_cvttps_epi32(exponent), _mm_set1_epi32(127)),
+        23);
+    _mm_storeu_ps(y + i, _mm_mul_ps(p, _mm_castsi128_ps(bits)));
+  }
+  ExpRange(y, x, bias, i, n);
+}
+
+__attribute__((target("avx2")))
+void AddRowsAVX2(float *cost,
+                 const float *cost_data,
+                 const int *offsets,
+                 int offset_num,
+                 int tag_num) {
+  int tag = 0;
+  for (; tag + 8 <= tag_num; tag += 8) {
+    __m256 tag_cost = _mm256_loadu_ps(cost + tag);
+    for (int i = 0; i < offset_num; ++i) {
+      tag_cost = _mm256_add_ps(tag_cost,
+                               _mm256_loadu_ps(cost_data + offsets[i] + tag));
+    }
+    _mm256_storeu_ps(cost + tag, tag_cost);
+  }
+  AddRowsRange(cost, cost_data, offsets, offset_num, tag, tag_num);
+}
+
+__attribute__((target("avx2")))
+void MaxPlusArcAVX2(float *cost,
+                    int *left_tag,
+                    const float *left_cost,
+                    const float *cost_data,
+                    const int *offsets,
+                    int offset_num,
+                    int tag_num) {
+  int right = 0;
+  for (; right + 8 <= tag_num; right += 8) {
+    __m256 best_cost = _mm256_set1_ps(kMinCost);
+    __m256 best_left = _mm256_castsi256_ps(_mm256_setzero_si256());
+    for (int left = 0; left < tag_num; ++left) {
+      const float *row = cost_data + left * tag_num + right;
+      __m256 arc_cost = _mm256_set1_ps(left_cost[left]);
+      for (int i = 0; i < offset_num; ++i) {
+        arc_cost = _mm256_add_ps(arc_cost, _mm256_loadu_ps(row + offsets[i]));
+      }
+
+      __m256 greater = _mm256_cmp_ps(arc_cost, best_cost, _CMP_GT_OQ);
+      __m256 left_vec = _mm256_castsi256_ps(_mm256_set1_epi32(left));
+      best_cost = _mm256_blendv_ps(best_cost, arc_cost, greater);
+      best_left = _mm256_blendv_ps(best_left, left_vec, greater);
+    }
+    _mm256_storeu_ps(cost + right, best_cost);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(left_tag + right),
+                        _mm256_castps_si256(best_left));
+  }
+  MaxPlusArcRange(cost,
+                  left_tag,
+                  left_cost,
+                  cost_data,
+                  offsets,
+                  offset_num,
+                  tag_num,
+                  right,
+                  tag_num);
+}
+
+// The candidates are gathered 8 at a time with a masked tail. Gathering is
+// slower than the scalar loop for less than 4 candidates, so the last 1 to 3
+// candidates are left to the scalar loop
+__attribute__((target("avx2")))
+void MinPlusTransAVX2(float *cost,
+                      int *context,
+                      const float *context_cost,
+                      const float *const *trans_rows,
+                      int context_num,
+                      const int *tags,
+                      int tag_num) {
+  const __m256i iota = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  int j = 0;
+  for (; j + 4 <= tag_num; j += 8) {
+    __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(tag_num - j), iota);
+    __m256i tag = _mm256_maskload_epi32(tags + j, mask);
+
+    __m256 best_cost = _mm256_add_ps(
+        _mm256_set1_ps(context_cost[0]),
+        _mm256_mask_i32gather_ps(_mm256_setzero_ps(),
+                                 trans_rows[0],
+                                 tag,
+                                 _mm256_castsi256_ps(mask),
+                                 4));
+    __m256 best_context = _mm256_castsi256_ps(_mm256_setzero_si256());
+    for (int i = 1; i < context_num; ++i) {
+      __m256 arc_cost = _mm256_add_ps(
+          _mm256_set1_ps(context_cost[i]),
+          _mm256_mask_i32gather_ps(_mm256_setzero_ps(),
+                                   trans_rows[i],
+                                   tag,
+                                   _mm256_castsi256_ps(mask),
+                                   4));
+      __m256 less = _mm256_cmp_ps(arc_cost, best_cost, _CMP_LT_OQ);
+      __m256 context_vec = _mm256_castsi256_ps(_mm256_set1_epi32(i));
+      best_cost = _mm256_blendv_ps(best_cost, arc_cost, less);
+      best_context = _mm256_blendv_ps(best_context, context_vec, less);
+    }
+    _mm256_maskstore_ps(cost + j, mask, best_cost);
+    _mm256_maskstore_epi32(context + j,
+                           mask,
+                           _mm256_castps_si256(best_context));
+  }
+  MinPlusTransRange(cost,
+                    context,
+                    context_cost,
+                    trans_rows,
+                    context_num,
+                    tags,
+                    j,
+                    tag_num);
+}
+
+__attribute__((target("avx2")))
+void ExpAVX2(float *y, const float *x, float bias, int n) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_set1_ps(bias));
+    v = _mm256_min_ps(v, _mm256_set1_ps(kExpMax));
+    v = _mm256_max_ps(v, _mm256_set1_ps(kExpMin));
+
+    // Not using _mm256_floor_ps here to keep the same operations as the
+    // scalar and SSE kernel
+    __m256 fx = _mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(kExpLog2e)),
+                              _mm256_set1_ps(0.5f));
+    __m256 exponent = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(fx));
+    __m256 greater = _mm256_cmp_ps(exponent, fx, _CMP_GT_OQ);
+    exponent = _mm256_sub_ps(exponent, _mm256_and_ps(greater, one));
+
+    v = _mm256_sub_ps(v, _mm256_mul_ps(exponent, _mm256_set1_ps(kExpC1)));
+    v = _mm256_sub_ps(v, _mm256_mul_ps(exponent, _mm256_set1_ps(kExpC2)));
+    __m256 z = _mm256_mul_ps(v, v);
+    __m256 p = _mm256_set1_ps(kExpP0);
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(kExpP1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(kExpP2));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(kExpP3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(kExpP4));
+    p = _mm256_add_ps(_mm256_mul_ps(p, v), _mm256_set1_ps(kExpP5));
+    p = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(p, z), v), one);
+
+    __m256i bits = _mm256_slli_epi32(
+        _mm256_add_epi32(_mm256_cvttps_epi32(exponent), _mm256_set1_epi32(127)),
+        23);
+    _mm256_storeu_ps(y + i, _mm256_mul_ps(p, _mm256_castsi256_ps(bits)));
+  }
+  ExpRange(y, x, bias, i, n);
+}
+
+// The lanes in kSimdLaneNum are exactly a __m256
+static_assert(kSimdLaneNum == 8, "AVX2 lane kernels need 8 lanes");
+
+// Maximal number of the bigram features in broadcast lane kernel
+constexpr int kMaxLaneFeature = 32;
+
+// Returns true if offsets[i][lane] are the same for all lanes and there are
+// at most kMaxLaneFeature of them
+inline bool SameOffsetInLanes(const int *offsets, int offset_num) {
+  if (offset_num > kMaxLaneFeature) return false;
+  for (int i = 0; i < offset_num; ++i) {
+    for (int lane = 1; lane < kSimdLaneNum; ++lane) {
+      if (offsets[i * kSimdLaneNum + lane] != offsets[i * kSimdLaneNum]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Number of right tags processed together in LaneMaxPlusArcBroadcastAVX2.
+// The maximum of each right tag is a dependency chain of compare and blend,
+// interleaving the right tags makes the chains run in parallel
+constexpr int kRightBlock = 4;
+
+__attribute__((target("avx2")))
+void LaneMaxPlusArcBroadcastAVX2(float *cost,
+                                 int *left_tag,
+                                 const float *left_cost,
+                                 const float *cost_data,
+                                 const int *offsets,
+                                 int offset_num,
+                                 int tag_num) {
+  int feature_offsets[kMaxLaneFeature], feature_num = 0;
+  for (int i = 0; i < offset_num; ++i) {
+    if (offsets[i * kSimdLaneNum] >= 0) {
+      feature_offsets[feature_num++] = offsets[i * kSimdLaneNum];
+    }
+  }
+
+  int right = 0;
+  for (; right + kRightBlock <= tag_num; right += kRightBlock) {
+    __m256 best_cost[kRightBlock], best_left[kRightBlock];
+    for (int k = 0; k < kRightBlock; ++k) {
+      best_cost[k] = _mm256_set1_ps(kMinCost);
+      best_left[k] = _mm256_castsi256_ps(_mm256_setzero_si256());
+    }
+    for (int left = 0; left < tag_num; ++left) {
+      __m256 left_vec = _mm256_castsi256_ps(_mm256_set1_epi32(left));
+      __m256 left_cost_vec = _mm256_loadu_ps(left_cost + left * kSimdLaneNum);
+      __m256 arc_cost[kRightBlock];
+      for (int k = 0; k < kRightBlock; ++k) arc_cost[k] = left_cost_vec;
+      for (int i = 0; i < feature_num; ++i) {
+        const float *row = cost_data + feature_offsets[i] + left * tag_num;
+        for (int k = 0; k < kRightBlock; ++k) {
+          arc_cost[k] = _mm256_add_ps(arc_cost[k],
+                                      _mm256_set1_ps(row[right + k]));
+        }
+      }
+      for (int k = 0; k < kRightBlock; ++k) {
+        __m256 greater = _mm256_cmp_ps(arc_cost[k], best_cost[k], _CMP_GT_OQ);
+        best_cost[k] = _mm256_blendv_ps(best_cost[k], arc_cost[k], greater);
+        best_left[k] = _mm256_blendv_ps(best_left[k], left_vec, greater);
+      }
+    }
+    for (int k = 0; k < kRightBlock; ++k) {
+      _mm256_storeu_ps(cost + (right + k) * kSimdLaneNum, best_cost[k]);
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i *>(left_tag + (right + k) * kSimdLaneNum),
+          _mm256_castps_si256(best_left[k]));
+    }
+  }
+
+  for (; right < tag_num; ++right) {
+    __m256 best_cost = _mm256_set1_ps(kMinCost);
+    __m256 best_left = _mm256_castsi256_ps(_mm256_setzero_si256());
+    for (int left = 0; left < tag_num; ++left) {
+      __m256 arc_cost = _mm256_loadu_ps(left_cost + left * kSimdLaneNum);
+      for (int i = 0; i < feature_num; ++i) {
+        const float *row = cost_data + feature_offsets[i] + left * tag_num;
+        arc_cost = _mm256_add_ps(arc_cost, _mm256_set1_ps(row[right]));
+      }
+
+      __m256 greater = _mm256_cmp_ps(arc_cost, best_cost, _CMP_GT_OQ);
+      __m256 left_vec = _mm256_castsi256_ps(_mm256_set1_epi32(left));
+      best_cost = _mm256_blendv_ps(best_cost, arc_cost, greater);
+      best_left = _mm256_blendv_ps(best_left, left_vec, greater);
+    }
+    _mm256_storeu_ps(cost + right * kSimdLaneNum, best_cost);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(left_tag + right * kSimdLaneNum),
+        _mm256_castps_si256(best_left));
+  }
+}
+
+// The costs of lanes are loaded by masked gather
+__attribute__((target("avx2")))
+void LaneMaxPlusArcAVX2(float *cost,
+                        int *left_tag,
+                        const float *left_cost,
+                        const float *cost_data,
+                        const int *offsets,
+                        int offset_num,
+                        int tag_num) {
+  // If the offsets are the same in all lanes, which is the usual case since
+  // the bigram template is often just "B", the transition costs are
+  // broadcasted instead of gathered
+  if (SameOffsetInLanes(offsets, offset_num)) {
+    LaneMaxPlusArcBroadcastAVX2(cost,
+                                left_tag,
+                                left_cost,
+                                cost_data,
+                                offsets,
+                                offset_num,
+                                tag_num);
+    return;
+  }
+
+  const __m256i minus_one = _mm256_set1_epi32(-1);
+  const __m256 zero = _mm256_setzero_ps();
+  for (int right = 0; right < tag_num; ++right) {
+    __m256 best_cost = _mm256_set1_ps(kMinCost);
+    __m256 best_left = _mm256_castsi256_ps(_mm256_setzero_si256());
+    for (int left = 0; left < tag_num; ++left) {
+      __m256 arc_cost = _mm256_loadu_ps(left_cost + left * kSimdLaneNum);
+      __m256i cell = _mm256_set1_epi32(left * tag_num + right);
+      for (int i = 0; i < offset_num; ++i) {
+        __m256i offset = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(offsets + i * kSimdLaneNum));
+        __m256 mask = _mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(offset, minus_one));
+        __m256 transition_cost = _mm256_mask_i32gather_ps(
+            zero,
+            cost_data,
+            _mm256_add_epi32(offset, cell),
+            mask,
+            4);
+        arc_cost = _mm256_add_ps(arc_cost, transition_cost);
+      }
+
+      __m256 greater = _mm256_cmp_ps(arc_cost, best_cost, _CMP_GT_OQ);
+      __m256 left_vec = _mm256_castsi256_ps(_mm256_set1_epi32(left));
+      best_cost = _mm256_blendv_ps(best_cost, arc_cost, greater);
+      best_left = _mm256_blendv_ps(best_left, left_vec, greater);
+    }
+    _mm256_storeu_ps(cost + right * kSimdLaneNum, best_cost);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(left_tag + right * kSimdLaneNum),
+        _mm256_castps_si256(best_left));
+  }
+}
+
+#endif  // MILKCAT_X86_SIMD
+
+const SimdKernel kScalarKernel = {
+  "scalar",
+  AddRowsScalar,
+  MaxPlusArcScalar,
+  ExpScalar,
+  LaneMaxPlusArcScalar,
+  MinPlusTransScalar
+};
+
+#ifdef MILKCAT_X86_SIMD
+const SimdKernel kSSEKernel = {
+  "sse",
+  AddRowsSSE,
+  MaxPlusArcSSE,
+  ExpSSE,
+  // SSE has no gather instruction, the lanes and the candidate tags of
+  // min_plus_trans are processed in scalar
+  LaneMaxPlusArcScalar,
+  MinPlusTransScalar
+};
+
+const SimdKernel kAVX2Kernel = {
+  "avx2",
+  AddRowsAVX2,
+  MaxPlusArcAVX2,
+  ExpAVX2,
+  LaneMaxPlusArcAVX2,
+  MinPlusTransAVX2
+};
+#endif  // MILKCAT_X86_SIMD
+
+// Selects the kernel from environment variable MILKCAT_SIMD or the fastest
+// one supported by CPU
+const SimdKernel *SelectKernel() {
+  const char *name = getenv("MILKCAT_SIMD");
+  const SimdKernel *kernel = nullptr;
+  if (name != nullptr) kernel = GetSimdKernel(name);
+
+  if (kernel == nullptr) kernel = GetSimdKernel("avx2");
+  if (kernel == nullptr) kernel = GetSimdKernel("sse");
+  if (kernel == nullptr) kernel = &kScalarKernel;
+
+  return kernel;
+}
+
+}  // namespace
+
+const SimdKernel *GetSimdKernel(const char *name) {
+  if (strcmp(name, kScalarKernel.name) == 0) return &kScalarKernel;
+
+#ifdef MILKCAT_X86_SIMD
+  __builtin_cpu_init();
+  if (strcmp(name, kSSEKernel.name) == 0 && __builtin_cpu_supports("sse2"))
+    return &kSSEKernel;
+  if (strcmp(name, kAVX2Kernel.name) == 0 && __builtin_cpu_supports("avx2"))
+    return &kAVX2Kernel;
+#endif  // MILKCAT_X86_SIMD
+
+  return nullptr;
+}
+
+const SimdKernel *GetSimdKernel() {
+  static const SimdKernel *kernel = SelectKernel();
+  return kernel;
+}
+
+}  // namespace milkcat
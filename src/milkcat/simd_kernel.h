@@ -0,0 +1,111 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// simd_kernel.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_MILKCAT_SIMD_KERNEL_H_
+#define SRC_MILKCAT_SIMD_KERNEL_H_
+
+namespace milkcat {
+
+// Number of lanes, that is the number of sentences decoded together, in the
+// lane-batched kernels
+const int kSimdLaneNum = 8;
+
+// SimdKernel is a table of the vectorized inner loops used by the decoders.
+// The kernels are implemented in AVX2, SSE and plain C++, the best one
+// supported by current CPU is selected at runtime. All implementations do the
+// same float operations in the same order, so the results of them are
+// exactly equal.
+struct SimdKernel {
+  // Name of the kernel, "avx2", "sse" or "scalar"
+  const char *name;
+
+  // Adds the cost rows to cost. For each tag in [0, tag_num):
+  //   cost[tag] += cost_data[offsets[0] + tag] + ... +
+  //                cost_data[offsets[offset_num - 1] + tag]
+  void (* add_rows)(float *cost,
+                    const float *cost_data,
+                    const int *offsets,
+                    int offset_num,
+                    int tag_num);
+
+  // The max-plus update of the transition in Viterbi decoding. The transition
+  // cost of the feature at offset is cost_data[offset + left * tag_num +
+  // right]. For each right tag, stores the maximum of
+  //   left_cost[left] + (sum of transition costs from left to right)
+  // into cost[right] and the left tag of maximum into left_tag[right]
+  void (* max_plus_arc)(float *cost,
+                        int *left_tag,
+                        const float *left_cost,
+                        const float *cost_data,
+                        const int *offsets,
+                        int offset_num,
+                        int tag_num);
+
+  // Computes y[i] = exp(x[i] + bias) for i in [0, n). It uses the Cephes
+  // polynomial approximation whose relative error is about 2e-7 in single
+  // precision. Results of x[i] + bias below -87.3 are flushed to about 0.
+  void (* exp)(float *y, const float *x, float bias, int n);
+
+  // The lane-batched version of max_plus_arc, kSimdLaneNum sentences are
+  // processed together. cost, left_tag and left_cost are laid out as
+  // [tag][lane] and offsets as [offset_index][lane], a negative offset means
+  // no feature for the lane
+  void (* lane_max_plus_arc)(float *cost,
+                             int *left_tag,
+                             const float *left_cost,
+                             const float *cost_data,
+                             const int *offsets,
+                             int offset_num,
+                             int tag_num);
+
+  // The min-plus update of the trigram transition in HMM decoding. Each
+  // context i in [0, context_num) is a (leftleft, left) tag pair whose
+  // transition cost to right tag is trans_rows[i][right]. For each candidate
+  // j in [0, tag_num), stores the minimum of
+  //   context_cost[i] + trans_rows[i][tags[j]]
+  // into cost[j] and the context i of minimum into context[j]. The smallest i
+  // wins on ties. context_num should be at least 1
+  void (* min_plus_trans)(float *cost,
+                          int *context,
+                          const float *context_cost,
+                          const float *const *trans_rows,
+                          int context_num,
+                          const int *tags,
+                          int tag_num);
+};
+
+// Get the fastest kernel supported by current CPU. The kernel could be
+// overridden by the environment variable MILKCAT_SIMD ("avx2", "sse" or
+// "scalar")
+const SimdKernel *GetSimdKernel();
+
+// Get the kernel by its name. Returns nullptr if the kernel doesn't exist or
+// current CPU doesn't support it
+const SimdKernel *GetSimdKernel(const char *name);
+
+}  // namespace milkcat
+
+#endif  // SRC_MILKCAT_SIMD_KERNEL_H_
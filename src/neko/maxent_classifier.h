@@ -55,6 +55,11 @@ class MaxentModel {
     return cost_[feature_id * ysize_ + yid];
   }
 
+  // Get the costs of a feature with all y-tags, indexed by yid
+  const float *cost_row(int feature_id) const {
+    return cost_ + feature_id * ysize_;
+  }
+
   // If the feature_str not exists in feature set, use this value instead
   static constexpr int kFeatureIdNone = -1;
   static constexpr int kYNameMax = 64;
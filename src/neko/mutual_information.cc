@@ -40,16 +40,17 @@ namespace milkcat {
 std::unordered_map<std::string, double> GetMutualInformation(
     const std::unordered_map<std::string, int> &bigram_vocab,
     const std::unordered_map<std::string, float> &candidate,
-    Status *status) {
+    Status *status,
+    int64_t total_frequency) {
 
   char line[1024];
   std::unordered_map<std::string, double> mutual_information;
 
   // Calculate total_frequency and frequency of candidate words
   std::unordered_map<std::string, int> candidate_frequencies;
-  int total_frequency = 0;
+  bool sum_frequency = total_frequency == 0;
   for (auto &x : bigram_vocab) {
-    total_frequency += x.second;
+    if (sum_frequency) total_frequency += x.second;
     auto it = candidate.find(x.first);
     if (it != candidate.end()) {
       candidate_frequencies[x.first] = x.second;
@@ -27,16 +27,21 @@
 #ifndef SRC_NEKO_MUTUAL_INFORMATION_H_
 #define SRC_NEKO_MUTUAL_INFORMATION_H_
 
+#include <stdint.h>
 #include <unordered_map>
 #include <string>
 #include "utils/status.h"
 
 namespace milkcat {
 
+// Calculates the mutual information of candidates from the vocabulary of
+// bigram segmentation. total_frequency is the total count of words, 0 for the
+// sum of frequencies in bigram_vocab
 std::unordered_map<std::string, double> GetMutualInformation(
     const std::unordered_map<std::string, int> &bigram_vocab,
     const std::unordered_map<std::string, float> &candidate,
-    Status *status);
+    Status *status,
+    int64_t total_frequency = 0);
 
 }  // namespace milkcat
 
@@ -0,0 +1,74 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// new_word_stats.cc --- Created at 2026-10-19
+//
+
+#include "neko/new_word_stats.h"
+#include <stdio.h>
+#include <unordered_map>
+#include <string>
+#include "milkcat/milkcat_config.h"
+#include "utils/readable_file.h"
+#include "utils/status.h"
+
+namespace milkcat {
+
+void ReadNewWordStatistics(
+    const char *path,
+    std::unordered_map<std::string, int> *vocab,
+    std::unordered_map<std::string, double> *adjacent_entropy,
+    int64_t *total_count,
+    Status *status) {
+  char line[1024], word[kTermLengthMax], errmsg[1024];
+  ReadableFile *fd = ReadableFile::New(path, status);
+
+  long long count = 0;
+  if (status->ok()) {
+    fd->ReadLine(line, sizeof(line), status);
+    if (status->ok() && sscanf(line, "%lld", &count) != 1) {
+      snprintf(errmsg, sizeof(errmsg), "bad new word statistics %s", path);
+      *status = Status::Corruption(errmsg);
+    }
+    *total_count = count;
+  }
+
+  int frequency;
+  double entropy;
+  while (status->ok() && !fd->Eof()) {
+    fd->ReadLine(line, sizeof(line), status);
+    if (!status->ok()) break;
+
+    if (sscanf(line, "%99s %d %lf", word, &frequency, &entropy) != 3) {
+      snprintf(errmsg, sizeof(errmsg), "bad new word statistics %s", path);
+      *status = Status::Corruption(errmsg);
+      break;
+    }
+    vocab->emplace(word, frequency);
+    adjacent_entropy->emplace(word, entropy);
+  }
+
+  delete fd;
+}
+
+}  // namespace milkcat
@@ -0,0 +1,50 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// new_word_stats.h --- Created at 2026-10-19
+//
+
+#ifndef SRC_NEKO_NEW_WORD_STATS_H_
+#define SRC_NEKO_NEW_WORD_STATS_H_
+
+#include <stdint.h>
+#include <unordered_map>
+#include <string>
+#include "utils/status.h"
+
+namespace milkcat {
+
+// Read the statistics of new words exported by
+// milkcat_model_export_new_words from path. Stores the frequencies of words
+// in vocab, their adjacent entropies in adjacent_entropy and the total count
+// of words in total_count. On failed set status != Status::OK()
+void ReadNewWordStatistics(
+    const char *path,
+    std::unordered_map<std::string, int> *vocab,
+    std::unordered_map<std::string, double> *adjacent_entropy,
+    int64_t *total_count,
+    Status *status);
+
+}  // namespace milkcat
+
+#endif  // SRC_NEKO_NEW_WORD_STATS_H_
@@ -34,6 +34,7 @@
 #include "neko/crf_vocab.h"
 #include "neko/bigram_anal.h"
 #include "neko/mutual_information.h"
+#include "neko/new_word_stats.h"
 #include "neko/final_rank.h"
 #include "utils/utils.h"
 #include "utils/writable_file.h"
@@ -59,10 +60,11 @@ int main(int argc, char **argv) {
   int total_count = 0;
   char errmsg[1024],
        vocabulary_file[1024] = "",
+       statistics_file[1024] = "",
        output_file[1024] = "";
   int c;
 
-  while ((c = getopt(argc, argv, "u:o:")) != -1) {
+  while ((c = getopt(argc, argv, "u:o:c:")) != -1) {
     switch (c) {
       case 'u':
         strlcpy(vocabulary_file, optarg, sizeof(errmsg));
@@ -72,6 +74,10 @@ int main(int argc, char **argv) {
         strlcpy(output_file, optarg, sizeof(errmsg));
         break;
 
+      case 'c':
+        strlcpy(statistics_file, optarg, sizeof(errmsg));
+        break;
+
       case ':':
         sprintf(errmsg, "Option -%c requires an operand", optopt);
         status = Status::Info(errmsg);
@@ -84,9 +90,23 @@ int main(int argc, char **argv) {
     }
   }
 
-  printf("Segment corpus %s with CRF model.\n", argv[optind]);
+  // With -c, the frequencies and adjacent entropies of new words are read
+  // from the statistics collected by milkcat_model_set_new_word_collector
+  // while serving, so that the corpus passes are skipped
+  bool use_statistics = *statistics_file != '\0';
   std::unordered_map<std::string, int> vocab;
-  if (status.ok()) {
+  std::unordered_map<std::string, double> collected_entropy;
+  int64_t collected_total = 0;
+  if (status.ok() && use_statistics) {
+    printf("Read new word statistics from %s.\n", statistics_file);
+    ReadNewWordStatistics(statistics_file,
+                          &vocab,
+                          &collected_entropy,
+                          &collected_total,
+                          &status);
+    total_count = collected_total;
+  } else if (status.ok()) {
+    printf("Segment corpus %s with CRF model.\n", argv[optind]);
     vocab = GetCrfVocabulary(
         argv[optind],
         &total_count,
@@ -132,13 +152,17 @@ int main(int argc, char **argv) {
 
   delete fd;
 
-  // Clear the vocab
-  vocab = std::unordered_map<std::string, int>();
-
   std::unordered_map<std::string, double> adjacent_entropy;
   std::unordered_map<std::string, double> mutual_information;
 
-  if (status.ok()) {
+  if (status.ok() && use_statistics) {
+    for (auto &x : candidates) {
+      adjacent_entropy[x.first] = collected_entropy[x.first];
+    }
+  } else if (status.ok()) {
+    // Clear the vocab
+    vocab = std::unordered_map<std::string, int>();
+
     printf("Analyze %s with bigram segmentation.\n", argv[optind]);
     BigramAnalyze(candidates,
                   argv[optind],
@@ -163,7 +187,10 @@ int main(int argc, char **argv) {
 
   if (status.ok()) {
     printf("Calculate mutual information.\n");
-    mutual_information = GetMutualInformation(vocab, candidates, &status);
+    mutual_information = GetMutualInformation(vocab,
+                                              candidates,
+                                              &status,
+                                              collected_total);
   }
 
   if (status.ok()) {